@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LibraryDelta_TEST.h"
+#include "unittest.h"
+#include "TestHelpers.h"
+
+#include "LibraryDelta.h"
+#include "MessageFactory/Message.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <sstream>
+#include <assert.h>
+#include <time.h>
+
+using namespace LibSpotify;
+
+namespace Test
+{
+
+/* what a client keeps of the root folder: names and links of the playlists in
+ * each folder, depth first, and the track links of each playlist */
+class ClientLibrary
+{
+public:
+	std::vector<std::vector<std::pair<std::string, std::string> > > folders_;
+	std::map<std::string, std::vector<std::string> > tracks_;
+
+	void add(const Folder& folder)
+	{
+		folders_.push_back(std::vector<std::pair<std::string, std::string> >());
+		size_t f = folders_.size() - 1;
+		for (FolderContainer::const_iterator it = folder.getFolders().begin(); it != folder.getFolders().end(); it++)
+			add(*it);
+		for (PlaylistContainer::const_iterator it = folder.getPlaylists().begin(); it != folder.getPlaylists().end(); it++)
+		{
+			folders_[f].push_back(std::make_pair(it->getName(), it->getLink()));
+			std::vector<std::string>& tracks = tracks_[it->getLink()];
+			tracks.clear();
+			for (std::deque<Track>::const_iterator t = it->getTracks().begin(); t != it->getTracks().end(); t++)
+				tracks.push_back(t->getLink());
+		}
+	}
+
+	ClientLibrary(const Folder& root) { add(root); }
+
+	/* added playlists come without tracks, they are fetched from fetchFrom */
+	void apply(const std::vector<LibraryChange>& changes, const Folder& fetchFrom)
+	{
+		ClientLibrary fetched(fetchFrom);
+		for (std::vector<LibraryChange>::const_iterator it = changes.begin(); it != changes.end(); it++)
+		{
+			std::vector<std::pair<std::string, std::string> >& folder = folders_[it->getFolder()];
+			std::vector<std::string>& tracks = tracks_[it->getLink()];
+			switch (it->getType())
+			{
+				case CHANGE_PLAYLIST_ADDED:
+					assert(it->getPosition() <= folder.size());
+					folder.insert(folder.begin() + it->getPosition(), std::make_pair(it->getName(), it->getLink()));
+					tracks = fetched.tracks_[it->getLink()];
+					break;
+				case CHANGE_PLAYLIST_REMOVED:
+					assert(folder.at(it->getPosition()).second == it->getLink());
+					folder.erase(folder.begin() + it->getPosition());
+					break;
+				case CHANGE_PLAYLIST_RENAMED:
+					assert(folder.at(it->getPosition()).second == it->getLink());
+					folder[it->getPosition()].first = it->getName();
+					break;
+				case CHANGE_PLAYLIST_MOVED:
+				{
+					assert(folder.at(it->getPosition()).second == it->getLink());
+					std::pair<std::string, std::string> moved = folder[it->getPosition()];
+					folder.erase(folder.begin() + it->getPosition());
+					std::vector<std::pair<std::string, std::string> >& to = folders_[it->getToFolder()];
+					assert(it->getToPosition() <= to.size());
+					to.insert(to.begin() + it->getToPosition(), moved);
+					break;
+				}
+				case CHANGE_TRACKS_INSERTED:
+				{
+					assert(it->getPosition() <= tracks.size());
+					std::vector<std::string> links;
+					for (std::deque<Track>::const_iterator t = it->getTracks().begin(); t != it->getTracks().end(); t++)
+						links.push_back(t->getLink());
+					tracks.insert(tracks.begin() + it->getPosition(), links.begin(), links.end());
+					break;
+				}
+				case CHANGE_TRACKS_REMOVED:
+					assert(it->getPosition() + it->getCount() <= tracks.size());
+					tracks.erase(tracks.begin() + it->getPosition(), tracks.begin() + it->getPosition() + it->getCount());
+					break;
+			}
+		}
+	}
+
+	/* tracks of playlists that are gone don't matter */
+	bool operator==(const ClientLibrary& rhs) const
+	{
+		if (folders_ != rhs.folders_)
+			return false;
+		for (size_t f = 0; f < folders_.size(); f++)
+		{
+			for (size_t i = 0; i < folders_[f].size(); i++)
+			{
+				const std::string& link = folders_[f][i].second;
+				if (tracks_.find(link)->second != rhs.tracks_.find(link)->second)
+					return false;
+			}
+		}
+		return true;
+	}
+};
+
+static Playlist makePlaylist(const std::string& name, const std::string& link, unsigned int firstTrack, unsigned int tracks)
+{
+	Playlist playlist(name, link);
+	for (unsigned int i = firstTrack; i < firstTrack + tracks; i++)
+	{
+		std::ostringstream trackLink;
+		trackLink << "spotify:track:" << i;
+		Track track(trackLink.str(), trackLink.str());
+		playlist.addTrack(track);
+	}
+	return playlist;
+}
+
+static Playlist withTracks(const std::string& name, const std::string& link, const std::vector<unsigned int>& tracks)
+{
+	Playlist playlist(name, link);
+	for (size_t i = 0; i < tracks.size(); i++)
+	{
+		std::ostringstream trackLink;
+		trackLink << "spotify:track:" << tracks[i];
+		Track track(trackLink.str(), trackLink.str());
+		playlist.addTrack(track);
+	}
+	return playlist;
+}
+
+static void checkDiff(const Folder& from, const Folder& to)
+{
+	std::vector<LibraryChange> changes;
+	bool diffed = diffRootFolders(from, to, changes);
+	assert(diffed);
+
+	ClientLibrary client(from);
+	client.apply(changes, to);
+	assert(client == ClientLibrary(to));
+
+	/* and through the tlvs, as a client gets them */
+	ClientLibrary decoded(from);
+	std::vector<LibraryChange> received;
+	for (std::vector<LibraryChange>::const_iterator it = changes.begin(); it != changes.end(); it++)
+	{
+		Tlv* tlv = it->toTlv();
+		received.push_back(LibraryChange((const TlvContainer*) tlv));
+		delete tlv;
+	}
+	decoded.apply(received, to);
+	assert(decoded == ClientLibrary(to));
+}
+
+static bool ut_testPlaylistChanges()
+{
+	Folder from("root", 0, 0);
+	Folder fromSub("sub", 1, &from);
+	Playlist a = makePlaylist("A", "spotify:playlist:a", 0, 3);
+	Playlist b = makePlaylist("B", "spotify:playlist:b", 10, 3);
+	Playlist c = makePlaylist("C", "spotify:playlist:c", 20, 3);
+	Playlist d = makePlaylist("D", "spotify:playlist:d", 30, 3);
+	Playlist e = makePlaylist("E", "spotify:playlist:e", 40, 3);
+	fromSub.addPlaylist(d);
+	from.addFolder(fromSub);
+	from.addPlaylist(a);
+	from.addPlaylist(b);
+	from.addPlaylist(c);
+	from.addPlaylist(a);
+
+	/* b renamed, c moved into sub, d moved out of it, the second a removed, e added */
+	Folder to("root", 0, 0);
+	Folder toSub("sub", 1, &to);
+	Playlist renamed = makePlaylist("B2", "spotify:playlist:b", 10, 3);
+	toSub.addPlaylist(c);
+	toSub.addPlaylist(e);
+	to.addFolder(toSub);
+	to.addPlaylist(d);
+	to.addPlaylist(a);
+	to.addPlaylist(renamed);
+	checkDiff(from, to);
+
+	std::vector<LibraryChange> changes;
+	diffRootFolders(from, to, changes);
+	unsigned int counts[CHANGE_TRACKS_REMOVED + 1] = { 0 };
+	for (size_t i = 0; i < changes.size(); i++)
+		counts[changes[i].getType()]++;
+	assert(counts[CHANGE_PLAYLIST_ADDED] == 1);
+	assert(counts[CHANGE_PLAYLIST_REMOVED] == 1);
+	assert(counts[CHANGE_PLAYLIST_RENAMED] == 1);
+	assert(counts[CHANGE_TRACKS_INSERTED] == 0);
+	assert(counts[CHANGE_TRACKS_REMOVED] == 0);
+
+	/* and back */
+	checkDiff(to, from);
+
+	/* nothing */
+	changes.clear();
+	bool diffed = diffRootFolders(from, from, changes);
+	assert(diffed);
+	assert(changes.empty());
+	return true;
+}
+
+static bool ut_testTrackChanges()
+{
+	unsigned int before[] = { 1, 2, 3, 4, 5, 6 };
+	unsigned int after[] = { 1, 2, 7, 8, 5, 6, 9 };
+	Folder from("root", 0, 0);
+	Playlist p = withTracks("P", "spotify:playlist:p", std::vector<unsigned int>(before, before + 6));
+	from.addPlaylist(p);
+	Folder to("root", 0, 0);
+	Playlist q = withTracks("P", "spotify:playlist:p", std::vector<unsigned int>(after, after + 7));
+	to.addPlaylist(q);
+
+	checkDiff(from, to);
+	checkDiff(to, from);
+
+	/* 3 and 4 out, 7 and 8 in, everything from there on counts as changed */
+	std::vector<LibraryChange> changes;
+	diffRootFolders(from, to, changes);
+	assert(changes.size() == 2);
+	assert(changes[0].getType() == CHANGE_TRACKS_REMOVED);
+	assert(changes[0].getPosition() == 2 && changes[0].getCount() == 4);
+	assert(changes[1].getType() == CHANGE_TRACKS_INSERTED);
+	assert(changes[1].getTracks().size() == 5);
+	assert(changes[1].getVersion() == Playlist::getTracksVersion(q.getTracks()));
+
+	/* an appended track is just that */
+	unsigned int appended[] = { 1, 2, 3, 4, 5, 6, 9 };
+	Folder more("root", 0, 0);
+	Playlist r = withTracks("P", "spotify:playlist:p", std::vector<unsigned int>(appended, appended + 7));
+	more.addPlaylist(r);
+	changes.clear();
+	diffRootFolders(from, more, changes);
+	assert(changes.size() == 1);
+	assert(changes[0].getPosition() == 6 && changes[0].getTracks().size() == 1);
+	return true;
+}
+
+static bool ut_testFolderChangeResyncs()
+{
+	Folder from("root", 0, 0);
+	Playlist a = makePlaylist("A", "spotify:playlist:a", 0, 3);
+	from.addPlaylist(a);
+
+	Folder to("root", 0, 0);
+	Folder sub("sub", 1, &to);
+	to.addFolder(sub);
+	to.addPlaylist(a);
+
+	std::vector<LibraryChange> changes;
+	bool diffed = diffRootFolders(from, to, changes);
+	assert(!diffed);
+	assert(changes.empty());
+
+	Folder renamed("root", 0, 0);
+	Folder other("other", 1, &renamed);
+	renamed.addFolder(other);
+	renamed.addPlaylist(a);
+	diffed = diffRootFolders(to, renamed, changes);
+	assert(!diffed);
+	return true;
+}
+
+static unsigned int encodedSize(Tlv* tlv)
+{
+	Message msg(LIBRARY_CHANGED_IND);
+	msg.addTlv(tlv);
+	MessageEncoder* encoder = msg.encode();
+	unsigned int size = encoder->getLength();
+	delete encoder;
+	return size;
+}
+
+/* one track added to one playlist of a big library */
+static bool ut_benchmarkSingleEdit()
+{
+	const unsigned int playlists = 1000;
+	const unsigned int tracksPerPlaylist = 100;
+
+	Folder from("root", 0, 0);
+	for (unsigned int pl = 0; pl < playlists; pl++)
+	{
+		std::ostringstream link;
+		link << "spotify:user:u:playlist:" << pl;
+		Playlist playlist = makePlaylist(link.str(), link.str(), pl * tracksPerPlaylist, tracksPerPlaylist);
+		from.addPlaylist(playlist);
+	}
+
+	Folder to(from);
+	Playlist& edited = to.getPlaylists()[playlists / 2];
+	Playlist copy = makePlaylist(edited.getName(), edited.getLink(), (playlists / 2) * tracksPerPlaylist, tracksPerPlaylist);
+	Track added("new", "spotify:track:new");
+	copy.addTrack(added);
+	edited = copy;
+
+	std::vector<LibraryChange> changes;
+	clock_t start = clock();
+	bool diffed = diffRootFolders(from, to, changes);
+	assert(diffed);
+	double diffMs = elapsedMs(start);
+	assert(changes.size() == 1);
+	checkDiff(from, to);
+
+	unsigned int deltaBytes = 0;
+	for (size_t i = 0; i < changes.size(); i++)
+		deltaBytes += encodedSize(changes[i].toTlv());
+	unsigned int treeBytes = encodedSize(to.toTlv());
+	assert(deltaBytes * 100 < treeBytes);
+
+	benchmarkReport("LibraryDelta") << playlists << " playlists of " << tracksPerPlaylist << " tracks, one track added: " << changes.size()
+	          << " change, " << deltaBytes << " bytes instead of " << treeBytes << " for the tree, diffed in " << diffMs << " ms" << std::endl;
+	return true;
+}
+
+bool LibraryDelta_SUITE::run_unittests()
+{
+	ut_testPlaylistChanges();
+	ut_testTrackChanges();
+	ut_testFolderChangeResyncs();
+	if (benchmarksEnabled())
+		ut_benchmarkSingleEdit();
+	return true;
+}
+
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LibrarySearchIndex_TEST.h"
+#include "unittest.h"
+#include "TestHelpers.h"
+
+#include "LibrarySearchIndex.h"
+#include <string>
+#include <vector>
+#include <assert.h>
+#include <time.h>
+
+using namespace LibSpotify;
+
+namespace Test
+{
+
+static bool ut_testTokenize()
+{
+	std::vector<std::string> words;
+	LibrarySearchIndex::tokenize("Beyonc\xc3\xa9 - D\xc3\xa9j\xc3\xa0 Vu (Remix) Don't  STRA\xc3\x9f" "E", words);
+
+	assert(words.size() == 6);
+	assert(words[0] == "beyonce");
+	assert(words[1] == "deja");
+	assert(words[2] == "vu");
+	assert(words[3] == "remix");
+	assert(words[4] == "dont");
+	assert(words[5] == "strasse");
+	return true;
+}
+
+static bool ut_testSearch()
+{
+	LibrarySearchIndex index;
+	Playlist playlist("pl", "spotify:user:u:playlist:1");
+	Track t1 = makeTrack("Wonderwall", "Oasis", "(What's the Story) Morning Glory?", "spotify:track:1");
+	Track t2 = makeTrack("Champagne Supernova", "Oasis", "(What's the Story) Morning Glory?", "spotify:track:2");
+	Track t3 = makeTrack("Crazy in Love", "Beyonc\xc3\xa9", "Dangerously in Love", "spotify:track:3");
+	playlist.addTrack(t1);
+	playlist.addTrack(t2);
+	playlist.addTrack(t3);
+	index.addPlaylist(playlist);
+
+	Playlist result("", "");
+	bool found = index.search("oasis", 100, result);
+	assert(found);
+	assert(result.getTracks().size() == 2);
+
+	Playlist prefix("", "");
+	found = index.search("BEYON cra", 100, prefix);
+	assert(found);
+	assert(prefix.getTracks().size() == 1);
+	assert(prefix.getTracks()[0].getLink() == "spotify:track:3");
+
+	Playlist limited("", "");
+	found = index.search("morning", 1, limited);
+	assert(found);
+	assert(limited.getTracks().size() == 1);
+
+	Playlist none("", "");
+	found = index.search("oasis love", 100, none);
+	assert(!found);
+	found = index.search("", 100, none);
+	assert(!found);
+	return true;
+}
+
+static bool ut_testIncrementalUpdates()
+{
+	LibrarySearchIndex index;
+	Playlist first("first", "spotify:user:u:playlist:1");
+	Playlist second("second", "spotify:user:u:playlist:2");
+	Track shared = makeTrack("Shared Song", "Someone", "Album", "spotify:track:1");
+	Track only = makeTrack("Lonely Song", "Someone", "Album", "spotify:track:2");
+	first.addTrack(shared);
+	first.addTrack(only);
+	second.addTrack(shared);
+
+	index.addPlaylist(first);
+	index.addPlaylist(second);
+	/* the same track list again is only counted */
+	Playlist copy(first);
+	index.addPlaylist(copy);
+	assert(index.getTrackCount() == 2);
+
+	index.removePlaylist(first);
+	Playlist result("", "");
+	bool found = index.search("lonely", 100, result);
+	assert(found);
+
+	index.removePlaylist(copy);
+	Playlist removed("", "");
+	found = index.search("lonely", 100, removed);
+	assert(!found);
+	assert(index.getTrackCount() == 1);
+
+	/* still in the second playlist */
+	Playlist kept("", "");
+	found = index.search("shared", 100, kept);
+	assert(found);
+
+	/* a changed playlist is a new track list */
+	Track added = makeTrack("Brand New", "Other", "Album", "spotify:track:3");
+	second.addTrack(added);
+	Playlist oldSecond("second", "spotify:user:u:playlist:2");
+	oldSecond.addTrack(shared);
+	index.addPlaylist(second);
+	index.removePlaylist(oldSecond); /* never added, ignored */
+	Playlist brandNew("", "");
+	found = index.search("brand", 100, brandNew);
+	assert(found);
+	assert(index.getTrackCount() == 2);
+
+	index.clear();
+	assert(index.getTrackCount() == 0);
+	return true;
+}
+
+/* a 100k track library of made up words, to see that building stays reasonable and
+ * searching stays well below a millisecond */
+static bool ut_benchmark100kTracks()
+{
+	const unsigned int tracks = 100000;
+	const unsigned int tracksPerPlaylist = 1000;
+	unsigned int seed = 12345;
+
+	Folder root = makeSyntheticLibrary(tracks, tracksPerPlaylist, seed);
+
+	LibrarySearchIndex index;
+	clock_t start = clock();
+	index.addFolder(root);
+	double buildMs = elapsedMs(start);
+	assert(index.getTrackCount() == tracks);
+
+	const unsigned int queries = 2000;
+	unsigned int hits = 0;
+	start = clock();
+	for (unsigned int q = 0; q < queries; q++)
+	{
+		nextRandom(seed);
+		std::string query = syntheticWord((seed >> 8) % 20000);
+		if (q % 2)
+			query += " " + syntheticWord((seed >> 4) % 5000).substr(0, 3);
+		else
+			query = query.substr(0, 4);
+		Playlist result("", "");
+		if (index.search(query, 100, result))
+			hits++;
+	}
+	double queryMs = elapsedMs(start) / queries;
+
+	/* replacing one playlist, as when it is edited */
+	Playlist edited(root.getPlaylists()[0]);
+	Track track = makeTrack("edited", "someone", "something", "spotify:track:edited");
+	edited.addTrack(track);
+	start = clock();
+	index.addPlaylist(edited);
+	index.removePlaylist(root.getPlaylists()[0]);
+	double updateMs = elapsedMs(start);
+	Playlist result("", "");
+	bool found = index.search("edited", 100, result);
+	assert(found);
+
+	benchmarkReport("LibrarySearchIndex") << tracks << " tracks, " << index.getWordCount() << " words, built in "
+	          << buildMs << " ms, " << queryMs * 1000 << " us per search (" << hits << "/" << queries << " with hits), "
+	          << updateMs << " ms to update a playlist" << std::endl;
+	return true;
+}
+
+bool LibrarySearchIndex_SUITE::run_unittests()
+{
+	ut_testTokenize();
+	ut_testSearch();
+	ut_testIncrementalUpdates();
+	if (benchmarksEnabled())
+		ut_benchmark100kTracks();
+	return true;
+}
+
+}
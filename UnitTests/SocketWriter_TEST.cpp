@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SocketWriter_TEST.h"
+#include "unittest.h"
+
+#include "MessageFactory/SocketWriter.h"
+#include "MessageFactory/MessageEncoder.h"
+#include "Platform/Socket/Socket.h"
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <stdio.h>
+#include <unistd.h>
+#include <assert.h>
+
+namespace Test
+{
+
+/* in the temp dir and per process, so a failed or parallel run doesn't leave it
+ * behind in the working directory or trip over another one's */
+static std::string testFile()
+{
+	std::ostringstream name;
+	name << P_tmpdir << "/SocketWriter_TEST." << getpid() << ".tmp";
+	return name.str();
+}
+
+static void writeTestFile(unsigned int size)
+{
+	FILE* f = fopen(testFile().c_str(), "w");
+	assert(f != NULL);
+	for (unsigned int i = 0; i < size; i++)
+		fputc('a' + (i % 26), f);
+	fclose(f);
+}
+
+/* a connected pair of sockets over loopback. Socket can't tell which port it got,
+ * so ports are tried from one that depends on the process, parallel runs then
+ * start apart. A socket that failed to bind or listen isn't reused */
+static bool connectPair(Socket& client, Socket*& server)
+{
+	for (unsigned int i = 0; i < 1000; i++)
+	{
+		std::ostringstream port;
+		port << 20000 + (getpid() * 20 + i) % 20000;
+		Socket listener;
+		if (listener.BindToAddr("127.0.0.1", port.str()) == 0 && listener.Listen() == 0)
+		{
+			if (client.Connect("127.0.0.1", port.str()) != 0)
+				return false;
+			server = listener.Accept();
+			return server != NULL;
+		}
+	}
+	return false;
+}
+
+/* keeps writing until the writer is done or fails, draining the client so
+ * the socket stays writable. Returns the last doWrite() result */
+static int writeAll(SocketWriter& writer, Socket& client, unsigned int& received)
+{
+	char buf[4096];
+	int rc = 0;
+	for (int i = 0; i < 10000 && !writer.isEmpty(); i++)
+	{
+		rc = writer.doWrite();
+		if (rc < 0)
+			break;
+		int n = client.Receive(buf, sizeof(buf));
+		if (n > 0)
+			received += n;
+	}
+	for (int i = 0; i < 100; i++)
+	{
+		int n = client.Receive(buf, sizeof(buf));
+		if (n > 0)
+			received += n;
+		else
+			usleep(1000);
+	}
+	return rc;
+}
+
+static bool ut_testSendFile()
+{
+	Socket client;
+	Socket* server = NULL;
+	bool connected = connectPair(client, server);
+	assert(connected);
+
+	writeTestFile(100000);
+	MessageEncoder* msg = new MessageEncoder(GET_IMAGE_RSP);
+	msg->encode(TLV_LINK, "spotify:image:test");
+	msg->encodeFile(TLV_IMAGE_DATA, testFile());
+	msg->finalize();
+	unsigned int expected = msg->getLength() + msg->getFileRange()->len;
+
+	SocketWriter writer(server);
+	writer.setData(msg);
+	unsigned int received = 0;
+	int rc = writeAll(writer, client, received);
+	assert(rc > 0);
+	assert(writer.isEmpty());
+	assert(received == expected);
+
+	delete server;
+	unlink(testFile().c_str());
+	return true;
+}
+
+/* the file is cut short after it was attached, the writer must give up instead
+ * of waiting for bytes that will never come */
+static bool ut_testSendFileShrunk()
+{
+	Socket client;
+	Socket* server = NULL;
+	bool connected = connectPair(client, server);
+	assert(connected);
+
+	writeTestFile(100000);
+	MessageEncoder* msg = new MessageEncoder(GET_IMAGE_RSP);
+	msg->encodeFile(TLV_IMAGE_DATA, testFile());
+	msg->finalize();
+	int rc = truncate(testFile().c_str(), 1000);
+	assert(rc == 0);
+
+	SocketWriter writer(server);
+	writer.setData(msg);
+	unsigned int received = 0;
+	rc = writeAll(writer, client, received);
+	assert(rc < 0);
+	assert(writer.isEmpty());
+
+	delete server;
+	unlink(testFile().c_str());
+	return true;
+}
+
+bool SocketWriter_SUITE::run_unittests()
+{
+	ut_testSendFile();
+	ut_testSendFileShrunk();
+	return true;
+}
+}
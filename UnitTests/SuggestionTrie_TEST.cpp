@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SuggestionTrie_TEST.h"
+#include "unittest.h"
+#include "TestHelpers.h"
+
+#include "SuggestionTrie.h"
+#include <string>
+#include <vector>
+#include <assert.h>
+#include <time.h>
+
+using namespace LibSpotify;
+
+namespace Test
+{
+
+static Folder makeLibrary()
+{
+	Folder root("root", 0, 0);
+	Playlist oasis("Best of Oasis", "spotify:user:u:playlist:1");
+	Track wonderwall = makeTrack("Wonderwall", "Oasis", "Morning Glory", "spotify:track:1");
+	Track supernova = makeTrack("Champagne Supernova", "Oasis", "Morning Glory", "spotify:track:2");
+	Track wonder = makeTrack("Wonder of You", "Elvis", "Live", "spotify:track:3");
+	oasis.addTrack(wonderwall);
+	oasis.addTrack(supernova);
+	oasis.addTrack(wonder);
+	root.addPlaylist(oasis);
+
+	Playlist mix("Wonderful Mix", "spotify:user:u:playlist:2");
+	mix.addTrack(wonderwall);
+	root.addPlaylist(mix);
+	return root;
+}
+
+static bool ut_testSuggest()
+{
+	SuggestionTrie trie;
+	trie.build(makeLibrary(), 1024 * 1024);
+
+	std::vector<Suggestion> wo;
+	trie.suggest("WO", 10, wo);
+	assert(wo.size() == 3);
+	/* in two playlists */
+	assert(wo[0].getName() == "Wonderwall");
+	assert(wo[0].getType() == SUGGESTION_TRACK);
+	assert(wo[0].getLink() == "spotify:track:1");
+
+	/* from the start of a later word */
+	std::vector<Suggestion> superNova;
+	trie.suggest("supern", 10, superNova);
+	assert(superNova.size() == 1);
+	assert(superNova[0].getName() == "Champagne Supernova");
+
+	std::vector<Suggestion> artist;
+	trie.suggest("oas", 10, artist);
+	assert(artist.size() == 2);
+	assert(artist[0].getType() == SUGGESTION_ARTIST);
+	assert(artist[1].getType() == SUGGESTION_PLAYLIST);
+
+	std::vector<Suggestion> limited;
+	trie.suggest("w", 2, limited);
+	assert(limited.size() == 2);
+
+	std::vector<Suggestion> none;
+	trie.suggest("xyz", 10, none);
+	assert(none.empty());
+	return true;
+}
+
+static bool ut_testPlaysRankFirst()
+{
+	SuggestionTrie trie;
+	Folder library = makeLibrary();
+	trie.build(library, 1024 * 1024);
+
+	Track wonder = makeTrack("Wonder of You", "Elvis", "Live", "spotify:track:3");
+	trie.played(wonder);
+
+	std::vector<Suggestion> wo;
+	trie.suggest("wonder", 10, wo);
+	assert(wo[0].getName() == "Wonder of You");
+
+	/* plays are kept when it is rebuilt */
+	trie.build(library, 1024 * 1024);
+	std::vector<Suggestion> rebuilt;
+	trie.suggest("w", 10, rebuilt);
+	assert(rebuilt[0].getName() == "Wonder of You");
+
+	/* an empty prefix is the best of everything, here what was played */
+	std::vector<Suggestion> best;
+	trie.suggest("", 4, best);
+	assert(best.size() == 4);
+	for (unsigned int i = 0; i < 3; i++)
+		assert(best[i].getName() == "Wonder of You" || best[i].getName() == "Elvis" || best[i].getName() == "Live");
+	return true;
+}
+
+/* built elsewhere from the plays counted so far, then swapped in with the plays counted meanwhile */
+static bool ut_testTakePlays()
+{
+	Folder library = makeLibrary();
+	Track supernova = makeTrack("Champagne Supernova", "Oasis", "Morning Glory", "spotify:track:2");
+	Track wonder = makeTrack("Wonder of You", "Elvis", "Live", "spotify:track:3");
+
+	SuggestionTrie trie;
+	trie.build(library, 1024 * 1024);
+	trie.played(supernova);
+	trie.played(supernova);
+
+	SuggestionTrie::Plays plays;
+	trie.getPlays(plays);
+	SuggestionTrie built;
+	built.build(library, 1024 * 1024, plays);
+
+	for (unsigned int i = 0; i < 3; i++)
+		trie.played(wonder);
+
+	built.takePlays(trie);
+	trie.swap(built);
+
+	/* three plays beat two, the two from before the build aren't counted twice */
+	std::vector<Suggestion> best;
+	trie.suggest("", 6, best);
+	assert(best.size() == 6);
+	for (unsigned int i = 0; i < 3; i++)
+		assert(best[i].getName() == "Wonder of You" || best[i].getName() == "Elvis" || best[i].getName() == "Live");
+	for (unsigned int i = 3; i < 6; i++)
+		assert(best[i].getName() == "Champagne Supernova" || best[i].getName() == "Oasis" || best[i].getName() == "Morning Glory");
+	return true;
+}
+
+static bool ut_testMemoryBound()
+{
+	SuggestionTrie trie;
+	trie.build(makeLibrary(), 450);
+	assert(trie.getEntryCount() > 0);
+	assert(trie.getEntryCount() < 9);
+
+	/* what's kept is what's in the library most */
+	std::vector<Suggestion> wo;
+	trie.suggest("wonderw", 10, wo);
+	assert(wo.size() == 1);
+	return true;
+}
+
+/* a 100k track library of made up names, typed one keystroke at a time */
+static bool ut_benchmark100kTracks()
+{
+	const unsigned int tracks = 100000;
+	const unsigned int tracksPerPlaylist = 1000;
+	unsigned int seed = 12345;
+
+	Folder root = makeSyntheticLibrary(tracks, tracksPerPlaylist, seed);
+
+	SuggestionTrie trie;
+	const size_t maxBytes = 16 * 1024 * 1024;
+	clock_t start = clock();
+	trie.build(root, maxBytes);
+	double buildMs = elapsedMs(start);
+	assert(trie.getBytes() <= maxBytes);
+
+	const unsigned int words = 1000;
+	unsigned int keystrokes = 0;
+	unsigned int suggestions = 0;
+	start = clock();
+	for (unsigned int q = 0; q < words; q++)
+	{
+		nextRandom(seed);
+		std::string word = syntheticWord((seed >> 8) % 20000);
+		for (size_t length = 1; length <= word.size(); length++)
+		{
+			std::vector<Suggestion> result;
+			trie.suggest(word.substr(0, length), 10, result);
+			suggestions += result.size();
+			keystrokes++;
+		}
+	}
+	double keystrokeMs = elapsedMs(start) / keystrokes;
+
+	const Track& played = root.getPlaylists()[7].getTracks()[7];
+	start = clock();
+	for (unsigned int i = 0; i < 100; i++)
+		trie.played(played);
+	double playMs = elapsedMs(start) / 100;
+	/* the played track, its album and its artist now lead the overall ranking */
+	std::vector<Suggestion> result;
+	trie.suggest("", 3, result);
+	assert(result.size() == 3);
+	bool found = false;
+	for (size_t i = 0; i < result.size(); i++)
+		found |= (result[i].getLink() == played.getLink());
+	assert(found);
+
+	benchmarkReport("SuggestionTrie") << tracks << " tracks, " << trie.getEntryCount() << " names in " << trie.getBytes() << " bytes, built in "
+	          << buildMs << " ms, " << keystrokeMs * 1000 << " us per keystroke (" << suggestions / keystrokes << " suggestions), "
+	          << playMs * 1000 << " us per play" << std::endl;
+	return true;
+}
+
+bool SuggestionTrie_SUITE::run_unittests()
+{
+	ut_testSuggest();
+	ut_testPlaysRankFirst();
+	ut_testTakePlays();
+	ut_testMemoryBound();
+	if (benchmarksEnabled())
+		ut_benchmark100kTracks();
+	return true;
+}
+
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TESTHELPERS_H_
+#define TESTHELPERS_H_
+
+#include "MediaContainers/Folder.h"
+#include "MediaContainers/Playlist.h"
+#include "MediaContainers/Track.h"
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <time.h>
+
+/* Made up tracks and libraries, and timing for the benchmarks, shared by the suites */
+namespace Test
+{
+
+inline LibSpotify::Track makeTrack(const std::string& name, const std::string& artist, const std::string& album, const std::string& link)
+{
+	LibSpotify::Track track(name, link);
+	LibSpotify::Artist trackArtist(artist.c_str());
+	trackArtist.setLink("spotify:artist:" + artist);
+	track.addArtist(trackArtist);
+	track.setAlbum(album);
+	track.setAlbumLink("spotify:album:" + album);
+	return track;
+}
+
+/* a pronounceable word for every n, different n give different words */
+inline std::string syntheticWord(unsigned int n)
+{
+	static const char* syllables[] = { "ka", "lo", "mi", "ra", "te", "su", "no", "vi", "de", "ba", "ze", "po", "qu", "fa", "ny", "go" };
+	std::string word;
+	do
+	{
+		word += syllables[n % 16];
+		n /= 16;
+	} while (n);
+	return word;
+}
+
+/* the same sequence on every platform, unlike rand() */
+inline unsigned int nextRandom(unsigned int& seed)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed;
+}
+
+/* playlists of tracksPerPlaylist tracks with three word names out of 20000 words,
+ * by 5000 artists with 4 albums each. The same library for the same seed, which is
+ * left where the library ends for the queries that follow */
+inline LibSpotify::Folder makeSyntheticLibrary(unsigned int tracks, unsigned int tracksPerPlaylist, unsigned int& seed)
+{
+	LibSpotify::Folder root("root", 0, 0);
+	for (unsigned int pl = 0; pl < tracks / tracksPerPlaylist; pl++)
+	{
+		std::ostringstream link;
+		link << "spotify:user:u:playlist:" << pl;
+		LibSpotify::Playlist playlist(syntheticWord(200000 + pl), link.str());
+		for (unsigned int i = 0; i < tracksPerPlaylist; i++)
+		{
+			std::ostringstream trackLink;
+			trackLink << "spotify:track:" << pl * tracksPerPlaylist + i;
+			std::string name;
+			for (unsigned int w = 0; w < 3; w++)
+				name += syntheticWord((nextRandom(seed) >> 8) % 20000) + " ";
+			nextRandom(seed);
+			unsigned int artist = (seed >> 8) % 5000;
+			LibSpotify::Track track = makeTrack(name, syntheticWord(artist), syntheticWord(100000 + artist * 4 + seed % 4), trackLink.str());
+			playlist.addTrack(track);
+		}
+		root.addPlaylist(playlist);
+	}
+	return root;
+}
+
+/* the benchmarks build libraries of 100k tracks, they only run with --benchmarks */
+inline bool& benchmarksEnabled()
+{
+	static bool enabled = false;
+	return enabled;
+}
+
+inline double elapsedMs(clock_t start)
+{
+	return (clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/* a benchmark reports on one line, starting with the name of its suite */
+inline std::ostream& benchmarkReport(const char* suite)
+{
+	return std::cout << suite << ": ";
+}
+
+}
+
+#endif /* TESTHELPERS_H_ */
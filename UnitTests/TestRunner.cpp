@@ -26,13 +26,37 @@
  */
 
 #include <iostream>
+#include <string.h>
+
+#include "applog.h"
 
 #include "ConfigParser_TEST.h"
+#include "LibrarySearchIndex_TEST.h"
+#include "SuggestionTrie_TEST.h"
+#include "LibraryDelta_TEST.h"
+#include "SocketWriter_TEST.h"
+#include "TestHelpers.h"
 
 int main(int argc, char *argv[])
 {
 	bool success = false;
+
+	/* the code under test logs, keep it quiet */
+	ConfigHandling::LoggerConfig logConfig;
+	logConfig.setLogTo(ConfigHandling::LoggerConfig::NOWHERE);
+	Logger::Logger quietLogger(logConfig);
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--benchmarks") == 0)
+			Test::benchmarksEnabled() = true;
+	}
+
 	success = Test::ConfigParser_SUITE::run_unittests();
+	success = Test::LibrarySearchIndex_SUITE::run_unittests() && success;
+	success = Test::SuggestionTrie_SUITE::run_unittests() && success;
+	success = Test::LibraryDelta_SUITE::run_unittests() && success;
+	success = Test::SocketWriter_SUITE::run_unittests() && success;
 	if(success)std::cout << "All UnitTests ran Successfully!" << std::endl;
 }
 
@@ -128,7 +128,9 @@ class Tlv(object):
             self._TlvType == TlvDefinitions.TlvContainerType.TLV_TRACK or 
             self._TlvType == TlvDefinitions.TlvContainerType.TLV_ALBUM or
             self._TlvType == TlvDefinitions.TlvContainerType.TLV_ARTIST or
-            self._TlvType == TlvDefinitions.TlvContainerType.TLV_IMAGE):
+            self._TlvType == TlvDefinitions.TlvContainerType.TLV_IMAGE or
+            self._TlvType == TlvDefinitions.TlvContainerType.TLV_STATS or
+            self._TlvType == TlvDefinitions.TlvContainerType.TLV_METRIC):
             return True
         else:
             return False
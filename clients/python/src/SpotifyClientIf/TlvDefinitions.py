@@ -48,6 +48,11 @@ class TlvMessageType:
     GET_IMAGE_RSP       = int('0x203', 16) | RSP_BIT
     GENERIC_SEARCH_REQ  = int('0x204', 16) | REQ_BIT
     GENERIC_SEARCH_RSP  = int('0x204', 16) | RSP_BIT
+    SEARCH_SUGGEST_REQ  = int('0x207', 16) | REQ_BIT
+    SEARCH_SUGGEST_RSP  = int('0x207', 16) | RSP_BIT
+    LIBRARY_SUBSCRIBE_REQ = int('0x208', 16) | REQ_BIT
+    LIBRARY_SUBSCRIBE_RSP = int('0x208', 16) | RSP_BIT
+    LIBRARY_CHANGED_IND   = int('0x208', 16) | IND_BIT
     
     # Playback
     PLAY_REQ            = int('0x302', 16) | REQ_BIT
@@ -60,6 +65,10 @@ class TlvMessageType:
     GET_STATUS_RSP      = int('0x401', 16) | RSP_BIT
     STATUS_IND          = int('0x401', 16) | IND_BIT
 
+    # Diagnostics
+    GET_STATS_REQ       = int('0x501', 16) | REQ_BIT
+    GET_STATS_RSP       = int('0x501', 16) | RSP_BIT
+
 
 class TlvContainerType:
         
@@ -71,6 +80,10 @@ class TlvContainerType:
     TLV_IMAGE                   = int('0x8',16)
     TLV_ALBUM                   = int('0x9',16)
     TLV_ARTIST                  = int('0xa',16)
+    TLV_STATS                   = int('0xb',16)
+    TLV_METRIC                  = int('0xc',16)
+    TLV_SUGGESTION              = int('0xd',16)
+    TLV_LIBRARY_CHANGE          = int('0xe',16)
     
     # Track TLV's
     TLV_TRACK_DURATION          = int('0x304', 16)
@@ -78,6 +91,8 @@ class TlvContainerType:
     
     # Search TLV's */
     TLV_SEARCH_QUERY            = int('0x401', 16)
+    TLV_SEARCH_COUNT            = int('0x402', 16)
+    TLV_SUGGESTION_TYPE         = int('0x403', 16)
     
     # Status TLV's */
     TLV_STATE                   = int('0x501', 16)
@@ -91,16 +106,46 @@ class TlvContainerType:
     # Generic data items */
     TLV_LINK                    = int('0x701', 16)
     TLV_NAME                    = int('0x702', 16)
+
+    # Paging of long track lists
+    TLV_RESULT_OFFSET           = int('0x703', 16)
+    TLV_RESULT_COUNT            = int('0x704', 16)
+    TLV_RESULT_TOTAL            = int('0x705', 16)
+    TLV_RESULT_CURSOR           = int('0x706', 16)
+
+    # Conditional metadata requests
+    TLV_CONTENT_VERSION         = int('0x707', 16)
+    TLV_NOT_MODIFIED            = int('0x708', 16)
     
     # Image TLV's */
     TLV_IMAGE_FORMAT            = int('0x701', 16)
     TLV_IMAGE_DATA              = int('0x702', 16)
 
+    # Metric TLV's
+    TLV_METRIC_TYPE             = int('0xb01', 16)
+    TLV_METRIC_VALUE            = int('0xb02', 16)
+    TLV_METRIC_P50              = int('0xb03', 16)
+    TLV_METRIC_P90              = int('0xb04', 16)
+    TLV_METRIC_P99              = int('0xb05', 16)
+    TLV_METRIC_MAX              = int('0xb06', 16)
+
+    # Library subscription TLV's
+    TLV_LIBRARY_VERSION         = int('0xc01', 16)
+    TLV_LIBRARY_RESYNC          = int('0xc02', 16)
+    TLV_CHANGE_TYPE             = int('0xc03', 16)
+    TLV_CHANGE_FOLDER           = int('0xc04', 16)
+    TLV_CHANGE_POSITION         = int('0xc05', 16)
+    TLV_CHANGE_TO_FOLDER        = int('0xc06', 16)
+    TLV_CHANGE_TO_POSITION      = int('0xc07', 16)
+    TLV_CHANGE_COUNT            = int('0xc08', 16)
+    TLV_LIBRARY_EPOCH           = int('0xc09', 16)
+
     # Session TLV's
     TLV_LOGIN_USERNAME         = int('0x1001', 16)
     TLV_LOGIN_PASSWORD         = int('0x1002', 16)
     TLV_PROTOCOL_VERSION_MAJOR = int('0x1003', 16)
     TLV_PROTOCOL_VERSION_MINOR = int('0x1004', 16)
+    TLV_MORE_TO_COME           = int('0x1005', 16)
 
     # Error handling TLV's
     TLV_FAILURE                = int('0x1101', 16)
@@ -116,6 +161,7 @@ class TlvFailureCause:
     # message errors
     FAIL_UNKNOWN_REQUEST   = int('0x21', 16) # = Unknown MessageType_t
     FAIL_MISSING_TLV       = int('0x22', 16) # = Mandatory parameter was missing in request
+    FAIL_CURSOR_EXPIRED    = int('0x23', 16) # = The result a cursor named is no longer kept, search again
     
     
 
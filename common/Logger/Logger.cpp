@@ -27,11 +27,11 @@
 
 #include "Logger.h"
 #include "ConfigHandling/ConfigHandler.h"
-#include <ostream>
+#include <iostream>
 #include <stdio.h>
 #include <stdarg.h>
-#include <iostream>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <time.h>
 
@@ -51,93 +51,333 @@ static const char* level_strings[] =
 #define localtime_r(a, b) localtime_s(b, a) /*goddammit microsoft!*/
 #endif
 
-static std::string logprefix( LogLevel level, const char* functionName )
+Logger::Logger(const ConfigHandling::LoggerConfig& config) : Platform::Runnable(true, SIZE_SMALL, PRIO_LOW),
+                                                             config_(config),
+                                                             enabledLevel_(config.getLogLevel()),
+                                                             ring_(NULL),
+                                                             dequeuePos_(0),
+                                                             droppedReported_(0),
+                                                             out_(NULL),
+                                                             bytesWritten_(0)
 {
-    time_t rawtime;
-    struct tm timeinfo;
-    std::stringstream str;
-    char tmp[10] = {0};
+    /* there should only exist 1 instance of logger! */
+    assert(::logger == NULL);
+    ::logger = this;
 
-    time (&rawtime);
-    localtime_r (&rawtime, &timeinfo);
-    strftime( tmp, sizeof(tmp), "%H:%M:%S", &timeinfo );
+    switch (config_.getLogTo())
+    {
+        case ConfigHandling::LoggerConfig::FILE:
+            openLogFile("a");
+            break;
+
+        case ConfigHandling::LoggerConfig::STDOUT:
+            out_ = stdout;
+            break;
+
+        default:
+            /* nothing will ever be written, don't waste memory on a ring or a thread,
+             * and don't let anyone format anything either */
+            enabledLevel_ = -1;
+            return;
+    }
+
+    ring_ = new LogRecord[LOG_RING_SIZE];
+    for(unsigned int i = 0; i < LOG_RING_SIZE; i++)
+    {
+        ring_[i].sequence.set(i);
+        ring_[i].overflow = NULL;
+    }
 
-    str << tmp << " [" << level_strings[level] << "] " << functionName << ": ";
-    return str.str();
+    startThread();
 }
 
-Logger::Logger(const ConfigHandling::LoggerConfig& config) : config_(config)
+Logger::~Logger()
 {
-    /* there should only exist 1 instance of logger! */
-    assert(::logger == NULL);
-    ::logger = this;
+    if(ring_ != NULL)
+    {
+        destroy();
+        if(out_ != stdout)
+            fclose(out_);
+        for(unsigned int i = 0; i < LOG_RING_SIZE; i++)
+            delete[] ring_[i].overflow;
+        delete[] ring_;
+    }
 }
-Logger::~Logger(){ }
 
-void Logger::logAppend(LogLevel level, const char* functionName, const char* log)
+void Logger::destroy()
 {
-    mtx_.lock();
-    switch (config_.getLogTo())
+    cancelThread();
+    cond_.signal();
+    joinThread();
+}
+
+void Logger::openLogFile(const char* mode)
+{
+    out_ = fopen(config_.getLogFile().c_str(), mode);
+    if(out_ == NULL)
     {
-        case ConfigHandling::LoggerConfig::FILE:
+        std::cerr << "Unable to open output logfile " << config_.getLogFile();
+        exit(-1);
+    }
+    fseek(out_, 0, SEEK_END);
+    bytesWritten_ = ftell(out_);
+}
+
+void Logger::rotateLogFile()
+{
+    const std::string& logFile = config_.getLogFile();
+    unsigned int rotations = config_.getLogFileRotations();
+
+    fclose(out_);
+
+    /* output.log.N-1 -> output.log.N ... output.log -> output.log.1, oldest one falls off */
+    for(unsigned int i = rotations; i > 0; i--)
+    {
+        std::stringstream from, to;
+        from << logFile;
+        if(i > 1) from << "." << (i - 1);
+        to << logFile << "." << i;
+
+        remove(to.str().c_str());
+        rename(from.str().c_str(), to.str().c_str());
+    }
+
+    openLogFile("w");
+}
+
+void Logger::operator<<=(const LoggerStreamBuffer& buff)
+{
+    enqueue(buff.level_, buff.functionName_, buff.getArgs(), buff.length_, buff.truncated_);
+}
+
+void Logger::enqueue(LogLevel level, const char* functionName, const char* args, unsigned int length, bool truncated)
+{
+    if(ring_ == NULL)
+        return;
+
+    /* claim a slot, a slot is free when its sequence equals the position we want to write */
+    long pos = enqueuePos_.get();
+    LogRecord* record;
+    for(;;)
+    {
+        record = &ring_[pos & (LOG_RING_SIZE - 1)];
+        long diff = (long)((unsigned long)record->sequence.get() - (unsigned long)pos);
+
+        if(diff == 0)
+        {
+            if(enqueuePos_.compareAndSwap(pos, pos + 1))
+                break;
+        }
+        else if(diff < 0)
         {
-            std::filebuf fb;
-            std::ostream os(&fb);
-            if(fb.open(config_.getLogFile().c_str(), std::ios::out|std::ios::app) != NULL)
+            /* ring is full, writer has not caught up */
+            droppedRecords_.increment();
+            return;
+        }
+        pos = enqueuePos_.get();
+    }
+
+    record->level = level;
+    record->functionName = functionName;
+    record->timestamp = time(NULL);
+    record->length = length;
+    record->truncated = truncated;
+    if(length > sizeof(record->args))
+    {
+        record->overflow = new char[length];
+        memcpy(record->overflow, args, length);
+    }
+    else
+    {
+        memcpy(record->args, args, length);
+    }
+
+    /* publish */
+    record->sequence.set(pos + 1);
+
+    if(writerSleeping_.get())
+        cond_.signal();
+}
+
+void Logger::writeRecord(LogLevel level, const char* functionName, time_t timestamp, const char* args, unsigned int length, bool truncated)
+{
+    struct tm timeinfo;
+    char tmp[10] = {0};
+    bool hex = false;
+    int n = 0;
+
+    localtime_r (&timestamp, &timeinfo);
+    strftime( tmp, sizeof(tmp), "%H:%M:%S", &timeinfo );
+
+    n += fprintf(out_, "%s [%s] %s: ", tmp, level_strings[level], functionName);
+
+    unsigned int pos = 0;
+    while(pos < length)
+    {
+        LoggerStreamBuffer::ArgType type = static_cast<LoggerStreamBuffer::ArgType>(args[pos++]);
+        switch(type)
+        {
+            case LoggerStreamBuffer::ARG_STRING:
             {
-                os << logprefix(level, functionName) << log << std::endl;
-                fb.close();
+                unsigned short size;
+                memcpy(&size, &args[pos], sizeof(size));
+                pos += sizeof(size);
+                n += fwrite(&args[pos], 1, size, out_);
+                pos += size;
             }
-            else
+            break;
+
+            case LoggerStreamBuffer::ARG_CHAR:
+                fputc(args[pos++], out_);
+                n++;
+                break;
+
+            case LoggerStreamBuffer::ARG_SIGNED:
             {
-                std::cerr << "Unable to open output logfile " << config_.getLogFile();
-                fb.close();
-                exit(-1);
+                long long value;
+                memcpy(&value, &args[pos], sizeof(value));
+                pos += sizeof(value);
+                n += fprintf(out_, hex ? "%llx" : "%lld", value);
             }
-        }
-        break;
+            break;
 
-        case ConfigHandling::LoggerConfig::STDOUT:
-        {
-            std::cout << logprefix(level, functionName) << log << std::endl;
-        }
-        break;
+            case LoggerStreamBuffer::ARG_UNSIGNED:
+            {
+                unsigned long long value;
+                memcpy(&value, &args[pos], sizeof(value));
+                pos += sizeof(value);
+                n += fprintf(out_, hex ? "%llx" : "%llu", value);
+            }
+            break;
 
-        default:
+            case LoggerStreamBuffer::ARG_DOUBLE:
+            {
+                double value;
+                memcpy(&value, &args[pos], sizeof(value));
+                pos += sizeof(value);
+                n += fprintf(out_, "%g", value);
+            }
+            break;
+
+            case LoggerStreamBuffer::ARG_POINTER:
+            {
+                const void* value;
+                memcpy(&value, &args[pos], sizeof(value));
+                pos += sizeof(value);
+                n += fprintf(out_, "%p", value);
+            }
             break;
+
+            case LoggerStreamBuffer::ARG_HEX: hex = true;  break;
+            case LoggerStreamBuffer::ARG_DEC: hex = false; break;
+
+            default:
+                /* can't happen, but don't go reading garbage if it does */
+                pos = length;
+                break;
+        }
     }
-    mtx_.unlock();
+
+    if(truncated)
+        n += fprintf(out_, "...");
+    fputc('\n', out_);
+
+    if(n > 0)
+        bytesWritten_ += n;
+    bytesWritten_++;
 }
 
-LoggerStreamBuffer* Logger::logAppend(LogLevel level, const char* functionName)
+unsigned int Logger::writeRecords()
 {
-    LoggerStreamBuffer* buff = new LoggerStreamBuffer(*this);
-    *buff << logprefix(level, functionName);
-    return buff;
+    unsigned int written = 0;
+    unsigned long maxFileSize = config_.getMaxLogFileSize();
+
+    unsigned long dropped = droppedRecords_.get();
+    if(dropped != droppedReported_)
+    {
+        LoggerStreamBuffer buff(LOG_WARN, __FUNCTION__);
+        buff << (dropped - droppedReported_) << " log records dropped, logger could not keep up";
+        writeRecord(buff.level_, buff.functionName_, time(NULL), buff.getArgs(), buff.length_, buff.truncated_);
+        droppedReported_ = dropped;
+        written++;
+    }
+
+    while(written < LOG_BATCH_SIZE)
+    {
+        LogRecord* record = &ring_[dequeuePos_ & (LOG_RING_SIZE - 1)];
+        long diff = (long)((unsigned long)record->sequence.get() - (unsigned long)(dequeuePos_ + 1));
+
+        if(diff < 0)
+            break; /* empty, or producer has not published yet */
+
+        writeRecord(record->level, record->functionName, record->timestamp, record->overflow ? record->overflow : record->args,
+                    record->length, record->truncated);
+        delete[] record->overflow;
+        record->overflow = NULL;
+
+        /* hand the slot back to the producers for the next lap */
+        record->sequence.set(dequeuePos_ + LOG_RING_SIZE);
+        dequeuePos_++;
+        written++;
+    }
+
+    if(written > 0)
+    {
+        fflush(out_);
+        if(out_ != stdout && maxFileSize > 0 && bytesWritten_ >= maxFileSize)
+            rotateLogFile();
+    }
+
+    return written;
 }
-void Logger::flush(std::stringstream* buff)
+
+void Logger::run()
 {
-    mtx_.lock();
-    switch (config_.getLogTo())
+    while(isCancellationPending() == false)
     {
-        case ConfigHandling::LoggerConfig::FILE:
+        if(writeRecords() == 0)
         {
-            std::fstream fstream(config_.getLogFile().c_str(), std::ios::out|std::ios::app);
-            fstream << buff->str() << std::endl;
-            fstream.close();
+            /* producers only signal when we are asleep, the timeout covers the race
+             * between setting the flag and actually waiting */
+            writerSleeping_.set(1);
+            mtx_.lock();
+            cond_.timedWait(mtx_, 200);
+            mtx_.unlock();
+            writerSleeping_.set(0);
         }
-        break;
+    }
 
-        case ConfigHandling::LoggerConfig::STDOUT:
-        {
-            std::cout << buff->str() << std::endl;
-        }
-        break;
+    /* drain whatever is left before going down */
+    while(writeRecords() > 0);
+}
 
-        default:
-            break;
+/* a plain string of any length up to LOG_RECORD_MAX_SIZE, as string arguments of at most
+ * what their 16 bit size can say */
+void Logger::logAppend(LogLevel level, const char* functionName, const char* log)
+{
+    const unsigned int maxChunk = 0xffff;
+    const unsigned int overhead = 1 + sizeof(unsigned short);
+    size_t size = strlen(log);
+    bool truncated = false;
+    if(size + (size / maxChunk + 1) * overhead > LOG_RECORD_MAX_SIZE)
+    {
+        size = LOG_RECORD_MAX_SIZE - (LOG_RECORD_MAX_SIZE / maxChunk + 1) * overhead;
+        truncated = true;
     }
-    mtx_.unlock();
+
+    std::string args;
+    args.reserve(size + (size / maxChunk + 1) * overhead);
+    do
+    {
+        unsigned short chunk = static_cast<unsigned short>(size < maxChunk ? size : maxChunk);
+        args += static_cast<char>(LoggerStreamBuffer::ARG_STRING);
+        args.append(reinterpret_cast<const char*>(&chunk), sizeof(chunk));
+        args.append(log, chunk);
+        log += chunk;
+        size -= chunk;
+    } while(size > 0);
+
+    enqueue(level, functionName, args.data(), args.size(), truncated);
 }
 
 LogLevel Logger::getConfiguredLogLevel() const
@@ -145,34 +385,86 @@ LogLevel Logger::getConfiguredLogLevel() const
     return config_.getLogLevel();
 }
 
-void Logger::operator<<=(LoggerStreamBuffer& buff) { buff.flush(); }
+unsigned long Logger::getDroppedRecords() const
+{
+    return droppedRecords_.get();
+}
+
+
+/************************
+ * LoggerStreamBuffer
+ ************************/
+char* LoggerStreamBuffer::spillRoom(unsigned int size)
+{
+    if(length_ + size > LOG_RECORD_MAX_SIZE)
+        return NULL;
+
+    if(spill_.empty())
+        spill_.assign(args_, args_ + length_);
+    spill_.resize(length_ + size);
+    char* p = &spill_[length_];
+    length_ += size;
+    return p;
+}
 
+void LoggerStreamBuffer::putString(const char* str, unsigned int size)
+{
+    const unsigned int overhead = 1 + sizeof(unsigned short);
+    do
+    {
+        /* a string argument says its size in 16 bits, longer ones take several */
+        unsigned int chunk = (size < 0xffff) ? size : 0xffff;
+        if(length_ + overhead + chunk > LOG_RECORD_MAX_SIZE)
+        {
+            truncated_ = true;
+            if(length_ + overhead >= LOG_RECORD_MAX_SIZE)
+                return;
+            chunk = LOG_RECORD_MAX_SIZE - length_ - overhead;
+            size = chunk;
+        }
+
+        char* p = room(overhead + chunk);
+        unsigned short size16 = chunk;
+        p[0] = static_cast<char>(ARG_STRING);
+        memcpy(p + 1, &size16, sizeof(size16));
+        memcpy(p + overhead, str, chunk);
+        str += chunk;
+        size -= chunk;
+    } while(size > 0);
+}
+
+LoggerStreamBuffer& LoggerStreamBuffer::operator<<(std::ios_base& (*manip)(std::ios_base&))
+{
+    if(manip == static_cast<std::ios_base& (*)(std::ios_base&)>(std::hex))
+        put(ARG_HEX, NULL, 0);
+    else if(manip == static_cast<std::ios_base& (*)(std::ios_base&)>(std::dec))
+        put(ARG_DEC, NULL, 0);
+    return *this;
+}
+
+}
 
 void LogAppendCBinder(LogLevel level, const char* functionName, const char* format, ...)
 {
-    char buffer[1000];
+    char buffer[LOG_RECORD_TEXT_SIZE];
     va_list vl;
     va_start(vl,format);
-    vsprintf(buffer, format, vl);
+    int size = vsnprintf(buffer, sizeof(buffer), format, vl);
     va_end(vl);
-    logger->logAppend(level, functionName, buffer);
+    if(size < (int)sizeof(buffer))
+    {
+        logger->logAppend(level, functionName, buffer);
+        return;
+    }
+
+    /* longer than a record, format it again into something big enough */
+    std::string big(size + 1, '\0');
+    va_start(vl,format);
+    vsnprintf(&big[0], big.size(), format, vl);
+    va_end(vl);
+    logger->logAppend(level, functionName, big.c_str());
 }
 LogLevel getConfiguredLogLevelCBinder()
 {
     return logger->getConfiguredLogLevel();
 }
-
-/************************
- * LoggerStreamBuffer
- ************************/
-LoggerStreamBuffer::LoggerStreamBuffer(Logger& logger) : log_(logger), ss_(new std::stringstream) { }
-LoggerStreamBuffer::~LoggerStreamBuffer() { delete ss_; }
-void LoggerStreamBuffer::flush()
-{
-    log_.flush(ss_);
-    delete ss_;
-    ss_ = NULL;
-    delete this;
-};
-
-}
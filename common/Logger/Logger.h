@@ -30,21 +30,70 @@
 
 #include "ConfigHandling/ConfigHandler.h"
 #include "Platform/Threads/Mutex.h"
+#include "Platform/Threads/Condition.h"
+#include "Platform/Threads/Runnable.h"
+#include "Platform/Threads/Atomic.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
 
 namespace Logger
 {
 
-class Logger
+/* Callers never touch the log file themselves, they copy their line into a fixed size
+ * record in a lock-free ring and return. A background thread formats the prefix and
+ * writes the records in batches to one persistent file handle.
+ * When the ring is full the record is dropped and counted, logging never blocks.
+ *
+ * Arguments of the basic types are captured in binary form and only turned into text
+ * by the writer thread, anything else is formatted on the spot through its operator<<.
+ * Text that doesn't fit in a record (message dumps) goes into an allocation of its own
+ * that the record points to, up to LOG_RECORD_MAX_SIZE. */
+#define LOG_RECORD_TEXT_SIZE 480
+#define LOG_RECORD_MAX_SIZE  65536
+#define LOG_RING_SIZE        1024 /* must be a power of 2 */
+#define LOG_BATCH_SIZE       128
+
+class Logger : public Platform::Runnable
 {
 private:
+    typedef struct
+    {
+        Platform::AtomicInt sequence;
+        LogLevel level;
+        const char* functionName; /* always a __FUNCTION__ literal, safe to keep the pointer */
+        time_t timestamp;
+        unsigned int length;
+        bool truncated;
+        char* overflow; /* instead of args when longer, freed by the writer */
+        char args[LOG_RECORD_TEXT_SIZE];
+    }LogRecord;
+
     const ConfigHandling::LoggerConfig& config_;
+    int enabledLevel_;
+
+    LogRecord* ring_;
+    Platform::AtomicInt enqueuePos_;
+    unsigned long dequeuePos_;
+    Platform::AtomicInt droppedRecords_;
+    unsigned long droppedReported_;
+    Platform::AtomicInt writerSleeping_;
+
     Platform::Mutex mtx_;
+    Platform::Condition cond_;
 
-    friend class LoggerStreamBuffer;
-    void flush(std::stringstream* buff);
+    FILE* out_;
+    unsigned long bytesWritten_;
+
+    void openLogFile(const char* mode);
+    void rotateLogFile();
+    unsigned int writeRecords();
+    void enqueue(LogLevel level, const char* functionName, const char* args, unsigned int length, bool truncated);
+    void writeRecord(LogLevel level, const char* functionName, time_t timestamp, const char* args, unsigned int length, bool truncated);
 
     /* Make non-copyable */
     Logger();
@@ -55,33 +104,107 @@ public:
     Logger(const ConfigHandling::LoggerConfig& config);
     virtual ~Logger();
     LogLevel getConfiguredLogLevel() const;
+    inline bool isEnabled(LogLevel level) const { return static_cast<int>(level) <= enabledLevel_; }
+    unsigned long getDroppedRecords() const;
 
     void logAppend(LogLevel level, const char* functionName, const char* log);
-    class LoggerStreamBuffer* logAppend(LogLevel level, const char* functionName);
-    void operator<<=(class LoggerStreamBuffer& buff);
+    void operator<<=(const class LoggerStreamBuffer& buff);
+
+    void run();
+    void destroy();
 };
 
 class LoggerStreamBuffer
 {
+public:
+    typedef enum
+    {
+        ARG_STRING,
+        ARG_CHAR,
+        ARG_SIGNED,
+        ARG_UNSIGNED,
+        ARG_DOUBLE,
+        ARG_POINTER,
+        ARG_HEX,
+        ARG_DEC,
+    }ArgType;
+
 private:
-    Logger& log_;
-    void flush();
+    friend class Logger;
+    LogLevel level_;
+    const char* functionName_;
+    unsigned int length_;
+    bool truncated_;
+    char args_[LOG_RECORD_TEXT_SIZE];
+    /* all of the arguments once they don't fit in args_ any more (message dumps) */
+    std::vector<char> spill_;
+
+    /* where the next size bytes go, NULL if that would be more than LOG_RECORD_MAX_SIZE */
+    inline char* room(unsigned int size)
+    {
+        if(length_ + size <= sizeof(args_) && spill_.empty())
+        {
+            char* p = &args_[length_];
+            length_ += size;
+            return p;
+        }
+        return spillRoom(size);
+    }
+    char* spillRoom(unsigned int size);
+    const char* getArgs() const { return spill_.empty() ? args_ : &spill_[0]; }
+
+    inline void put(ArgType type, const void* value, unsigned int size)
+    {
+        char* p = room(1 + size);
+        if(p == NULL)
+        {
+            truncated_ = true;
+            return;
+        }
+        p[0] = static_cast<char>(type);
+        if(size > 0) memcpy(p + 1, value, size);
+    }
+    inline void putSigned(long long value)      { put(ARG_SIGNED, &value, sizeof(value)); }
+    inline void putUnsigned(unsigned long long value) { put(ARG_UNSIGNED, &value, sizeof(value)); }
+    void putString(const char* str, unsigned int size);
 
 public:
-    std::stringstream* ss_; /*todo: hide me! private doesn't compile on windows*/
-    friend class Logger;
-    template<class T> friend LoggerStreamBuffer& operator<<(LoggerStreamBuffer& buff, const T& rhs);
+    LoggerStreamBuffer(LogLevel level, const char* functionName) : level_(level),
+                                                                   functionName_(functionName),
+                                                                   length_(0),
+                                                                   truncated_(false) {}
 
-    LoggerStreamBuffer(Logger& logger);
-    virtual ~LoggerStreamBuffer();
-};
+    LoggerStreamBuffer& operator<<(const char* rhs)        { putString(rhs, strlen(rhs)); return *this; }
+    LoggerStreamBuffer& operator<<(char* rhs)              { putString(rhs, strlen(rhs)); return *this; }
+    LoggerStreamBuffer& operator<<(const std::string& rhs) { putString(rhs.data(), rhs.size()); return *this; }
+    LoggerStreamBuffer& operator<<(char rhs)               { put(ARG_CHAR, &rhs, 1); return *this; }
+    LoggerStreamBuffer& operator<<(signed char rhs)        { put(ARG_CHAR, &rhs, 1); return *this; }
+    LoggerStreamBuffer& operator<<(unsigned char rhs)      { put(ARG_CHAR, &rhs, 1); return *this; }
+    LoggerStreamBuffer& operator<<(bool rhs)               { putSigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(short rhs)              { putSigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(int rhs)                { putSigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(long rhs)               { putSigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(long long rhs)          { putSigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(unsigned short rhs)     { putUnsigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(unsigned int rhs)       { putUnsigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(unsigned long rhs)      { putUnsigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(unsigned long long rhs) { putUnsigned(rhs); return *this; }
+    LoggerStreamBuffer& operator<<(double rhs)             { put(ARG_DOUBLE, &rhs, sizeof(rhs)); return *this; }
+    LoggerStreamBuffer& operator<<(float rhs)              { double d = rhs; put(ARG_DOUBLE, &d, sizeof(d)); return *this; }
+    LoggerStreamBuffer& operator<<(const void* rhs)        { put(ARG_POINTER, &rhs, sizeof(rhs)); return *this; }
+    LoggerStreamBuffer& operator<<(std::ios_base& (*manip)(std::ios_base&));
 
-template<class T>
-LoggerStreamBuffer& operator<<(LoggerStreamBuffer& buff, const T& rhs)
-{
-    *buff.ss_ << rhs;
-    return buff;
-}
+    /* everything else (messages, tlvs, media containers..) has to be formatted here and now */
+    template<class T>
+    LoggerStreamBuffer& operator<<(const T& rhs)
+    {
+        std::ostringstream ss;
+        ss << rhs;
+        std::string str = ss.str();
+        putString(str.data(), str.size());
+        return *this;
+    }
+};
 
 }
 #endif
@@ -29,8 +29,15 @@
 #define APPLOG_H_
 #include "LogLevels.h"
 
+/* Anything less important than LOG_COMPILE_LEVEL is removed by the compiler altogether,
+ * build with f.ex. -DLOG_COMPILE_LEVEL=LOG_NOTICE to strip all debug logging */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_DEBUG
+#endif
+
 #define APP_LOG(loglevel, format, ...)                                              \
-                if(getConfiguredLogLevelCBinder() >= loglevel)                      \
+                if((loglevel) <= LOG_COMPILE_LEVEL &&                               \
+                   getConfiguredLogLevelCBinder() >= loglevel)                      \
                         LogAppendCBinder(loglevel, __func__, format, __VA_ARGS__)
 
 
@@ -42,9 +49,13 @@ LogLevel getConfiguredLogLevelCBinder();
 #include "Logger.h"
 extern Logger::Logger* logger;
 
+/* Use to guard expensive work that only exists for the sake of logging (hex dumps and such) */
+#define logEnabled(loglevel)                                    \
+           ((loglevel) <= LOG_COMPILE_LEVEL && logger->isEnabled(loglevel))
+
 #define log(loglevel)                                           \
-           if(logger->getConfiguredLogLevel() >= loglevel)      \
-                  *logger <<= *logger->logAppend(loglevel, __FUNCTION__)
+           if(logEnabled(loglevel))                             \
+                  *logger <<= Logger::LoggerStreamBuffer(loglevel, __FUNCTION__)
 
 #endif
 
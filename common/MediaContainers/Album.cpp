@@ -85,4 +85,18 @@ TlvContainer* Album::toTlv() const
     return album;
 }
 
+uint32_t Album::getVersion() const
+{
+    ContentVersion version;
+    version.add( name_ );
+    version.add( link_ );
+    version.add( getTracksVersion( getTracks() ) );
+    version.add( (uint32_t)year_ );
+    version.add( review_ );
+    version.add( isAvailable_ ? 1u : 0u );
+    version.add( artist_.getName() );
+    version.add( artist_.getLink() );
+    return version.get();
+}
+
 } /* namespace LibSpotify */
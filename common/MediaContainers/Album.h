@@ -62,6 +62,8 @@ public:
     const Artist& getArtist() const;
 
     TlvContainer* toTlv() const;
+    /* version of the album with its tracks, see ContentVersion */
+    uint32_t getVersion() const;
 };
 
 } /* namespace LibSpotify */
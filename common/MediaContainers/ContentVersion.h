@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef CONTENTVERSION_H_
+#define CONTENTVERSION_H_
+
+#include <stdint.h>
+#include <string>
+
+namespace LibSpotify
+{
+
+/* FNV-1a hash over the fields a response carries, so a client that already has
+ * the same content can be told so without the content being encoded again.
+ * 0 is never a version, it means the client has none */
+class ContentVersion
+{
+private:
+    uint32_t hash_;
+
+    void addByte( uint8_t byte )
+    {
+        hash_ ^= byte;
+        hash_ *= 16777619u;
+    }
+
+public:
+    ContentVersion() : hash_(2166136261u) {}
+
+    void add( const std::string& str )
+    {
+        for ( std::string::const_iterator it = str.begin(); it != str.end(); it++ )
+            addByte( static_cast<uint8_t>( *it ) );
+        addByte( 0 ); /* so that "ab","c" differs from "a","bc" */
+    }
+
+    void add( uint32_t val )
+    {
+        for ( int shift = 0; shift < 32; shift += 8 )
+            addByte( static_cast<uint8_t>( val >> shift ) );
+    }
+
+    uint32_t get() const { return hash_ ? hash_ : 1; }
+};
+
+} /* namespace LibSpotify */
+#endif /* CONTENTVERSION_H_ */
@@ -42,6 +42,7 @@ Folder::Folder( const TlvContainer* tlv )
 {
     const StringTlv* tlvName = (const StringTlv*) tlv->getTlv(TLV_NAME);
     name_ = (tlvName ? tlvName->getString() : "no-name");
+    id_ = 0;
     parentFolder_ = NULL;
 
     for ( TlvContainer::const_iterator it = tlv->begin(); it != tlv->end(); it++ )
@@ -87,9 +88,9 @@ const std::string& Folder::getName() const
 	return name_;
 }
 
-bool Folder::findPlaylist(const std::string& playlist, Playlist& pl)
+bool Folder::findPlaylist(const std::string& playlist, Playlist& pl) const
 {
-    for (std::deque<LibSpotify::Playlist>::iterator p = playlists_.begin(); p != playlists_.end(); *p++)
+    for (std::deque<LibSpotify::Playlist>::const_iterator p = playlists_.begin(); p != playlists_.end(); *p++)
     {
         if((*p).getLink().compare(playlist) == 0)
         {
@@ -98,7 +99,7 @@ bool Folder::findPlaylist(const std::string& playlist, Playlist& pl)
         }
     }
 
-    for (std::vector<Folder>::iterator f = folders_.begin(); f != folders_.end(); *f++)
+    for (std::vector<Folder>::const_iterator f = folders_.begin(); f != folders_.end(); *f++)
     {
         if (f->findPlaylist(playlist,pl)==true)
             return true;
@@ -158,6 +159,29 @@ Tlv* Folder::toTlv() const
 }
 
 
+static void addToVersion(ContentVersion& version, const Folder& folder)
+{
+    version.add(folder.getName());
+
+    version.add((uint32_t)folder.getFolders().size());
+    for (FolderContainer::const_iterator f = folder.getFolders().begin(); f != folder.getFolders().end(); f++)
+        addToVersion(version, *f);
+
+    version.add((uint32_t)folder.getPlaylists().size());
+    for (PlaylistContainer::const_iterator p = folder.getPlaylists().begin(); p != folder.getPlaylists().end(); p++)
+    {
+        version.add((*p).getName());
+        version.add((*p).getLink());
+    }
+}
+
+uint32_t Folder::getVersion() const
+{
+    ContentVersion version;
+    addToVersion(version, *this);
+    return version.get();
+}
+
 bool Folder::operator==(const Folder& rhs) const
 {
 	return (name_ == rhs.name_ ) &&
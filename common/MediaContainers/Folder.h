@@ -61,7 +61,7 @@ public:
 	void addPlaylist(Playlist& playlist);
 	Folder* getParentFolder();
 
-	bool findPlaylist(const std::string& playlist , Playlist& pl);
+	bool findPlaylist(const std::string& playlist , Playlist& pl) const;
 
 	const std::string& getName() const;
     PlaylistContainer& getPlaylists();
@@ -71,6 +71,8 @@ public:
 	void getAllTracks(std::deque<Track>& allTracks) const;
 
     Tlv* toTlv() const;
+    /* version of the tree as toTlv() sends it, i.e. playlists without their tracks */
+    uint32_t getVersion() const;
 
 	bool operator!=(const Folder& rhs) const;
 	bool operator==(const Folder& rhs) const;
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LibraryChange.h"
+
+namespace LibSpotify
+{
+
+LibraryChange::LibraryChange(LibraryChangeType_t type, const std::string& link) : type_(type), link_(link), folder_(0), position_(0),
+                                                                                  toFolder_(0), toPosition_(0), count_(0), version_(0) { }
+LibraryChange::LibraryChange(const TlvContainer* tlv)
+{
+    const IntTlv* tlvType = (const IntTlv*) tlv->getTlv(TLV_CHANGE_TYPE);
+    const StringTlv* tlvLink = (const StringTlv*) tlv->getTlv(TLV_LINK);
+    const StringTlv* tlvName = (const StringTlv*) tlv->getTlv(TLV_NAME);
+    const IntTlv* tlvFolder = (const IntTlv*) tlv->getTlv(TLV_CHANGE_FOLDER);
+    const IntTlv* tlvPosition = (const IntTlv*) tlv->getTlv(TLV_CHANGE_POSITION);
+    const IntTlv* tlvToFolder = (const IntTlv*) tlv->getTlv(TLV_CHANGE_TO_FOLDER);
+    const IntTlv* tlvToPosition = (const IntTlv*) tlv->getTlv(TLV_CHANGE_TO_POSITION);
+    const IntTlv* tlvCount = (const IntTlv*) tlv->getTlv(TLV_CHANGE_COUNT);
+    const IntTlv* tlvVersion = (const IntTlv*) tlv->getTlv(TLV_CONTENT_VERSION);
+    type_ = (tlvType ? static_cast<LibraryChangeType_t>(tlvType->getVal()) : CHANGE_PLAYLIST_ADDED);
+    link_ = (tlvLink ? tlvLink->getString() : "no-link");
+    name_ = (tlvName ? tlvName->getString() : "");
+    folder_ = (tlvFolder ? tlvFolder->getVal() : 0);
+    position_ = (tlvPosition ? tlvPosition->getVal() : 0);
+    toFolder_ = (tlvToFolder ? tlvToFolder->getVal() : 0);
+    toPosition_ = (tlvToPosition ? tlvToPosition->getVal() : 0);
+    count_ = (tlvCount ? tlvCount->getVal() : 0);
+    version_ = (tlvVersion ? tlvVersion->getVal() : 0);
+
+    for ( TlvContainer::const_iterator it = tlv->begin(); it != tlv->end(); it++ )
+    {
+        if ( (*it)->getType() == TLV_TRACK )
+            tracks_.push_back( Track( (const TlvContainer*)(*it) ) );
+    }
+}
+LibraryChange::~LibraryChange() { }
+
+LibraryChangeType_t LibraryChange::getType() const { return type_; }
+
+const std::string& LibraryChange::getLink() const { return link_; }
+
+void LibraryChange::setName(const std::string& name) { name_ = name; }
+const std::string& LibraryChange::getName() const { return name_; }
+
+void LibraryChange::setPosition(unsigned int folder, unsigned int position) { folder_ = folder; position_ = position; }
+unsigned int LibraryChange::getFolder() const { return folder_; }
+unsigned int LibraryChange::getPosition() const { return position_; }
+
+void LibraryChange::setToPosition(unsigned int folder, unsigned int position) { toFolder_ = folder; toPosition_ = position; }
+unsigned int LibraryChange::getToFolder() const { return toFolder_; }
+unsigned int LibraryChange::getToPosition() const { return toPosition_; }
+
+void LibraryChange::setCount(unsigned int count) { count_ = count; }
+unsigned int LibraryChange::getCount() const { return count_; }
+
+void LibraryChange::addTrack(const Track& track) { tracks_.push_back(track); }
+const std::deque<Track>& LibraryChange::getTracks() const { return tracks_; }
+
+void LibraryChange::setVersion(uint32_t version) { version_ = version; }
+uint32_t LibraryChange::getVersion() const { return version_; }
+
+Tlv* LibraryChange::toTlv() const
+{
+    TlvContainer* change = new TlvContainer( TLV_LIBRARY_CHANGE );
+
+    change->addTlv(TLV_CHANGE_TYPE, type_);
+    change->addTlv(TLV_LINK, link_);
+
+    switch ( type_ )
+    {
+        case CHANGE_PLAYLIST_ADDED:
+        case CHANGE_PLAYLIST_RENAMED:
+            change->addTlv(TLV_NAME, name_);
+            change->addTlv(TLV_CHANGE_FOLDER, folder_);
+            change->addTlv(TLV_CHANGE_POSITION, position_);
+            break;
+
+        case CHANGE_PLAYLIST_REMOVED:
+            change->addTlv(TLV_CHANGE_FOLDER, folder_);
+            change->addTlv(TLV_CHANGE_POSITION, position_);
+            break;
+
+        case CHANGE_PLAYLIST_MOVED:
+            change->addTlv(TLV_CHANGE_FOLDER, folder_);
+            change->addTlv(TLV_CHANGE_POSITION, position_);
+            change->addTlv(TLV_CHANGE_TO_FOLDER, toFolder_);
+            change->addTlv(TLV_CHANGE_TO_POSITION, toPosition_);
+            break;
+
+        case CHANGE_TRACKS_INSERTED:
+            change->addTlv(TLV_CHANGE_POSITION, position_);
+            for ( std::deque<Track>::const_iterator it = tracks_.begin(); it != tracks_.end(); it++ )
+                change->addTlv( it->toTlv() );
+            break;
+
+        case CHANGE_TRACKS_REMOVED:
+            change->addTlv(TLV_CHANGE_POSITION, position_);
+            change->addTlv(TLV_CHANGE_COUNT, count_);
+            break;
+    }
+
+    if ( version_ != 0 )
+        change->addTlv(TLV_CONTENT_VERSION, version_);
+
+    return change;
+}
+
+} /* namespace LibSpotify */
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBRARYCHANGE_H_
+#define LIBRARYCHANGE_H_
+
+#include "Track.h"
+#include "MessageFactory/Tlvs.h"
+#include <string>
+#include <deque>
+
+namespace LibSpotify
+{
+
+/* one step from one version of the root folder to the next, applied in order.
+ * Playlists are addressed by the depth first index of their folder (root is 0,
+ * as the folders come in GET_PLAYLISTS_RSP) and their position in it */
+class LibraryChange
+{
+private:
+    LibraryChangeType_t type_;
+    std::string link_;
+    std::string name_;
+    unsigned int folder_;
+    unsigned int position_;
+    unsigned int toFolder_;
+    unsigned int toPosition_;
+    unsigned int count_;
+    uint32_t version_;
+    std::deque<Track> tracks_;
+
+public:
+    LibraryChange(LibraryChangeType_t type, const std::string& link);
+    LibraryChange(const TlvContainer* tlv);
+    virtual ~LibraryChange();
+
+    LibraryChangeType_t getType() const;
+    const std::string& getLink() const;
+
+    /* playlist added or renamed */
+    void setName(const std::string& name);
+    const std::string& getName() const;
+
+    /* of the playlist, or for track changes only the position of the first track in it */
+    void setPosition(unsigned int folder, unsigned int position);
+    unsigned int getFolder() const;
+    unsigned int getPosition() const;
+
+    /* playlist moved */
+    void setToPosition(unsigned int folder, unsigned int position);
+    unsigned int getToFolder() const;
+    unsigned int getToPosition() const;
+
+    /* tracks removed */
+    void setCount(unsigned int count);
+    unsigned int getCount() const;
+
+    /* tracks inserted */
+    void addTrack(const Track& track);
+    const std::deque<Track>& getTracks() const;
+
+    /* content version of the playlist's tracks after the change */
+    void setVersion(uint32_t version);
+    uint32_t getVersion() const;
+
+    Tlv* toTlv() const;
+};
+
+} /* namespace LibSpotify */
+#endif /* LIBRARYCHANGE_H_ */
@@ -35,6 +35,8 @@
 namespace LibSpotify
 {
 
+static const std::deque<Track> noTracks;
+
 Playlist::Playlist(const std::string& name, const std::string& link) : name_(name), link_(link) { }
 Playlist::Playlist(const std::string& name, const std::string& link, bool nullObject) : name_(name), link_(link) { }
 Playlist::Playlist(const char* name, const char* link) : name_(name), link_(link) { }
@@ -52,7 +54,8 @@ Playlist::Playlist(const TlvContainer* tlv)
     {
         if ( (*it)->getType() == TLV_TRACK )
         {
-            tracks_.push_back( Track( (const TlvContainer*)(*it) ) );
+            Track track( (const TlvContainer*)(*it) );
+            addTrack( track );
         }
     }
 }
@@ -71,7 +74,9 @@ void Playlist::setIsCollaborative(bool isCollaborative)
 
 void Playlist::addTrack(Track& track)
 {
-	tracks_.push_back(track);
+	if (!tracks_.unique())
+		tracks_.reset(tracks_.isNull() ? new std::deque<Track> : new std::deque<Track>(*tracks_));
+	tracks_->push_back(track);
 }
 
 const std::string& Playlist::getName() const
@@ -85,6 +90,11 @@ const std::string& Playlist::getLink() const
 }
 
 const std::deque<Track>& Playlist::getTracks() const
+{
+	return tracks_.isNull() ? noTracks : *tracks_;
+}
+
+Platform::SharedPtr<const std::deque<Track> > Playlist::getSharedTracks() const
 {
 	return tracks_;
 }
@@ -99,11 +109,20 @@ Tlv* Playlist::toTlv() const
     return playlist;
 }
 
+uint32_t Playlist::getTracksVersion(const std::deque<Track>& tracks)
+{
+    ContentVersion version;
+    version.add((uint32_t)tracks.size());
+    for (std::deque<Track>::const_iterator it = tracks.begin(); it != tracks.end(); it++)
+        it->addToVersion(version);
+    return version.get();
+}
+
 bool Playlist::operator==(const Playlist& rhs) const
 {
 	return (name_ == rhs.name_) &&
 			(link_ == rhs.link_) &&
-			(tracks_ == rhs.tracks_) &&
+			(tracks_.get() == rhs.tracks_.get() || getTracks() == rhs.getTracks()) &&
 			(isCollaborative_ == rhs.isCollaborative_) &&
 			(isStarred_ == rhs.isStarred_);
 }
@@ -31,6 +31,7 @@
 #include "MessageFactory/Tlvs.h"
 
 #include "Track.h"
+#include "Platform/Threads/SharedPtr.h"
 #include <list>
 #include <deque>
 #include <string>
@@ -43,7 +44,9 @@ class Playlist
 protected:
 	std::string name_;
 	std::string link_;
-	std::deque<Track> tracks_;
+	/* shared between copies of the playlist and never changed once shared,
+	 * so handing out a playlist (or a folder of them) does not copy its tracks */
+	Platform::SharedPtr<std::deque<Track> > tracks_;
 	bool isCollaborative_;
 	bool isStarred_;
 public:
@@ -59,8 +62,13 @@ public:
 	const std::string& getName() const;
 	const std::string& getLink() const;
 	const std::deque<Track>& getTracks() const;
+	/* the shared track list itself (NULL if there are no tracks), for holding on to
+	 * the tracks without copying them */
+	Platform::SharedPtr<const std::deque<Track> > getSharedTracks() const;
 
     Tlv* toTlv() const;
+    /* version of a list of tracks, see ContentVersion */
+    static uint32_t getTracksVersion(const std::deque<Track>& tracks);
 
     bool operator==(const Playlist& rhs) const;
 	bool operator!=(const Playlist& rhs) const;
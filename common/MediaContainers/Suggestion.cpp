@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Suggestion.h"
+
+namespace LibSpotify
+{
+
+Suggestion::Suggestion(SuggestionType_t type, const std::string& name, const std::string& link) : type_(type), name_(name), link_(link) { }
+Suggestion::Suggestion(const TlvContainer* tlv)
+{
+    const IntTlv* tlvType = (const IntTlv*) tlv->getTlv(TLV_SUGGESTION_TYPE);
+    const StringTlv* tlvName = (const StringTlv*) tlv->getTlv(TLV_NAME);
+    const StringTlv* tlvLink = (const StringTlv*) tlv->getTlv(TLV_LINK);
+    type_ = (tlvType ? static_cast<SuggestionType_t>(tlvType->getVal()) : SUGGESTION_TRACK);
+    name_ = (tlvName ? tlvName->getString() : "no-name");
+    link_ = (tlvLink ? tlvLink->getString() : "no-link");
+}
+Suggestion::~Suggestion() { }
+
+SuggestionType_t Suggestion::getType() const { return type_; }
+
+const std::string& Suggestion::getName() const { return name_; }
+
+const std::string& Suggestion::getLink() const { return link_; }
+
+Tlv* Suggestion::toTlv() const
+{
+    TlvContainer* suggestion = new TlvContainer( TLV_SUGGESTION );
+
+    suggestion->addTlv(TLV_SUGGESTION_TYPE, type_);
+    suggestion->addTlv(TLV_NAME, name_);
+    suggestion->addTlv(TLV_LINK, link_);
+
+    return suggestion;
+}
+
+} /* namespace LibSpotify */
@@ -31,9 +31,11 @@
 namespace LibSpotify
 {
 
-Track::Track(const std::string& name, const std::string& link) : name_(name), link_(link), index_(-1) { }
-Track::Track(const char* name, const char* link) : name_(name), link_(link), index_(-1) { }
-Track::Track( const TlvContainer* tlv )
+Track::Track(const std::string& name, const std::string& link) : name_(name), link_(link), isStarred_(false), isLocal_(false), isAutoLinked_(false),
+                                                                    durationMillisecs_(0), index_(-1) { }
+Track::Track(const char* name, const char* link) : name_(name), link_(link), isStarred_(false), isLocal_(false), isAutoLinked_(false),
+                                                   durationMillisecs_(0), index_(-1) { }
+Track::Track( const TlvContainer* tlv ) : isStarred_(false), isLocal_(false), isAutoLinked_(false)
 {
     const StringTlv* tlvName = (const StringTlv*) tlv->getTlv(TLV_NAME);
     const StringTlv* tlvLink = (const StringTlv*) tlv->getTlv(TLV_LINK);
@@ -122,6 +124,22 @@ Tlv* Track::toTlv() const
     return track;
 }
 
+void Track::addToVersion(ContentVersion& version) const
+{
+    version.add(link_);
+    version.add(name_);
+    version.add((uint32_t)artistList_.size());
+    for(std::vector<Artist>::const_iterator it = artistList_.begin(); it != artistList_.end(); it++)
+    {
+        version.add(it->getName());
+        version.add(it->getLink());
+    }
+    version.add(album_);
+    version.add(albumLink_);
+    version.add(durationMillisecs_);
+    version.add((uint32_t)index_);
+}
+
 bool Track::operator==(const Track& rhs) const
 {
 	return (name_ == rhs.name_) &&
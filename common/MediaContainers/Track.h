@@ -29,6 +29,7 @@
 #define TRACK_H_
 
 #include "Artist.h"
+#include "ContentVersion.h"
 #include "MessageFactory/MessageEncoder.h"
 #include "MessageFactory/Tlvs.h"
 #include <string>
@@ -78,6 +79,8 @@ public:
 	void setIndex(int index);
 
 	void write(MessageEncoder* msg) const;
+	/* the fields toTlv() sends */
+	void addToVersion(ContentVersion& version) const;
 	Tlv* toTlv() const;
 
 	bool operator!=(const Track& rhs) const;
@@ -26,8 +26,46 @@
  */
 
 #include "MediaInterface.h"
+#include "Platform/Utils/Utils.h"
+#include <vector>
 
-MediaInterface::MediaInterface()
+void IMediaInterfaceCallbackSubscriber::getImageFileResponse( MediaInterfaceRequestId reqId, const std::string& path )
+{
+    uint32_t size = 0;
+    int fd = openFile( path, &size );
+    std::vector<uint8_t> data( size );
+
+    if ( fd >= 0 && size > 0 && readFile( fd, 0, &data[0], size ) == (int)size )
+        getImageResponse( reqId, &data[0], size );
+    else
+        getImageResponse( reqId, NULL, 0 );
+
+    if ( fd >= 0 )
+        closeFile( fd );
+}
+
+void IMediaInterfaceCallbackSubscriber::genericSearchPartCallback( MediaInterfaceRequestId reqId, const std::deque<Track>& listOfTracks )
+{
+    genericSearchCallback( reqId, listOfTracks, "" );
+}
+
+void IMediaInterfaceCallbackSubscriber::searchSuggestResponse( MediaInterfaceRequestId reqId, const std::vector<Suggestion>& suggestions )
+{
+}
+
+void IMediaInterfaceCallbackSubscriber::librarySubscribeResponse( MediaInterfaceRequestId reqId, unsigned int epoch, unsigned int version, const std::vector<LibraryChange>& changes, const Folder* resync )
+{
+}
+
+void IMediaInterfaceCallbackSubscriber::libraryChangedInd( unsigned int from, unsigned int to, const std::vector<LibraryChange>& changes, const Folder* resync )
+{
+}
+
+void IMediaInterfaceCallbackSubscriber::requestFailed( MediaInterfaceRequestId reqId, FailureCause_t cause )
+{
+}
+
+MediaInterface::MediaInterface() : callbackSubscribers_(new MediaInterfaceCallbackSubscriberSet)
 {
 }
 
@@ -35,17 +73,79 @@ MediaInterface::~MediaInterface()
 {
 }
 
+MediaInterface::CallbackSubscribers MediaInterface::getCallbackSubscribers()
+{
+    callbackSubscriberMtx_.lock();
+    CallbackSubscriberSetPtr subscribers(callbackSubscribers_);
+    callbackSubscriberMtx_.unlock();
+    return CallbackSubscribers(*this, subscribers);
+}
+
+void MediaInterface::releaseCallbackSubscribers(CallbackSubscriberSetPtr& subscribers)
+{
+    subscribers.reset();
+    if (retiredCallbackSubscriberCount_.get() == 0)
+        return; /* nobody is waiting */
+
+    callbackSubscriberMtx_.lock();
+    pruneRetiredCallbackSubscribers();
+    callbackSubscribersReleased_.broadcast();
+    callbackSubscriberMtx_.unlock();
+}
+
+/* must hold callbackSubscriberMtx_ */
+void MediaInterface::replaceCallbackSubscribers(MediaInterfaceCallbackSubscriberSet* subscribers)
+{
+    if (!callbackSubscribers_.unique())
+        retiredCallbackSubscribers_.push_back(callbackSubscribers_);
+    callbackSubscribers_.reset(subscribers);
+    pruneRetiredCallbackSubscribers();
+}
+
+/* must hold callbackSubscriberMtx_ */
+void MediaInterface::pruneRetiredCallbackSubscribers()
+{
+    /* the ones only we hold any more are done with */
+    for (size_t i = 0; i < retiredCallbackSubscribers_.size(); )
+    {
+        if (retiredCallbackSubscribers_[i].unique())
+        {
+            retiredCallbackSubscribers_[i] = retiredCallbackSubscribers_.back();
+            retiredCallbackSubscribers_.pop_back();
+        }
+        else i++;
+    }
+    retiredCallbackSubscriberCount_.set(retiredCallbackSubscribers_.size());
+}
+
 void MediaInterface::registerForCallbacks(IMediaInterfaceCallbackSubscriber& subscriber)
 {
     callbackSubscriberMtx_.lock();
-    callbackSubscriberList_.insert(&subscriber);
+    MediaInterfaceCallbackSubscriberSet* subscribers = new MediaInterfaceCallbackSubscriberSet(*callbackSubscribers_);
+    subscribers->insert(&subscriber);
+    replaceCallbackSubscribers(subscribers);
     callbackSubscriberMtx_.unlock();
 }
 
 void MediaInterface::unRegisterForCallbacks(IMediaInterfaceCallbackSubscriber& subscriber)
 {
     callbackSubscriberMtx_.lock();
-    callbackSubscriberList_.erase(&subscriber);
+    MediaInterfaceCallbackSubscriberSet* subscribers = new MediaInterfaceCallbackSubscriberSet(*callbackSubscribers_);
+    subscribers->erase(&subscriber);
+    replaceCallbackSubscribers(subscribers);
+
+    /* the subscriber is usually about to be deleted, wait out any callbacks still
+     * being made to it from a set that was taken before it was removed */
+    for (;;)
+    {
+        pruneRetiredCallbackSubscribers();
+        bool inUse = false;
+        for (size_t i = 0; !inUse && i < retiredCallbackSubscribers_.size(); i++)
+            inUse = retiredCallbackSubscribers_[i]->count(&subscriber) > 0;
+        if (!inUse)
+            break;
+        callbackSubscribersReleased_.wait(callbackSubscriberMtx_);
+    }
     callbackSubscriberMtx_.unlock();
 }
 
@@ -29,12 +29,18 @@
 #define MEDIAINTERFACE_H_
 
 #include "Platform/Threads/Mutex.h"
+#include "Platform/Threads/Condition.h"
+#include "Platform/Threads/Atomic.h"
+#include "Platform/Threads/SharedPtr.h"
 #include <set>
+#include <vector>
 #include <string>
 
 #include "MediaContainers/Folder.h"
 #include "MediaContainers/Album.h"
 #include "MediaContainers/Track.h"
+#include "MediaContainers/Suggestion.h"
+#include "MediaContainers/LibraryChange.h"
 #include <deque>
 
 using namespace LibSpotify;
@@ -52,32 +58,81 @@ public:
     virtual void getPlaylistsResponse( MediaInterfaceRequestId reqId, const Folder& rootfolder ) = 0;
     virtual void getTracksResponse( MediaInterfaceRequestId reqId, const std::deque<Track>& tracks ) = 0;
     virtual void getImageResponse( MediaInterfaceRequestId reqId, const void* data, size_t dataSize ) = 0;
+    /* the image is in a file, subscribers that can send it on without reading it override this.
+     * By default it is read and passed to getImageResponse() */
+    virtual void getImageFileResponse( MediaInterfaceRequestId reqId, const std::string& path );
     virtual void getAlbumResponse( MediaInterfaceRequestId reqId, const Album& album ) = 0;
     virtual void genericSearchCallback( MediaInterfaceRequestId reqId, const std::deque<Track>& listOfTracks, const std::string& didYouMean) = 0;
+    /* a search answers in parts as results come in, genericSearchCallback() always brings the last one.
+     * By default each earlier part is passed on to genericSearchCallback() as well */
+    virtual void genericSearchPartCallback( MediaInterfaceRequestId reqId, const std::deque<Track>& listOfTracks );
+    /* ignored by default, only subscribers that ask for suggestions get them */
+    virtual void searchSuggestResponse( MediaInterfaceRequestId reqId, const std::vector<Suggestion>& suggestions );
+    /* the changes since the version subscribed from, or the whole root folder (resync != NULL) when they
+     * aren't known any more or the version is of another epoch. Ignored by default, as is libraryChangedInd() */
+    virtual void librarySubscribeResponse( MediaInterfaceRequestId reqId, unsigned int epoch, unsigned int version, const std::vector<LibraryChange>& changes, const Folder* resync );
+    /* every change of the root folder from version from to to, sent to every subscriber after rootFolderUpdatedInd() */
+    virtual void libraryChangedInd( unsigned int from, unsigned int to, const std::vector<LibraryChange>& changes, const Folder* resync );
     virtual void getStatusResponse( MediaInterfaceRequestId reqId, PlaybackState_t state, bool repeatStatus, bool shuffleStatus, const Track& currentTrack, unsigned int progress ) = 0;
     virtual void getStatusResponse( MediaInterfaceRequestId reqId, PlaybackState_t state, bool repeatStatus, bool shuffleStatus ) = 0;
+    /* instead of the response, e.g. when spotify never delivered what was asked for. Ignored by default */
+    virtual void requestFailed( MediaInterfaceRequestId reqId, FailureCause_t cause );
 
 };
 
 
 class MediaInterface
 {
-private:
-
 protected:
     /***********************
      * Callback subscription
      ***********************/
-    Platform::Mutex callbackSubscriberMtx_;
     typedef std::set<IMediaInterfaceCallbackSubscriber*> MediaInterfaceCallbackSubscriberSet;
-    MediaInterfaceCallbackSubscriberSet callbackSubscriberList_;
+    typedef Platform::SharedPtr<const MediaInterfaceCallbackSubscriberSet> CallbackSubscriberSetPtr;
+
+    /* a set of subscribers to call, letting go of it wakes an unRegisterForCallbacks()
+     * waiting for the set to be done with */
+    class CallbackSubscribers
+    {
+    private:
+        MediaInterface& owner_;
+        CallbackSubscriberSetPtr set_;
+        CallbackSubscribers& operator=(const CallbackSubscribers&);
+    public:
+        CallbackSubscribers(MediaInterface& owner, const CallbackSubscriberSetPtr& set) : owner_(owner), set_(set) {}
+        CallbackSubscribers(const CallbackSubscribers& from) : owner_(from.owner_), set_(from.set_) {}
+        ~CallbackSubscribers() { owner_.releaseCallbackSubscribers(set_); }
+        const MediaInterfaceCallbackSubscriberSet* operator->() const { return set_.get(); }
+        const MediaInterfaceCallbackSubscriberSet& operator*() const { return *set_; }
+    };
+    friend class CallbackSubscribers;
+
+private:
+    void replaceCallbackSubscribers(MediaInterfaceCallbackSubscriberSet* subscribers);
+    void pruneRetiredCallbackSubscribers();
+    void releaseCallbackSubscribers(CallbackSubscriberSetPtr& subscribers);
+
+protected:
+    /* Copied on every (un)registration so that callbacks can be made without holding any lock,
+     * the mutex only guards swapping the pointer. */
+    Platform::Mutex callbackSubscriberMtx_;
+    CallbackSubscriberSetPtr callbackSubscribers_;
+    /* replaced sets that may still be iterated, see unRegisterForCallbacks() */
+    std::vector<CallbackSubscriberSetPtr> retiredCallbackSubscribers_;
+    /* how many there are, so that callers only take the lock to let go of a set when someone may be waiting */
+    Platform::AtomicInt retiredCallbackSubscriberCount_;
+    Platform::Condition callbackSubscribersReleased_;
+
+    /* hold on to the result while calling the subscribers in it, a subscriber that unregisters
+     * meanwhile isn't let go until it's released (so don't unregister from within a callback) */
+    CallbackSubscribers getCallbackSubscribers();
 
 public:
     MediaInterface();
     virtual ~MediaInterface();
 
     void registerForCallbacks(IMediaInterfaceCallbackSubscriber& subscriber);
-    void unRegisterForCallbacks(IMediaInterfaceCallbackSubscriber& subscriber);
+    virtual void unRegisterForCallbacks(IMediaInterfaceCallbackSubscriber& subscriber);
 
     virtual void getImage( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId ) = 0;
     virtual void previous() = 0;
@@ -93,6 +148,9 @@ public:
     virtual void play( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId ) = 0;
     virtual void getAlbum( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId ) = 0;
     virtual void search( std::string query, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId ) = 0;
+    virtual void suggest( std::string prefix, unsigned int maxSuggestions, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId ) = 0;
+    /* epoch and version are those of the last librarySubscribeResponse(), 0 if there was none */
+    virtual void subscribeLibrary( unsigned int epoch, unsigned int version, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId ) = 0;
     virtual void addAudio() = 0;
 
 };
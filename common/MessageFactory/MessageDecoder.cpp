@@ -138,6 +138,201 @@ TlvContainer* MessageDecoder::decodeImage()
     return groupTlv;
 }
 
+TlvContainer* MessageDecoder::decodeMetric()
+{
+    uint32_t end;
+    uint32_t len = getCurrentTlvLen();
+    TlvContainer* groupTlv = new TlvContainer(TLV_METRIC);
+
+    enterTlvGroup();
+    end = len + rpos_;
+
+    while (rpos_ < end && !hasError_)
+    {
+        if(validateLength(end)) break;
+
+        switch(getCurrentTlv())
+        {
+            case TLV_NAME:
+            {
+                groupTlv->addTlv(getCurrentTlv(), getTlvData(), getCurrentTlvLen());
+                nextTlv();
+            }
+            break;
+
+            case TLV_METRIC_TYPE:
+            case TLV_METRIC_VALUE:
+            case TLV_METRIC_P50:
+            case TLV_METRIC_P90:
+            case TLV_METRIC_P99:
+            case TLV_METRIC_MAX:
+            {
+                groupTlv->addTlv(getCurrentTlv(), getTlvIntData());
+                nextTlv();
+            }
+            break;
+
+            default:
+                log(LOG_NOTICE) << "Unknown TLV 0x" << std::hex << getCurrentTlv() << std::dec << " at byte " << rpos_;
+                hasUnknownTlv_ = true;
+                nextTlv();
+                break;
+        }
+    }
+
+    /*validation of length field in group tlv*/
+    if (!hasError_ && rpos_ != end )
+    {
+        log(LOG_NOTICE) << "TLV 0x" << std::hex << getCurrentTlv() << std::dec << " has bad length " << len << ", ends at " << rpos_ << ", said it would end at " << end;
+        hasError_ = true;
+    }
+    return groupTlv;
+}
+
+TlvContainer* MessageDecoder::decodeStats()
+{
+    uint32_t end;
+    uint32_t len = getCurrentTlvLen();
+    TlvContainer* groupTlv = new TlvContainer(TLV_STATS);
+
+    enterTlvGroup();
+    end = len + rpos_;
+
+    while (rpos_ < end && !hasError_)
+    {
+        if(validateLength(end)) break;
+
+        switch(getCurrentTlv())
+        {
+            case TLV_METRIC:
+            {
+                groupTlv->addTlv(decodeMetric());
+            }
+            break;
+
+            default:
+                log(LOG_NOTICE) << "Unknown TLV 0x" << std::hex << getCurrentTlv() << std::dec << " at byte " << rpos_;
+                hasUnknownTlv_ = true;
+                nextTlv();
+                break;
+        }
+    }
+
+    /*validation of length field in group tlv*/
+    if (!hasError_ && rpos_ != end )
+    {
+        log(LOG_NOTICE) << "TLV 0x" << std::hex << getCurrentTlv() << std::dec << " has bad length " << len << ", ends at " << rpos_ << ", said it would end at " << end;
+        hasError_ = true;
+    }
+    return groupTlv;
+}
+
+TlvContainer* MessageDecoder::decodeSuggestion()
+{
+    uint32_t end;
+    uint32_t len = getCurrentTlvLen();
+    TlvContainer* groupTlv = new TlvContainer(TLV_SUGGESTION);
+
+    enterTlvGroup();
+    end = len + rpos_;
+
+    while (rpos_ < end && !hasError_)
+    {
+        if(validateLength(end)) break;
+
+        switch(getCurrentTlv())
+        {
+            case TLV_NAME:
+            case TLV_LINK:
+            {
+                groupTlv->addTlv(getCurrentTlv(), getTlvData(), getCurrentTlvLen());
+                nextTlv();
+            }
+            break;
+
+            case TLV_SUGGESTION_TYPE:
+            {
+                groupTlv->addTlv(getCurrentTlv(), getTlvIntData());
+                nextTlv();
+            }
+            break;
+
+            default:
+                log(LOG_NOTICE) << "Unknown TLV 0x" << std::hex << getCurrentTlv() << std::dec << " at byte " << rpos_;
+                hasUnknownTlv_ = true;
+                nextTlv();
+                break;
+        }
+    }
+
+    /*validation of length field in group tlv*/
+    if (!hasError_ && rpos_ != end )
+    {
+        log(LOG_NOTICE) << "TLV 0x" << std::hex << getCurrentTlv() << std::dec << " has bad length " << len << ", ends at " << rpos_ << ", said it would end at " << end;
+        hasError_ = true;
+    }
+    return groupTlv;
+}
+
+TlvContainer* MessageDecoder::decodeLibraryChange()
+{
+    uint32_t end;
+    uint32_t len = getCurrentTlvLen();
+    TlvContainer* groupTlv = new TlvContainer(TLV_LIBRARY_CHANGE);
+
+    enterTlvGroup();
+    end = len + rpos_;
+
+    while (rpos_ < end && !hasError_)
+    {
+        if(validateLength(end)) break;
+
+        switch(getCurrentTlv())
+        {
+            case TLV_NAME:
+            case TLV_LINK:
+            {
+                groupTlv->addTlv(getCurrentTlv(), getTlvData(), getCurrentTlvLen());
+                nextTlv();
+            }
+            break;
+
+            case TLV_CHANGE_TYPE:
+            case TLV_CHANGE_FOLDER:
+            case TLV_CHANGE_POSITION:
+            case TLV_CHANGE_TO_FOLDER:
+            case TLV_CHANGE_TO_POSITION:
+            case TLV_CHANGE_COUNT:
+            case TLV_CONTENT_VERSION:
+            {
+                groupTlv->addTlv(getCurrentTlv(), getTlvIntData());
+                nextTlv();
+            }
+            break;
+
+            case TLV_TRACK:
+            {
+                groupTlv->addTlv(decodeTrack());
+            }
+            break;
+
+            default:
+                log(LOG_NOTICE) << "Unknown TLV 0x" << std::hex << getCurrentTlv() << std::dec << " at byte " << rpos_;
+                hasUnknownTlv_ = true;
+                nextTlv();
+                break;
+        }
+    }
+
+    /*validation of length field in group tlv*/
+    if (!hasError_ && rpos_ != end )
+    {
+        log(LOG_NOTICE) << "TLV 0x" << std::hex << getCurrentTlv() << std::dec << " has bad length " << len << ", ends at " << rpos_ << ", said it would end at " << end;
+        hasError_ = true;
+    }
+    return groupTlv;
+}
+
 TlvContainer* MessageDecoder::decodeArtist()
 {
     uint32_t end;
@@ -364,6 +559,12 @@ TlvContainer* MessageDecoder::decodePlaylist()
             }
             break;
 
+            case TLV_TRACK:
+            {
+                groupTlv->addTlv(decodeTrack());
+            }
+            break;
+
             case TLV_NAME:
             {
                 groupTlv->addTlv(getCurrentTlv(), getTlvData(), getCurrentTlvLen());
@@ -507,6 +708,24 @@ void MessageDecoder::decodeTlvs(TlvContainer* parent, uint32_t len)
             }
             break;
 
+            case TLV_STATS:
+            {
+                parent->addTlv(decodeStats());
+            }
+            break;
+
+            case TLV_SUGGESTION:
+            {
+                parent->addTlv(decodeSuggestion());
+            }
+            break;
+
+            case TLV_LIBRARY_CHANGE:
+            {
+                parent->addTlv(decodeLibraryChange());
+            }
+            break;
+
             /* String TLVs */
 
             case TLV_SEARCH_QUERY:
@@ -528,8 +747,19 @@ void MessageDecoder::decodeTlvs(TlvContainer* parent, uint32_t len)
             case TLV_PLAY_MODE_REPEAT:
             case TLV_PROTOCOL_VERSION_MAJOR:
             case TLV_PROTOCOL_VERSION_MINOR:
+            case TLV_MORE_TO_COME:
             case TLV_FAILURE:
             case TLV_TRACK_INDEX:
+            case TLV_SEARCH_COUNT:
+            case TLV_RESULT_OFFSET:
+            case TLV_RESULT_COUNT:
+            case TLV_RESULT_TOTAL:
+            case TLV_RESULT_CURSOR:
+            case TLV_CONTENT_VERSION:
+            case TLV_NOT_MODIFIED:
+            case TLV_LIBRARY_EPOCH:
+            case TLV_LIBRARY_VERSION:
+            case TLV_LIBRARY_RESYNC:
             case TLV_AUDIO_CHANNELS:
             case TLV_AUDIO_RATE:
             case TLV_AUDIO_NOF_SAMPLES:
@@ -56,6 +56,10 @@ private:
     TlvContainer* decodeAlbum();
     TlvContainer* decodeArtist();
     TlvContainer* decodeImage();
+    TlvContainer* decodeMetric();
+    TlvContainer* decodeStats();
+    TlvContainer* decodeSuggestion();
+    TlvContainer* decodeLibraryChange();
     void decodeTlvs(TlvContainer* parent, uint32_t endPos);
 
     Message* decodeMessage(const uint8_t* message);
@@ -27,6 +27,7 @@
 
 #include "MessageEncoder.h"
 #include "Platform/Socket/Socket.h"
+#include "Platform/Utils/Utils.h"
 #include "applog.h"
 #include <string.h>
 #include <stdlib.h>
@@ -52,6 +53,9 @@ void MessageEncoder::init()
 	msgbuf = (char*) malloc(1000);
 	cursize = 1000;
 	wpos = sizeof(header_t);
+	file.fd = -1;
+	file.pos = 0;
+	file.len = 0;
 }
 
 MessageEncoder::MessageEncoder()
@@ -70,12 +74,17 @@ MessageEncoder::MessageEncoder(const MessageEncoder& from)
     cursize = from.getLength();
     msgbuf = (char*) malloc(cursize);
     wpos = cursize;
+    file.fd = -1;
+    file.pos = 0;
+    file.len = 0;
 }
 
 MessageEncoder::~MessageEncoder()
 {
 	free(msgbuf);
 	msgbuf=0;
+	if (file.fd >= 0)
+	    closeFile(file.fd);
 }
 
 
@@ -92,6 +101,16 @@ unsigned int MessageEncoder::getLength() const
     return wpos;
 }
 
+const filerange_t* MessageEncoder::getFileRange() const
+{
+    return (file.fd >= 0) ? &file : NULL;
+}
+
+uint32_t MessageEncoder::fileBytesAfter(unsigned int pos) const
+{
+    return (file.fd >= 0 && file.pos > pos) ? file.len : 0;
+}
+
 
 /*
  * Header manipulation
@@ -170,6 +189,27 @@ void MessageEncoder::encode(TlvType_t tlv, const uint8_t* data, uint32_t len)
     memcpy(val_, data, len);
 }
 
+void MessageEncoder::encodeFile(TlvType_t tlv, const std::string& path)
+{
+    uint32_t len = 0;
+    int fd = (file.fd < 0) ? openFile(path, &len) : -1;
+    if (fd < 0)
+    {
+        log(LOG_WARN) << "Could not attach " << path;
+        len = 0;
+    }
+
+    tlvheader_t* header = (tlvheader_t*) getBufferForTlv(0);
+    header->type = htonl(tlv);
+    header->len = htonl(len);
+
+    if (fd < 0)
+        return;
+
+    file.fd = fd;
+    file.pos = wpos;
+    file.len = len;
+}
 
 tlvgroup_t* MessageEncoder::createNewGroup(TlvType_t tlv)
 {
@@ -185,14 +225,14 @@ tlvgroup_t* MessageEncoder::createNewGroup(TlvType_t tlv)
 void MessageEncoder::finalizeGroup(tlvgroup_t* group)
 {
 	tlvheader_t* header = (tlvheader_t*)&msgbuf[group->startpos];
-	header->len = (uint32_t) htonl(wpos - (group->startpos + sizeof(tlvheader_t)));
+	header->len = (uint32_t) htonl(wpos + fileBytesAfter(group->startpos) - (group->startpos + sizeof(tlvheader_t)));
 
 	free(group);
 }
 
 void MessageEncoder::finalize()
 {
-	getHeader()->len = htonl(wpos);
+	getHeader()->len = htonl(wpos + fileBytesAfter(0));
 }
 
 
@@ -200,12 +240,14 @@ void MessageEncoder::finalize()
 
 void MessageEncoder::printHex()
 {
-	uint32_t len = ntohl(getHeader()->len);
-	printHexMsg((uint8_t*)msgbuf, len);
+	printHexMsg((uint8_t*)msgbuf, wpos);
 }
 
 void printHexMsg(const uint8_t* msgbuf, uint32_t len)
 {
+	if(!logEnabled(LOG_DEBUG))
+		return;
+
 	std::string message;
 	int rowCount = 0;
 	for(uint32_t i=0; i<len; i++)
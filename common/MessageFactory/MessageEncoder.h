@@ -46,13 +46,23 @@ typedef struct {
 
 typedef struct tlvgroup_s tlvgroup_t;
 
+/* Payload that is not in the buffer but sent straight from a file,
+ * it belongs at offset pos of the buffer */
+typedef struct {
+	int fd;
+	unsigned int pos;
+	uint32_t len;
+}filerange_t;
+
 
 class MessageEncoder {
 private:
 	char* msgbuf;
 	unsigned int cursize;
 	unsigned int wpos;
+	filerange_t file;
 	void init();
+	uint32_t fileBytesAfter(unsigned int pos) const;
 public:
 	MessageEncoder();
 	MessageEncoder(MessageType_t type);
@@ -61,6 +71,8 @@ public:
 
 	const char* getBuffer() const;
 	unsigned int getLength() const;
+	/* NULL unless encodeFile() was used */
+	const filerange_t* getFileRange() const;
 
 	void setId(unsigned int id);
 	header_t* getHeader();
@@ -69,6 +81,9 @@ public:
 	void encode(TlvType_t tlv, unsigned int val);
 	void encode(TlvType_t tlv, const std::string & str);
     void encode(TlvType_t tlv, const uint8_t* data, uint32_t len);
+    /* only the tlv header goes into the buffer, the file content is sent from the file.
+     * At most one file per message, an empty tlv is encoded if the file can't be used */
+    void encodeFile(TlvType_t tlv, const std::string& path);
 	tlvgroup_t* createNewGroup(TlvType_t tlv);
 	void finalizeGroup(tlvgroup_t* group);
 	void finalize();
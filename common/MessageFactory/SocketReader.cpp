@@ -27,6 +27,8 @@
 
 #include "Platform/Socket/Socket.h"
 #include "SocketReader.h"
+#include "Metrics/Metrics.h"
+#include "Tracing/FlightRecorder.h"
 #include "applog.h"
 #include <string.h>
 
@@ -35,7 +37,9 @@ SocketReader::SocketReader(Socket* socket) : buf(NULL),
                                              header_received(false),
                                              recvlen(0),
                                              totlen(0),
-                                             socket_(socket)
+                                             socket_(socket),
+                                             bytesRead_(Metrics::Registry::instance().getCounter("socket.bytes_read")),
+                                             messagesRead_(Metrics::Registry::instance().getCounter("socket.messages_read"))
 {
 }
 
@@ -79,6 +83,8 @@ int SocketReader::doread()
     }
 
     recvlen += n;
+    bytesRead_.add(n);
+    Tracing::FlightRecorder::instance().record(Tracing::FR_SOCKET_READ, n);
 
     if (!header_received && recvlen >= sizeof(header_t))
     {
@@ -101,6 +107,9 @@ int SocketReader::doread()
         memcpy(buf, &recv_header, sizeof(header_t));
     }
 
+    if (done())
+        messagesRead_.increment();
+
     return n;
 }
 
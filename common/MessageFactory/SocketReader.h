@@ -32,6 +32,7 @@
 #include <stdint.h>
 
 class Socket;
+namespace Metrics { class Counter; }
 class SocketReader
 {
 private:
@@ -43,6 +44,9 @@ private:
 
     Socket* socket_;
 
+    Metrics::Counter& bytesRead_;
+    Metrics::Counter& messagesRead_;
+
 public:
     SocketReader(Socket* socket);
 
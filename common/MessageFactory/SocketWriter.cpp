@@ -31,12 +31,19 @@
 #include "SocketWriter.h"
 #include "Platform/Socket/Socket.h"
 #include "MessageEncoder.h"
+#include "Metrics/Metrics.h"
+#include "Tracing/FlightRecorder.h"
 #include "applog.h"
 
 
 #define WRITE_MAX_BYTES (4096)
 
-SocketWriter::SocketWriter(Socket* socket) : socket_(socket), messageEncoder_(NULL), sentLen(0)
+SocketWriter::SocketWriter(Socket* socket) : socket_(socket),
+                                             messageEncoder_(NULL),
+                                             sentLen(0),
+                                             bytesWritten_(Metrics::Registry::instance().getCounter("socket.bytes_written")),
+                                             messagesWritten_(Metrics::Registry::instance().getCounter("socket.messages_written")),
+                                             bytesSentFromFile_(Metrics::Registry::instance().getCounter("socket.bytes_sent_from_file"))
 {
 }
 
@@ -51,22 +58,44 @@ int SocketWriter::doWrite()
     if (messageEncoder_ == NULL)
         return 0;
 
-    int toWrite = messageEncoder_->getLength() - sentLen;
-    const char *fromBuf = messageEncoder_->getBuffer() + sentLen;
+    /* a file range splits the message into buffer, file, buffer */
+    const filerange_t* file = messageEncoder_->getFileRange();
+    unsigned int fileLen = file ? file->len : 0;
+    unsigned int totalLen = messageEncoder_->getLength() + fileLen;
+    int len;
 
-    if (toWrite > WRITE_MAX_BYTES)
-        toWrite = WRITE_MAX_BYTES;
+    if (file && sentLen >= file->pos && sentLen < file->pos + fileLen)
+    {
+        /* no need to limit, the kernel only takes what fits in the socket buffer */
+        len = socket_->SendFile(file->fd, sentLen - file->pos, file->pos + fileLen - sentLen);
+        if (len > 0)
+            bytesSentFromFile_.add(len);
+        else if (len < 0)
+            log(LOG_WARN) << "Attached file could not be sent, " << file->len << " bytes expected";
+    }
+    else
+    {
+        unsigned int bufPos = (file && sentLen >= file->pos) ? sentLen - fileLen : sentLen;
+        unsigned int bufEnd = (file && sentLen < file->pos) ? file->pos : messageEncoder_->getLength();
+        int toWrite = bufEnd - bufPos;
 
-    int len = socket_->Send(fromBuf, toWrite);
+        if (toWrite > WRITE_MAX_BYTES)
+            toWrite = WRITE_MAX_BYTES;
+
+        len = socket_->Send(messageEncoder_->getBuffer() + bufPos, toWrite);
+    }
 
     if (len > 0)
     {
         sentLen += len ;
+        bytesWritten_.add(len);
+        Tracing::FlightRecorder::instance().record(Tracing::FR_SOCKET_WRITE, len);
         log(LOG_DEBUG) << "Sent: " << len << " bytes";
 
-        if (sentLen >= messageEncoder_->getLength())
+        if (sentLen >= totalLen)
         {
-            log(LOG_DEBUG) << "Send complete " << messageEncoder_->getLength() << " bytes";
+            log(LOG_DEBUG) << "Send complete " << totalLen << " bytes";
+            messagesWritten_.increment();
             reset();
         }
         return 1;
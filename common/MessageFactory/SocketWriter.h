@@ -30,6 +30,7 @@
 #define SOCKETWRITER_H_
 class Socket;
 class MessageEncoder;
+namespace Metrics { class Counter; }
 
 class SocketWriter
 {
@@ -46,6 +47,10 @@ private:
     Socket* socket_;
     MessageEncoder *messageEncoder_;
     unsigned int sentLen;
+
+    Metrics::Counter& bytesWritten_;
+    Metrics::Counter& messagesWritten_;
+    Metrics::Counter& bytesSentFromFile_;
 };
 
 #endif /* SOCKETWRITER_H_ */
@@ -74,6 +74,13 @@ const char* messageTypeToString(const MessageType_t type)
         STR(GET_ALBUM_RSP);
         STR(GET_ARTIST_REQ);
         STR(GET_ARTIST_RSP);
+        STR(GET_STATS_REQ);
+        STR(GET_STATS_RSP);
+        STR(SEARCH_SUGGEST_REQ);
+        STR(SEARCH_SUGGEST_RSP);
+        STR(LIBRARY_SUBSCRIBE_REQ);
+        STR(LIBRARY_SUBSCRIBE_RSP);
+        STR(LIBRARY_CHANGED_IND);
     }
     return "Unknown MessageType";
 }
@@ -98,6 +105,19 @@ const char* tlvTypeToString(const TlvType_t type)
         
         case TLV_SEARCH_QUERY:
             return "TLV_SEARCH_QUERY";
+        STR( TLV_SEARCH_COUNT );
+        STR( TLV_SUGGESTION );
+        STR( TLV_SUGGESTION_TYPE );
+        STR( TLV_LIBRARY_CHANGE );
+        STR( TLV_LIBRARY_VERSION );
+        STR( TLV_LIBRARY_RESYNC );
+        STR( TLV_CHANGE_TYPE );
+        STR( TLV_CHANGE_FOLDER );
+        STR( TLV_CHANGE_POSITION );
+        STR( TLV_CHANGE_TO_FOLDER );
+        STR( TLV_CHANGE_TO_POSITION );
+        STR( TLV_CHANGE_COUNT );
+        STR( TLV_LIBRARY_EPOCH );
         case TLV_STATE:
             return "TLV_STATE";
         case TLV_PROGRESS:
@@ -114,6 +134,12 @@ const char* tlvTypeToString(const TlvType_t type)
             return "TLV_LINK";
         case TLV_NAME:
             return "TLV_NAME";
+        STR( TLV_RESULT_OFFSET );
+        STR( TLV_RESULT_COUNT );
+        STR( TLV_RESULT_TOTAL );
+        STR( TLV_RESULT_CURSOR );
+        STR( TLV_CONTENT_VERSION );
+        STR( TLV_NOT_MODIFIED );
         case TLV_IMAGE:
             return "TLV_IMAGE";
         case TLV_IMAGE_FORMAT:
@@ -126,10 +152,20 @@ const char* tlvTypeToString(const TlvType_t type)
         STR( TLV_ALBUM_IS_AVAILABLE );
         STR( TLV_ALBUM_TYPE );
 
+        STR( TLV_STATS );
+        STR( TLV_METRIC );
+        STR( TLV_METRIC_TYPE );
+        STR( TLV_METRIC_VALUE );
+        STR( TLV_METRIC_P50 );
+        STR( TLV_METRIC_P90 );
+        STR( TLV_METRIC_P99 );
+        STR( TLV_METRIC_MAX );
+
         STR( TLV_LOGIN_USERNAME );
         STR( TLV_LOGIN_PASSWORD );
         STR( TLV_PROTOCOL_VERSION_MAJOR );
         STR( TLV_PROTOCOL_VERSION_MINOR );
+        STR( TLV_MORE_TO_COME );
         STR( TLV_FAILURE );
     }
     return "Unknown TlvType";
@@ -140,10 +176,12 @@ const char* failureCauseToString(const FailureCause_t type)
     switch(type)
     {
         STR( FAIL_GENERAL_ERROR );
+        STR( FAIL_TIMEOUT );
         STR( FAIL_BAD_LOGIN );
         STR( FAIL_PROTOCOL_MISMATCH );
         STR( FAIL_UNKNOWN_REQUEST );
         STR( FAIL_MISSING_TLV );
+        STR( FAIL_CURSOR_EXPIRED );
     }
     return "Unknown FailureCause";
 }
@@ -29,7 +29,7 @@
 #define TLVDEFINITIONS_H_
 
 #define PROTOCOL_VERSION_MAJOR 1 /*increase when not backwards compatible*/
-#define PROTOCOL_VERSION_MINOR 2 /*increase when adding new messages and/or TLV's*/
+#define PROTOCOL_VERSION_MINOR 8 /*increase when adding new messages and/or TLV's*/
 
 #define RSP_BIT 0x80000000
 #define IND_BIT 0x40000000
@@ -52,6 +52,9 @@ typedef enum
     REQ( GENERIC_SEARCH,   0x204 )
     REQ( GET_ALBUM,        0x205 )
     REQ( GET_ARTIST,       0x206 )
+    REQ( SEARCH_SUGGEST,   0x207 )
+    REQ( LIBRARY_SUBSCRIBE, 0x208 )
+    IND( LIBRARY_CHANGED,   0x208 )
 
     /* Playback */
     REQ( PLAY_TRACK,       0x301 ) /* obsolete, use PLAY_REQ */
@@ -62,6 +65,9 @@ typedef enum
     REQ( GET_STATUS,       0x401 )
     IND( STATUS,           0x401 )
 
+    /* Diagnostics */
+    REQ( GET_STATS,        0x501 )
+
     /* Remote Audio - Experimental use only! */
     REQ( ADD_AUDIO_ENDPOINT, 0x1001 )
     REQ( REM_AUDIO_ENDPOINT, 0x1002 )
@@ -79,6 +85,10 @@ typedef enum
     TLV_IMAGE    = 0x08,
     TLV_ALBUM    = 0x09,
     TLV_ARTIST   = 0x0a,
+    TLV_STATS    = 0x0b,
+    TLV_METRIC   = 0x0c,
+    TLV_SUGGESTION = 0x0d,
+    TLV_LIBRARY_CHANGE = 0x0e,
 
     /*Folder TLV's*/
     /* TLV_FOLDER_NAME = 0x101, deprecated */
@@ -98,6 +108,8 @@ typedef enum
 
     /* Search TLV's */
     TLV_SEARCH_QUERY = 0x401,
+    TLV_SEARCH_COUNT = 0x402, /* max number of results */
+    TLV_SUGGESTION_TYPE = 0x403, /* SuggestionType_t */
 
     /* Status TLV's */
     TLV_STATE    = 0x501, /* PlaybackState_t */
@@ -114,6 +126,16 @@ typedef enum
     TLV_LINK      = 0x701,
     TLV_NAME      = 0x702,
 
+    /* Paging of long track lists */
+    TLV_RESULT_OFFSET = 0x703, /* first track of the page, counted from 0 */
+    TLV_RESULT_COUNT  = 0x704, /* max tracks in the page, the whole list without it */
+    TLV_RESULT_TOTAL  = 0x705, /* tracks in the whole list */
+    TLV_RESULT_CURSOR = 0x706, /* a search result kept by the server for the following pages */
+
+    /* Conditional metadata requests */
+    TLV_CONTENT_VERSION = 0x707, /* hash of the content of a response, in a request the one the client has */
+    TLV_NOT_MODIFIED    = 0x708, /* the response has no content, the client's TLV_CONTENT_VERSION is current */
+
     /* Image TLV's */
     TLV_IMAGE_FORMAT = 0x801, /* ImageFormat_t */
     TLV_IMAGE_DATA   = 0x802,
@@ -128,13 +150,32 @@ typedef enum
     /* Artist TLV's */
     /* reserved 0xa00 range */
 
-
+    /* Metric TLV's */
+    TLV_METRIC_TYPE  = 0xb01, /* MetricType_t */
+    TLV_METRIC_VALUE = 0xb02, /* counter/gauge value, number of samples for histograms */
+    TLV_METRIC_P50   = 0xb03,
+    TLV_METRIC_P90   = 0xb04,
+    TLV_METRIC_P99   = 0xb05,
+    TLV_METRIC_MAX   = 0xb06,
+
+
+    /* Library subscription TLV's */
+    TLV_LIBRARY_VERSION  = 0xc01, /* bumped by every change of the root folder */
+    TLV_LIBRARY_RESYNC   = 0xc02, /* the changes can't be sent, the whole root folder is (or has to be fetched) */
+    TLV_CHANGE_TYPE      = 0xc03, /* LibraryChangeType_t */
+    TLV_CHANGE_FOLDER    = 0xc04, /* folder in depth first order as in GET_PLAYLISTS_RSP, the root folder is 0 */
+    TLV_CHANGE_POSITION  = 0xc05, /* of the playlist in the folder, or of the first track in the playlist */
+    TLV_CHANGE_TO_FOLDER   = 0xc06, /* where a moved playlist goes */
+    TLV_CHANGE_TO_POSITION = 0xc07,
+    TLV_CHANGE_COUNT     = 0xc08, /* tracks removed */
+    TLV_LIBRARY_EPOCH    = 0xc09, /* new every time the server starts, versions of another epoch mean nothing */
 
     /* Session TLV's */
     TLV_LOGIN_USERNAME         = 0x1001,
     TLV_LOGIN_PASSWORD         = 0x1002,
     TLV_PROTOCOL_VERSION_MAJOR = 0x1003,
     TLV_PROTOCOL_VERSION_MINOR = 0x1004,
+    TLV_MORE_TO_COME           = 0x1005, /* non zero in a response part that more parts with the same id follow */
 
     /* Error handling TLV's */
     TLV_FAILURE                = 0x1101,
@@ -151,6 +192,7 @@ typedef enum
 {
     /*generic codes*/
     FAIL_GENERAL_ERROR     = 0x01, /* = Some error I don't want to add a new cause for */
+    FAIL_TIMEOUT           = 0x02, /* = Spotify didn't deliver in time */
 
     /*session codes*/
     FAIL_BAD_LOGIN         = 0x11, /* = Wrong username or password */
@@ -159,6 +201,7 @@ typedef enum
     /*message errors*/
     FAIL_UNKNOWN_REQUEST   = 0x21, /* = Unknown MessageType_t */
     FAIL_MISSING_TLV       = 0x22, /* = Mandatory parameter was missing in request */
+    FAIL_CURSOR_EXPIRED    = 0x23, /* = The result a cursor named is no longer kept, search again */
 }FailureCause_t;
 
 typedef enum
@@ -176,12 +219,37 @@ typedef enum
     PLAY_OP_PREV,
 }PlayOp_t;
 
+typedef enum
+{
+    SUGGESTION_TRACK,
+    SUGGESTION_ARTIST,
+    SUGGESTION_ALBUM,
+    SUGGESTION_PLAYLIST,
+}SuggestionType_t;
+
+typedef enum
+{
+    CHANGE_PLAYLIST_ADDED,
+    CHANGE_PLAYLIST_REMOVED,
+    CHANGE_PLAYLIST_RENAMED,
+    CHANGE_PLAYLIST_MOVED,   /* removed from its position, then inserted at the new one */
+    CHANGE_TRACKS_INSERTED,
+    CHANGE_TRACKS_REMOVED,
+}LibraryChangeType_t;
+
 typedef enum /*sp_imageformat*/
 {
     IMAGE_FORMAT_UNKNOWN, /*what to do with this?*/
     IMAGE_FORMAT_JPEG,
 }ImageFormat_t;
 
+typedef enum
+{
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM,
+}MetricType_t;
+
 
 const char* failureCauseToString(const FailureCause_t type);
 const char* messageTypeToString(const MessageType_t type);
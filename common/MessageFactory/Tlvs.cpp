@@ -79,7 +79,7 @@ std::string Tlv::print() const
 
 StringTlv::StringTlv(TlvType_t type, const uint8_t* data, uint32_t len) : Tlv(type)
 {
-    if ( data[len-1] == '\0' )
+    if ( len > 0 && data[len-1] == '\0' )
         data_ = std::string((const char*) data); //null is included in len, this will give incorrect std::str.length() if initialized with (data, len)
     else
         data_ = std::string((const char*) data, (size_t)len);
@@ -208,6 +208,38 @@ std::string BinaryTlv::print() const
     return ss.str();
 }
 
+/*
+ * FileTlv
+ */
+
+FileTlv::FileTlv(TlvType_t type, const std::string& path) : Tlv(type), path_(path)
+{
+}
+
+Tlv* FileTlv::clone() const
+{
+    return new FileTlv(*this);
+}
+
+const std::string& FileTlv::getPath() const
+{
+    return path_;
+}
+
+void FileTlv::encode(MessageEncoder* msg) const
+{
+    msg->encodeFile(type_, path_);
+}
+
+std::string FileTlv::print() const
+{
+    std::stringstream ss;
+
+    ss << std::string((size_t)depth_*2, ' ');
+    ss << "TLV: " << tlvTypeToString(type_) << " = binary data from " << path_ << "\n";
+    return ss.str();
+}
+
 
 /*
  * TlvContainer
@@ -131,6 +131,28 @@ public:
     ~BinaryTlv();
 };
 
+/*
+ * FileTlv
+ * Binary data that stays in a file and is sent from there without being read into memory.
+ * Encodes to the same thing as a BinaryTlv, receivers can't tell the difference.
+ */
+
+class FileTlv : public Tlv
+{
+private:
+    std::string path_;
+
+public:
+    FileTlv(TlvType_t type, const std::string& path);
+    Tlv* clone() const;
+
+    const std::string& getPath() const;
+
+    void encode(MessageEncoder* msg) const;
+
+    std::string print() const;
+};
+
 /*
  * TlvContainer
  */
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Metrics.h"
+#include "MessageFactory/Tlvs.h"
+#include "applog.h"
+#include <assert.h>
+
+namespace Metrics
+{
+
+/************************
+ * Metric
+ ************************/
+Metric::Metric(const std::string& name, MetricType_t type) : name_(name), type_(type) { }
+Metric::~Metric() { }
+
+const std::string& Metric::getName() const
+{
+    return name_;
+}
+
+MetricType_t Metric::getType() const
+{
+    return type_;
+}
+
+static TlvContainer* newMetricTlv(const Metric& metric)
+{
+    TlvContainer* tlv = new TlvContainer(TLV_METRIC);
+    tlv->addTlv(TLV_NAME, metric.getName());
+    tlv->addTlv(TLV_METRIC_TYPE, metric.getType());
+    return tlv;
+}
+
+/************************
+ * Counter
+ ************************/
+Counter::Counter(const std::string& name) : Metric(name, METRIC_COUNTER) { }
+
+TlvContainer* Counter::toTlv() const
+{
+    TlvContainer* tlv = newMetricTlv(*this);
+    tlv->addTlv(TLV_METRIC_VALUE, get());
+    return tlv;
+}
+
+void Counter::toLog(LogLevel level) const
+{
+    log(level) << getName() << ": " << get();
+}
+
+/************************
+ * Gauge
+ ************************/
+Gauge::Gauge(const std::string& name) : Metric(name, METRIC_GAUGE) { }
+
+TlvContainer* Gauge::toTlv() const
+{
+    TlvContainer* tlv = newMetricTlv(*this);
+    tlv->addTlv(TLV_METRIC_VALUE, get());
+    return tlv;
+}
+
+void Gauge::toLog(LogLevel level) const
+{
+    log(level) << getName() << ": " << get();
+}
+
+/************************
+ * Histogram
+ ************************/
+Histogram::Histogram(const std::string& name) : Metric(name, METRIC_HISTOGRAM) { }
+
+unsigned int Histogram::bucketIndex(unsigned long value)
+{
+    if(value < HISTOGRAM_SUB_BUCKETS)
+        return value;
+
+    unsigned int msb = 0;
+    for(unsigned long v = value; v > 1; v >>= 1)
+        msb++;
+
+    unsigned int shift = msb - HISTOGRAM_SUB_BUCKET_BITS;
+    unsigned int sub = (value >> shift) - HISTOGRAM_SUB_BUCKETS;
+    return (shift + 1) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+unsigned long Histogram::bucketUpperBound(unsigned int index)
+{
+    if(index < HISTOGRAM_SUB_BUCKETS)
+        return index;
+
+    unsigned int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+    unsigned long sub = index % HISTOGRAM_SUB_BUCKETS;
+    unsigned long lower = (HISTOGRAM_SUB_BUCKETS + sub) << shift;
+    return lower + ((1UL << shift) - 1);
+}
+
+void Histogram::record(unsigned long value)
+{
+    if(value > 0xffffffffUL)
+        value = 0xffffffffUL;
+
+    buckets_[bucketIndex(value)].increment();
+    count_.increment();
+
+    long max = max_.get();
+    while((unsigned long)max < value && !max_.compareAndSwap(max, value))
+        max = max_.get();
+}
+
+unsigned long Histogram::getCount() const
+{
+    return count_.get();
+}
+
+unsigned long Histogram::getMax() const
+{
+    return max_.get();
+}
+
+unsigned long Histogram::getPercentile(unsigned int percentile) const
+{
+    unsigned long count = getCount();
+    if(count == 0)
+        return 0;
+
+    /* rank of the sample we are looking for, rounded up */
+    unsigned long long rank = ((unsigned long long)count * percentile + 99) / 100;
+    if(rank == 0) rank = 1;
+
+    unsigned long long seen = 0;
+    for(unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        seen += (unsigned long)buckets_[i].get();
+        if(seen >= rank)
+        {
+            unsigned long upper = bucketUpperBound(i);
+            unsigned long max = getMax();
+            return upper < max ? upper : max;
+        }
+    }
+    return getMax();
+}
+
+TlvContainer* Histogram::toTlv() const
+{
+    TlvContainer* tlv = newMetricTlv(*this);
+    tlv->addTlv(TLV_METRIC_VALUE, getCount());
+    tlv->addTlv(TLV_METRIC_P50, getPercentile(50));
+    tlv->addTlv(TLV_METRIC_P90, getPercentile(90));
+    tlv->addTlv(TLV_METRIC_P99, getPercentile(99));
+    tlv->addTlv(TLV_METRIC_MAX, getMax());
+    return tlv;
+}
+
+void Histogram::toLog(LogLevel level) const
+{
+    log(level) << getName() << ": count " << getCount() << " p50 " << getPercentile(50)
+               << " p90 " << getPercentile(90) << " p99 " << getPercentile(99) << " max " << getMax();
+}
+
+/************************
+ * Registry
+ ************************/
+Registry::Registry() { }
+
+Registry::~Registry()
+{
+    for(MetricMap::iterator it = metrics_.begin(); it != metrics_.end(); it++)
+        delete it->second;
+}
+
+Registry& Registry::instance()
+{
+    static Registry registry;
+    return registry;
+}
+
+Metric* Registry::find(const std::string& name) const
+{
+    MetricMap::const_iterator it = metrics_.find(name);
+    return (it != metrics_.end()) ? it->second : NULL;
+}
+
+Counter& Registry::getCounter(const std::string& name)
+{
+    mtx_.lock();
+    Metric* metric = find(name);
+    if(metric == NULL)
+    {
+        metric = new Counter(name);
+        metrics_[name] = metric;
+    }
+    mtx_.unlock();
+    assert(metric->getType() == METRIC_COUNTER);
+    return *static_cast<Counter*>(metric);
+}
+
+Gauge& Registry::getGauge(const std::string& name)
+{
+    mtx_.lock();
+    Metric* metric = find(name);
+    if(metric == NULL)
+    {
+        metric = new Gauge(name);
+        metrics_[name] = metric;
+    }
+    mtx_.unlock();
+    assert(metric->getType() == METRIC_GAUGE);
+    return *static_cast<Gauge*>(metric);
+}
+
+Histogram& Registry::getHistogram(const std::string& name)
+{
+    mtx_.lock();
+    Metric* metric = find(name);
+    if(metric == NULL)
+    {
+        metric = new Histogram(name);
+        metrics_[name] = metric;
+    }
+    mtx_.unlock();
+    assert(metric->getType() == METRIC_HISTOGRAM);
+    return *static_cast<Histogram*>(metric);
+}
+
+TlvContainer* Registry::toTlv() const
+{
+    TlvContainer* stats = new TlvContainer(TLV_STATS);
+
+    mtx_.lock();
+    for(MetricMap::const_iterator it = metrics_.begin(); it != metrics_.end(); it++)
+        stats->addTlv(it->second->toTlv());
+    mtx_.unlock();
+
+    return stats;
+}
+
+void Registry::toLog(LogLevel level) const
+{
+    mtx_.lock();
+    for(MetricMap::const_iterator it = metrics_.begin(); it != metrics_.end(); it++)
+        it->second->toLog(level);
+    mtx_.unlock();
+}
+
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include "Platform/Threads/Atomic.h"
+#include "Platform/Threads/Mutex.h"
+#include "MessageFactory/TlvDefinitions.h"
+#include "LogLevels.h"
+#include <string>
+#include <map>
+
+class TlvContainer;
+
+namespace Metrics
+{
+
+/* Metrics are created once through the Registry and live for the rest of the program,
+ * so it is safe to keep references to them. Updating a metric never takes a lock. */
+class Metric
+{
+private:
+    const std::string name_;
+    const MetricType_t type_;
+
+    /* Make non-copyable */
+    Metric(const Metric&);
+    Metric& operator=(const Metric&);
+
+protected:
+    Metric(const std::string& name, MetricType_t type);
+
+public:
+    virtual ~Metric();
+
+    const std::string& getName() const;
+    MetricType_t getType() const;
+
+    virtual TlvContainer* toTlv() const = 0;
+    virtual void toLog(LogLevel level) const = 0;
+};
+
+class Counter : public Metric
+{
+private:
+    Platform::AtomicInt value_;
+
+public:
+    Counter(const std::string& name);
+
+    void increment()                { value_.increment(); }
+    void add(unsigned long value)   { value_.add(value); }
+    unsigned long get() const       { return value_.get(); }
+
+    virtual TlvContainer* toTlv() const;
+    virtual void toLog(LogLevel level) const;
+};
+
+class Gauge : public Metric
+{
+private:
+    Platform::AtomicInt value_;
+
+public:
+    Gauge(const std::string& name);
+
+    void set(long value)            { value_.set(value); }
+    void add(long value)            { value_.add(value); }
+    long get() const                { return value_.get(); }
+
+    virtual TlvContainer* toTlv() const;
+    virtual void toLog(LogLevel level) const;
+};
+
+/* HDR style histogram: every power of two is split into HISTOGRAM_SUB_BUCKETS linear
+ * buckets, which keeps the relative error of any reported percentile below 1/8
+ * whatever the magnitude, with a fixed amount of memory and no locking. */
+#define HISTOGRAM_SUB_BUCKET_BITS 3
+#define HISTOGRAM_SUB_BUCKETS     (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKETS         ((32 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS)
+
+class Histogram : public Metric
+{
+private:
+    Platform::AtomicInt buckets_[HISTOGRAM_BUCKETS];
+    Platform::AtomicInt count_;
+    Platform::AtomicInt max_;
+
+    static unsigned int bucketIndex(unsigned long value);
+    static unsigned long bucketUpperBound(unsigned int index);
+
+public:
+    Histogram(const std::string& name);
+
+    /* values are whatever unit the owner decides, all latencies in here are microseconds */
+    void record(unsigned long value);
+
+    unsigned long getCount() const;
+    unsigned long getMax() const;
+    unsigned long getPercentile(unsigned int percentile) const;
+
+    virtual TlvContainer* toTlv() const;
+    virtual void toLog(LogLevel level) const;
+};
+
+class Registry
+{
+private:
+    typedef std::map<std::string, Metric*> MetricMap;
+    MetricMap metrics_;
+    mutable Platform::Mutex mtx_;
+
+    Registry();
+    ~Registry();
+
+    /* Make non-copyable */
+    Registry(const Registry&);
+    Registry& operator=(const Registry&);
+
+    Metric* find(const std::string& name) const;
+
+public:
+    static Registry& instance();
+
+    /* Lookups take a lock, hot paths should look up once and keep the reference */
+    Counter& getCounter(const std::string& name);
+    Gauge& getGauge(const std::string& name);
+    Histogram& getHistogram(const std::string& name);
+
+    TlvContainer* toTlv() const;
+    void toLog(LogLevel level) const;
+};
+
+}
+#endif /* METRICS_H_ */
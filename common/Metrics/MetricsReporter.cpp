@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MetricsReporter.h"
+#include "Metrics.h"
+#include "applog.h"
+
+namespace Metrics
+{
+
+MetricsReporter::MetricsReporter(unsigned int intervalSeconds) : Platform::Runnable(true, SIZE_SMALL, PRIO_LOW),
+                                                                 intervalSeconds_(intervalSeconds)
+{
+    if(intervalSeconds_ > 0)
+        startThread();
+}
+
+MetricsReporter::~MetricsReporter()
+{
+}
+
+void MetricsReporter::destroy()
+{
+    if(intervalSeconds_ > 0)
+    {
+        cancelThread();
+        cond_.signal();
+        joinThread();
+    }
+}
+
+void MetricsReporter::run()
+{
+    while(isCancellationPending() == false)
+    {
+        mtx_.lock();
+        cond_.timedWait(mtx_, intervalSeconds_ * 1000);
+        mtx_.unlock();
+
+        if(isCancellationPending() == false)
+        {
+            log(LOG_NOTICE) << "Metrics snapshot:";
+            Registry::instance().toLog(LOG_NOTICE);
+        }
+    }
+}
+
+}
@@ -25,6 +25,8 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 #include "AudioEndpoint.h"
+#include "Metrics/Metrics.h"
+#include "Tracing/FlightRecorder.h"
 #include <iostream>
 #include <stdlib.h>
 #include <string.h>
@@ -32,7 +34,10 @@
 
 namespace Platform {
 
-AudioFifo::AudioFifo() : queuedSamples(0) { }
+AudioFifo::AudioFifo() : queuedSamples(0),
+                         flowing_(false),
+                         fillLevel_(Metrics::Registry::instance().getGauge("audio.fifo_samples")),
+                         underruns_(Metrics::Registry::instance().getCounter("audio.underruns")) { }
 
 AudioFifo::~AudioFifo() {flush();}
 
@@ -76,6 +81,8 @@ int AudioFifo::addFifoDataBlocking(unsigned short channels, unsigned int rate, u
 		//fifoMtx_.lock();
 		fifo.push(data);
         queuedSamples += nsamples;
+        fillLevel_.set(queuedSamples);
+        Tracing::FlightRecorder::instance().record(Tracing::FR_AUDIO_PUSH, nsamples, queuedSamples);
 		cond_.signal();
 		fifoMtx_.unlock();
 
@@ -86,10 +93,13 @@ AudioFifoData* AudioFifo::getFifoDataBlocking()
 {
 	AudioFifoData* afd = 0;
 	fifoMtx_.lock();
+	if(fifo.empty() && flowing_)
+	{
+	    underruns_.increment();
+	    flowing_ = false;
+	}
 	while(fifo.empty())cond_.wait(fifoMtx_);
-	afd = fifo.front();
-    queuedSamples -= afd->nsamples;
-	fifo.pop();
+	afd = popFront();
 	fifoMtx_.unlock();
 	return afd;
 }
@@ -100,20 +110,21 @@ AudioFifoData* AudioFifo::getFifoDataTimedWait(unsigned int milliSeconds)
 	fifoMtx_.lock();
 	if(fifo.empty() == false)
 	{
-		afd = fifo.front();
-        queuedSamples -= afd->nsamples;
-		fifo.pop();
+		afd = popFront();
 	}
 	else afd = 0; /* redundant, but kept for clarity */
 
 	if(afd == 0)
 	{
+		if(flowing_)
+		{
+		    underruns_.increment();
+		    flowing_ = false;
+		}
 		cond_.timedWait(fifoMtx_, milliSeconds);
 		if(fifo.empty() == false)
 		{
-			afd = fifo.front();
-            queuedSamples -= afd->nsamples;
-            fifo.pop();
+			afd = popFront();
         }
 	}
 
@@ -133,9 +144,23 @@ void AudioFifo::flush()
 		fifo.pop();
 	}
     queuedSamples = 0;
+    flowing_ = false;
+    fillLevel_.set(0);
 	fifoMtx_.unlock();
 }
 
+/* fifoMtx_ must be held */
+AudioFifoData* AudioFifo::popFront()
+{
+	AudioFifoData* afd = fifo.front();
+	queuedSamples -= afd->nsamples;
+	fifo.pop();
+	flowing_ = true;
+	fillLevel_.set(queuedSamples);
+	Tracing::FlightRecorder::instance().record(Tracing::FR_AUDIO_POP, afd->nsamples, queuedSamples);
+	return afd;
+}
+
 }
 
 
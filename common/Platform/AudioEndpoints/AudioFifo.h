@@ -34,6 +34,8 @@
 #include <stdint.h>
 #include <queue>
 
+namespace Metrics { class Gauge; class Counter; }
+
 namespace Platform {
 class AudioFifoData
 {
@@ -51,6 +53,12 @@ private:
 	Condition cond_;
 	Mutex fifoMtx_;
     unsigned int queuedSamples;
+
+    /* underrun = consumer found the fifo empty while audio was flowing, flush() stops the flow */
+    bool flowing_;
+    Metrics::Gauge& fillLevel_;
+    Metrics::Counter& underruns_;
+    AudioFifoData* popFront();
 public:
 	AudioFifo();
 	~AudioFifo();
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../AudioEndpointLocal.h"
+#include "Platform/Threads/Atomic.h"
+#include "Platform/Utils/Utils.h"
+#include "Metrics/Metrics.h"
+#include "applog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+/* Test sink: writes the raw samples to the configured device as if it was a sound
+ * card playing them in real time, and measures the silence between tracks
+ * (audio.gap_us). The silence is written to the file as well. */
+
+/* how far ahead of real time the "sound card" buffers */
+#define FILE_ENDPOINT_BUFFER_US (50 * 1000)
+
+namespace Platform {
+
+/* bumped by flushAudioData(), the silence after a stop isn't a gap */
+static AtomicInt flushes;
+
+AudioEndpointLocal::AudioEndpointLocal(const ConfigHandling::AudioEndpointConfig& config) : config_(config)
+{
+	startThread();
+}
+AudioEndpointLocal::~AudioEndpointLocal()
+{
+}
+
+void AudioEndpointLocal::destroy()
+{
+	cancelThread();
+	joinThread();
+	flushAudioData();
+}
+
+
+int AudioEndpointLocal::enqueueAudioData(unsigned short channels, unsigned int rate, unsigned int nsamples, const int16_t* samples)
+{
+    return fifo.addFifoDataBlocking(channels, rate, nsamples, samples);
+}
+
+void AudioEndpointLocal::flushAudioData()
+{
+    fifo.flush();
+    flushes.increment();
+}
+
+void AudioEndpointLocal::run()
+{
+    Metrics::Histogram& gaps = Metrics::Registry::instance().getHistogram("audio.gap_us");
+    FILE* file = fopen(config_.getDevice().c_str(), "wb");
+    if (file == NULL)
+        log(LOG_WARN) << "Could not open " << config_.getDevice() << " for writing";
+
+    /* when what has been written so far has been played, 0 while stopped */
+    uint64_t playedUntil = 0;
+    /* the fifo was found empty after everything had been played */
+    bool ranDry = false;
+    long lastFlushes = flushes.get();
+    AudioFifoData* afd;
+
+    while(isCancellationPending() == false)
+    {
+        afd = fifo.getFifoDataTimedWait(1);
+        uint64_t now = getMonotonicTime_us();
+
+        if (flushes.get() != lastFlushes || paused_)
+        {
+            lastFlushes = flushes.get();
+            playedUntil = 0;
+            ranDry = false;
+        }
+
+        if (afd == NULL)
+        {
+            if (playedUntil != 0 && now > playedUntil)
+                ranDry = true;
+            continue;
+        }
+
+        if (ranDry)
+        {
+            uint64_t gap = now - playedUntil;
+            gaps.record(gap);
+            log(LOG_NOTICE) << "Audio gap of " << gap / 1000 << " ms";
+
+            if (file)
+            {
+                std::vector<int16_t> silence(static_cast<size_t>(gap * afd->rate / 1000000) * afd->channels);
+                if (!silence.empty())
+                    fwrite(&silence[0], sizeof(int16_t), silence.size(), file);
+            }
+            ranDry = false;
+        }
+        if (playedUntil < now)
+            playedUntil = now;
+
+        if (file)
+            fwrite(afd->samples, sizeof(int16_t) * afd->channels, afd->nsamples, file);
+        playedUntil += afd->nsamples * 1000000ULL / afd->rate;
+        free(afd);
+
+        /* don't take more than a sound card would */
+        if (playedUntil > now + FILE_ENDPOINT_BUFFER_US)
+            sleep_ms(static_cast<unsigned int>((playedUntil - now - FILE_ENDPOINT_BUFFER_US) / 1000));
+    }
+
+    if (file)
+        fclose(file);
+
+    log(LOG_DEBUG) << "Exiting AudioEndpoint::run()";
+}
+
+}
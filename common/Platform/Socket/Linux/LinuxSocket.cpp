@@ -39,6 +39,7 @@
 #include <errno.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <sys/sendfile.h>
 #include <assert.h>
 
 typedef struct SocketHandle_t
@@ -317,6 +318,17 @@ int Socket::Send(const void* msg, int msgLen)
     return send(socket_->fd, msg, msgLen, 0);
 }
 
+int Socket::SendFile(int fd, uint32_t offset, int len)
+{
+    off_t off = offset;
+    int n = sendfile(socket_->fd, fd, &off, len);
+    if (n < 0 && errno == EWOULDBLOCK)
+        return 0;
+    else if (n == 0 && len > 0)
+        return -1; /* end of file, it's shorter now than when it was attached */
+    return n;
+}
+
 int Socket::Receive(void* buf, int bufLen)
 {
     int n = recv(socket_->fd, buf, bufLen, 0);
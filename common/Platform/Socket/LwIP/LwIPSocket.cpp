@@ -173,6 +173,11 @@ int Socket::Send(const void* msg, int msgLen)
     return lwip_send(socket_->fd, msg, msgLen, 0);
 }
 
+int Socket::SendFile(int fd, uint32_t offset, int len)
+{
+    return -1; /* no filesystem */
+}
+
 int Socket::Receive(void* buf, int bufLen)
 {
     int n = lwip_recv(socket_->fd, buf, bufLen, 0);
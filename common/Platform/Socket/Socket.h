@@ -47,6 +47,10 @@ public:
     int Listen();
     int Connect(const std::string& addr, const std::string& port);
     int Send(const void* msg, int msgLen);
+    /* sends up to len bytes of the file fd (see openFile()) from offset, straight from the
+     * page cache where the platform supports it. Returns bytes sent, 0 if it would block
+     * and -1 on error, including the file ending before len bytes */
+    int SendFile(int fd, uint32_t offset, int len);
     int Receive(void* buf, int bufLen);
     Socket* Accept();
     void Close();
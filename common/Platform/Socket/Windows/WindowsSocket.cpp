@@ -30,6 +30,7 @@
 #include <mstcpip.h>
 #include "../Socket.h"
 #include "applog.h"
+#include "Platform/Utils/Utils.h"
 #include <stdint.h>
 
 typedef struct SocketHandle_t
@@ -271,6 +272,19 @@ int Socket::Send(const void* msg, int msgLen)
     return send(socket_->handle, (const char*) msg, msgLen, 0);
 }
 
+/* no sendfile for CRT file descriptors, go through a buffer instead */
+int Socket::SendFile(int fd, uint32_t offset, int len)
+{
+    char buf[4096];
+    int n = readFile(fd, offset, buf, len < (int)sizeof(buf) ? len : (int)sizeof(buf));
+    if (n <= 0)
+        return -1;
+    n = send(socket_->handle, buf, n, 0);
+    if (n == SOCKET_ERROR && WSAGetLastError() == WSAEWOULDBLOCK)
+        return 0;
+    return n;
+}
+
 int Socket::Receive(void* buf, int bufLen)
 {
     int n = recv(socket_->handle, (char*) buf, bufLen, 0);
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ATOMIC_H_
+#define ATOMIC_H_
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace Platform
+{
+
+/* Word sized integer with lock-free read-modify-write operations.
+ * Every operation acts as a full memory barrier, which is what the few
+ * lock-free structures in here need, and it keeps the platform mapping trivial. */
+class AtomicInt
+{
+private:
+    volatile long value_;
+
+    /* Make non-copyable */
+    AtomicInt(const AtomicInt&);
+    AtomicInt& operator=(const AtomicInt&);
+
+public:
+    AtomicInt(long value = 0) : value_(value) {}
+
+#ifdef _WIN32
+    long get() const                    { MemoryBarrier(); long v = value_; MemoryBarrier(); return v; }
+    void set(long value)                { InterlockedExchange(&value_, value); }
+    long add(long value)                { return InterlockedExchangeAdd(&value_, value) + value; }
+    long exchange(long value)           { return InterlockedExchange(&value_, value); }
+    bool compareAndSwap(long expected, long desired)
+    {
+        return InterlockedCompareExchange(&value_, desired, expected) == expected;
+    }
+#else
+    long get() const                    { __sync_synchronize(); long v = value_; __sync_synchronize(); return v; }
+    void set(long value)                { __sync_synchronize(); value_ = value; __sync_synchronize(); }
+    long add(long value)                { return __sync_add_and_fetch(&value_, value); }
+    long exchange(long value)
+    {
+        long old;
+        do { old = value_; } while(!__sync_bool_compare_and_swap(&value_, old, value));
+        return old;
+    }
+    bool compareAndSwap(long expected, long desired)
+    {
+        return __sync_bool_compare_and_swap(&value_, expected, desired);
+    }
+#endif
+
+    long increment()                    { return add(1); }
+    long decrement()                    { return add(-1); }
+};
+
+}
+#endif /* ATOMIC_H_ */
@@ -38,6 +38,8 @@ public:
 	Condition();
 	~Condition();
 	void signal();
+	/* wakes every waiter, not just one */
+	void broadcast();
 	void wait(class Mutex& mtx);
 	void timedWait(class Mutex& mtx, unsigned int milliSeconds);
 };
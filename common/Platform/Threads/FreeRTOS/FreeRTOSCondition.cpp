@@ -64,4 +64,10 @@ void Condition::signal()
     xSemaphoreGive( cond_->xSemaphore );
 }
 
+/* a binary semaphore only ever wakes one */
+void Condition::broadcast()
+{
+    xSemaphoreGive( cond_->xSemaphore );
+}
+
 }
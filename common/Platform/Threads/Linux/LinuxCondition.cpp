@@ -61,6 +61,11 @@ void Condition::timedWait(Mutex& mtx, unsigned int milliSeconds)
 	clock_gettime(CLOCK_REALTIME, &ts);
 	ts.tv_sec += milliSeconds / 1000;
 	ts.tv_nsec += (milliSeconds % 1000) * 1000000;
+	if(ts.tv_nsec >= 1000000000)
+	{
+		ts.tv_sec++;
+		ts.tv_nsec -= 1000000000;
+	}
 
 	pthread_cond_timedwait(&cond_->cond, &mtx.mtx_->mtx_, &ts);
 }
@@ -70,4 +75,9 @@ void Condition::signal()
 	pthread_cond_signal(&cond_->cond);
 }
 
+void Condition::broadcast()
+{
+	pthread_cond_broadcast(&cond_->cond);
+}
+
 }
@@ -27,6 +27,8 @@
 
 #include "../Mutex.h"
 #include "LinuxMutexPimpl.h"
+#include "Platform/Utils/Utils.h"
+#include "Tracing/FlightRecorder.h"
 
 namespace Platform
 {
@@ -45,7 +47,13 @@ Mutex::~Mutex()
 
 void Mutex::lock()
 {
+	/* only a contended lock is timed, for the flight recorder */
+	if (pthread_mutex_trylock(&mtx_->mtx_) == 0)
+		return;
+
+	uint64_t start = getMonotonicTime_us();
 	pthread_mutex_lock(&mtx_->mtx_);
+	Tracing::FlightRecorder::instance().mutexWait(this, getMonotonicTime_us() - start);
 }
 
 void Mutex::unlock()
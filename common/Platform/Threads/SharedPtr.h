@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SHAREDPTR_H_
+#define SHAREDPTR_H_
+
+#include "Atomic.h"
+#include <stddef.h>
+
+namespace Platform
+{
+
+/* Reference counted pointer that can be handed between threads.
+ * The count itself is atomic, the pointee is not protected at all, so it is
+ * meant for objects that are left alone once shared (i.e. only read, or
+ * copied before being modified, see unique()). */
+template <class T>
+class SharedPtr
+{
+private:
+    template <class U> friend class SharedPtr;
+
+    T* ptr_;
+    AtomicInt* count_;
+
+    void release()
+    {
+        if ( count_ && count_->decrement() == 0 )
+        {
+            delete ptr_;
+            delete count_;
+        }
+        ptr_ = NULL;
+        count_ = NULL;
+    }
+
+public:
+    SharedPtr() : ptr_(NULL), count_(NULL) {}
+    explicit SharedPtr(T* ptr) : ptr_(ptr), count_(ptr ? new AtomicInt(1) : NULL) {}
+    SharedPtr(const SharedPtr& other) : ptr_(other.ptr_), count_(other.count_)
+    {
+        if ( count_ ) count_->increment();
+    }
+    /* e.g. SharedPtr<const T> from SharedPtr<T> */
+    template <class U>
+    SharedPtr(const SharedPtr<U>& other) : ptr_(other.ptr_), count_(other.count_)
+    {
+        if ( count_ ) count_->increment();
+    }
+    ~SharedPtr() { release(); }
+
+    SharedPtr& operator=(const SharedPtr& other)
+    {
+        SharedPtr tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    void swap(SharedPtr& other)
+    {
+        T* ptr = ptr_;
+        AtomicInt* count = count_;
+        ptr_ = other.ptr_;
+        count_ = other.count_;
+        other.ptr_ = ptr;
+        other.count_ = count;
+    }
+
+    void reset(T* ptr = NULL)
+    {
+        SharedPtr tmp(ptr);
+        swap(tmp);
+    }
+
+    T* get() const         { return ptr_; }
+    T& operator*() const   { return *ptr_; }
+    T* operator->() const  { return ptr_; }
+    bool isNull() const    { return ptr_ == NULL; }
+
+    /* true if nobody else holds a reference, i.e. it is safe to modify in place */
+    bool unique() const    { return count_ && count_->get() == 1; }
+};
+
+}
+#endif /* SHAREDPTR_H_ */
@@ -63,4 +63,9 @@ void Condition::signal()
 	WakeConditionVariable(&cond_->cond);
 }
 
+void Condition::broadcast()
+{
+	WakeAllConditionVariable(&cond_->cond);
+}
+
 }
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "../Utils.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+
+void sleep_ms( unsigned int ms )
+{
+    vTaskDelay( ms / portTICK_RATE_MS );
+}
+
+uint64_t getMonotonicTime_us()
+{
+    /* the tick counter is 32 bits, keep track of the wraps to get a 64 bit time */
+    static portTickType lastTick = 0;
+    static uint64_t wraps = 0;
+
+    taskENTER_CRITICAL();
+    portTickType tick = xTaskGetTickCount();
+    if ( tick < lastTick )
+        wraps++;
+    lastTick = tick;
+    uint64_t ticks = ( wraps << 32 ) | tick;
+    taskEXIT_CRITICAL();
+
+    return ticks * portTICK_RATE_MS * 1000;
+}
+
+/* no filesystem */
+int openFile( const std::string& path, uint32_t* size )
+{
+    return -1;
+}
+
+int readFile( int fd, uint32_t offset, void* buf, uint32_t len )
+{
+    return -1;
+}
+
+void closeFile( int fd )
+{
+}
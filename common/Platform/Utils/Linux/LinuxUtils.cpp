@@ -25,8 +25,12 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "../Utils.h"
 #include <termios.h>
 #include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 
 void disableStdinEcho()
@@ -51,3 +55,35 @@ void sleep_ms( unsigned int ms )
 {
     usleep( ms * 1000 );
 }
+
+uint64_t getMonotonicTime_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+int openFile( const std::string& path, uint32_t* size )
+{
+    int fd = open( path.c_str(), O_RDONLY );
+    struct stat st;
+    if ( fd < 0 )
+        return -1;
+    if ( fstat( fd, &st ) != 0 )
+    {
+        close( fd );
+        return -1;
+    }
+    *size = st.st_size;
+    return fd;
+}
+
+int readFile( int fd, uint32_t offset, void* buf, uint32_t len )
+{
+    return pread( fd, buf, len, offset );
+}
+
+void closeFile( int fd )
+{
+    close( fd );
+}
@@ -28,8 +28,21 @@
 #ifndef UTILS_H_
 #define UTILS_H_
 
+#include <stdint.h>
+#include <string>
+
 void disableStdinEcho();
 void enableStdinEcho();
 
 void sleep_ms( unsigned int ms );
+
+/* Microseconds since some arbitrary point, never jumps, only useful for measuring durations */
+uint64_t getMonotonicTime_us();
+
+/* Read only file access, mainly for Socket::SendFile().
+ * openFile returns -1 on failure and sets size to the size of the file,
+ * readFile returns the number of bytes read or -1 */
+int openFile( const std::string& path, uint32_t* size );
+int readFile( int fd, uint32_t offset, void* buf, uint32_t len );
+void closeFile( int fd );
 #endif /* UTILS_H_ */
@@ -25,7 +25,11 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include "../Utils.h"
 #include "Windows.h"
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
 
 void disableStdinEcho()
 {
@@ -47,3 +51,43 @@ void sleep_ms( unsigned int ms )
 {
     Sleep( ms );
 }
+
+uint64_t getMonotonicTime_us()
+{
+    static LARGE_INTEGER frequency = {0};
+    LARGE_INTEGER counter;
+
+    if ( frequency.QuadPart == 0 )
+        QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &counter );
+
+    return (uint64_t)( counter.QuadPart / frequency.QuadPart ) * 1000000 +
+           (uint64_t)( counter.QuadPart % frequency.QuadPart ) * 1000000 / frequency.QuadPart;
+}
+
+int openFile( const std::string& path, uint32_t* size )
+{
+    int fd = _open( path.c_str(), _O_RDONLY | _O_BINARY );
+    struct _stat st;
+    if ( fd < 0 )
+        return -1;
+    if ( _fstat( fd, &st ) != 0 )
+    {
+        _close( fd );
+        return -1;
+    }
+    *size = st.st_size;
+    return fd;
+}
+
+int readFile( int fd, uint32_t offset, void* buf, uint32_t len )
+{
+    if ( _lseek( fd, offset, SEEK_SET ) < 0 )
+        return -1;
+    return _read( fd, buf, len );
+}
+
+void closeFile( int fd )
+{
+    _close( fd );
+}
@@ -124,8 +124,14 @@ void SocketClient::run()
                                 {
                                     Message* req = msgIt->second;
                                     if ( subscriber_ ) subscriber_->receivedResponse( msg, req );
-                                    pendingMessageMap_.erase(msgIt);
-                                    delete req;
+
+                                    /* a response in parts answers the request with its last part */
+                                    const IntTlv* more = (const IntTlv*) msg->getTlv( TLV_MORE_TO_COME );
+                                    if ( more == NULL || more->getVal() == 0 )
+                                    {
+                                        pendingMessageMap_.erase(msgIt);
+                                        delete req;
+                                    }
                                 }
                             }
                             else
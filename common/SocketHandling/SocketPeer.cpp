@@ -98,14 +98,19 @@ int SocketPeer::doWrite()
         if (msg == NULL )
             return 0;
 
+        messageEncoding(msg);
         MessageEncoder* encoder = msg->encode();
+        messageEncoded(msg);
         encoder->printHex();
         log(LOG_DEBUG) << *msg;
         delete msg;
         writer_.setData(encoder); // SocketWriter takes ownership of encoder
     }
 
-    return writer_.doWrite();
+    int rc = writer_.doWrite();
+    if (rc > 0 && writer_.isEmpty())
+        messageSent();
+    return rc;
 }
 
 Socket* SocketPeer::getSocket() const
@@ -45,6 +45,13 @@ private:
 
     Socket* socket_;
 
+    /* Called on the socket thread around each outgoing message; before it is encoded,
+     * after it is encoded and when the last byte has been handed to the socket.
+     * Does nothing by default. */
+    virtual void messageEncoding(const Message* msg) {}
+    virtual void messageEncoded(const Message* msg) {}
+    virtual void messageSent() {}
+
 protected:
 
 public:
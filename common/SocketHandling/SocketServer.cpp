@@ -26,6 +26,7 @@
  */
 
 #include "SocketServer.h"
+#include "Tracing/FlightRecorder.h"
 #include "applog.h"
 #include <stdlib.h>
 #include <string.h>
@@ -109,6 +110,7 @@ void SocketServer::run()
             else
             {
                 peers_.push_front( newPeer(peersock) );
+                Tracing::FlightRecorder::instance().record( Tracing::FR_SOCKET_ACCEPT, peers_.size() );
             }
         }
 
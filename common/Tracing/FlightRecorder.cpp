@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "FlightRecorder.h"
+#include "Platform/Utils/Utils.h"
+#include "applog.h"
+#include <stdio.h>
+#include <algorithm>
+#include <vector>
+
+namespace Tracing
+{
+
+FlightRecorder::FlightRecorder() : records_(NULL),
+                                   capacity_(0),
+                                   next_(0),
+                                   mutexWaitThreshold_us_(0),
+                                   dumpRequested_(0) { }
+
+FlightRecorder::~FlightRecorder()
+{
+    delete[] records_;
+}
+
+FlightRecorder& FlightRecorder::instance()
+{
+    static FlightRecorder recorder;
+    return recorder;
+}
+
+void FlightRecorder::enable(unsigned int capacity, const std::string& dumpFile, unsigned int mutexWaitThreshold_us)
+{
+    dumpFile_ = dumpFile;
+    mutexWaitThreshold_us_ = mutexWaitThreshold_us;
+    if (records_ == NULL && capacity > 0)
+    {
+        capacity_ = capacity;
+        records_ = new Record[capacity_];
+        for (unsigned int i = 0; i < capacity_; i++)
+            records_[i].seq = 0;
+    }
+}
+
+void FlightRecorder::write(FlightRecordType type, uint32_t a, uint32_t b)
+{
+    uint32_t seq = static_cast<uint32_t>(next_.increment());
+    Record& r = records_[seq % capacity_];
+
+    r.time_us = getMonotonicTime_us();
+    r.type = type;
+    r.a = a;
+    r.b = b;
+    r.seq = seq;
+}
+
+static bool olderThan(const std::pair<uint32_t, unsigned int>& x, const std::pair<uint32_t, unsigned int>& y)
+{
+    /* sequence numbers may wrap, compare by distance */
+    return static_cast<int32_t>(x.first - y.first) < 0;
+}
+
+static void printRecord(FILE* f, int64_t age_us, uint16_t type, uint32_t a, uint32_t b)
+{
+    fprintf(f, "%12lld us  ", (long long)age_us);
+    switch (type)
+    {
+        case FR_DISPATCH:      fprintf(f, "DISPATCH       event=%u queue_depth=%u\n", a, b); break;
+        case FR_DISPATCH_DONE: fprintf(f, "DISPATCH_DONE  event=%u exec_us=%u\n", a, b); break;
+        case FR_SOCKET_ACCEPT: fprintf(f, "SOCKET_ACCEPT  peers=%u\n", a); break;
+        case FR_SOCKET_READ:   fprintf(f, "SOCKET_READ    bytes=%u\n", a); break;
+        case FR_SOCKET_WRITE:  fprintf(f, "SOCKET_WRITE   bytes=%u\n", a); break;
+        case FR_AUDIO_PUSH:    fprintf(f, "AUDIO_PUSH     samples=%u fill=%u\n", a, b); break;
+        case FR_AUDIO_POP:     fprintf(f, "AUDIO_POP      samples=%u fill=%u\n", a, b); break;
+        case FR_MUTEX_WAIT:    fprintf(f, "MUTEX_WAIT     wait_us=%u mutex=0x%08x\n", a, b); break;
+        case FR_STALL:         fprintf(f, "STALL          stuck_ms=%u\n", a); break;
+        default:               fprintf(f, "type=%u a=%u b=%u\n", type, a, b); break;
+    }
+}
+
+bool FlightRecorder::dump(const char* reason)
+{
+    if (records_ == NULL)
+        return false;
+
+    FILE* f = fopen(dumpFile_.c_str(), "a");
+    if (f == NULL)
+    {
+        log(LOG_WARN) << "Could not open " << dumpFile_ << " for the flight recorder dump";
+        return false;
+    }
+
+    /* order the written slots by sequence number, recording carries on meanwhile */
+    std::vector<std::pair<uint32_t, unsigned int> > order;
+    order.reserve(capacity_);
+    for (unsigned int i = 0; i < capacity_; i++)
+    {
+        if (records_[i].seq != 0)
+            order.push_back(std::make_pair(records_[i].seq, i));
+    }
+    std::sort(order.begin(), order.end(), olderThan);
+
+    uint64_t now = getMonotonicTime_us();
+    fprintf(f, "=== flight recorder dump (%s), %u records, times relative to the dump ===\n",
+             reason, static_cast<unsigned int>(order.size()));
+
+    for (std::vector<std::pair<uint32_t, unsigned int> >::const_iterator it = order.begin(); it != order.end(); it++)
+    {
+        const Record& r = records_[it->second];
+        printRecord(f, static_cast<int64_t>(r.time_us - now), r.type, r.a, r.b);
+    }
+    fprintf(f, "\n");
+    fclose(f);
+
+    log(LOG_NOTICE) << "Flight recorder dumped to " << dumpFile_ << " (" << reason << ")";
+    return true;
+}
+
+}
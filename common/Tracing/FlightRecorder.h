@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FLIGHTRECORDER_H_
+#define FLIGHTRECORDER_H_
+
+#include "Platform/Threads/Atomic.h"
+#include <stdint.h>
+#include <string>
+
+namespace Tracing
+{
+
+typedef enum
+{
+    FR_DISPATCH,        /* a = libspotify event, b = queue depth left behind */
+    FR_DISPATCH_DONE,   /* a = libspotify event, b = execution time in us */
+    FR_SOCKET_ACCEPT,   /* a = number of peers after the accept */
+    FR_SOCKET_READ,     /* a = bytes */
+    FR_SOCKET_WRITE,    /* a = bytes */
+    FR_AUDIO_PUSH,      /* a = samples, b = samples queued after the push */
+    FR_AUDIO_POP,       /* a = samples, b = samples queued after the pop */
+    FR_MUTEX_WAIT,      /* a = wait time in us, b = low bits of the mutex address */
+    FR_STALL,           /* a = how long the watched loop has been stuck in ms */
+    FR_TYPE_COUNT
+} FlightRecordType;
+
+/* Always-on ring of the most recent low level events, meant for post-mortems
+ * of hangs and stutter where the log is too coarse.
+ *
+ * A record is a timestamp, a type and two numbers. Writing one is a slot claim
+ * (one atomic add) and a few plain stores, there is no lock and no formatting.
+ * Records being overwritten while a dump is in progress may come out torn,
+ * which is fine for this purpose. Records are decoded to text when dumped. */
+class FlightRecorder
+{
+private:
+    struct Record
+    {
+        uint64_t time_us;
+        uint32_t seq;       /* 0 = never written */
+        uint16_t type;
+        uint32_t a;
+        uint32_t b;
+    };
+
+    Record* records_;
+    unsigned int capacity_;
+    Platform::AtomicInt next_;
+    unsigned int mutexWaitThreshold_us_;
+    std::string dumpFile_;
+    Platform::AtomicInt dumpRequested_;
+
+    void write(FlightRecordType type, uint32_t a, uint32_t b);
+
+    FlightRecorder();
+
+    /* Make non-copyable */
+    FlightRecorder(const FlightRecorder&);
+    FlightRecorder& operator=(const FlightRecorder&);
+
+public:
+    ~FlightRecorder();
+
+    static FlightRecorder& instance();
+
+    /* Allocates room for capacity records, 0 keeps the recorder disabled. Call once, before any thread records */
+    void enable(unsigned int capacity, const std::string& dumpFile, unsigned int mutexWaitThreshold_us);
+    bool isEnabled() const { return records_ != NULL; }
+
+    void record(FlightRecordType type, uint32_t a = 0, uint32_t b = 0)
+    {
+        if (records_ != NULL)
+            write(type, a, b);
+    }
+
+    void mutexWait(const void* mutex, uint64_t wait_us)
+    {
+        if (records_ != NULL && wait_us >= mutexWaitThreshold_us_)
+            write(FR_MUTEX_WAIT, static_cast<uint32_t>(wait_us), static_cast<uint32_t>(reinterpret_cast<uintptr_t>(mutex)));
+    }
+
+    /* Only sets a flag, safe to call from a signal handler. Whoever polls dumpRequested() does the dump */
+    void requestDump() { dumpRequested_.set(1); }
+    bool dumpRequested() { return dumpRequested_.exchange(0) != 0; }
+
+    /* Appends the records, oldest first, to the dump file */
+    bool dump(const char* reason);
+};
+
+}
+#endif /* FLIGHTRECORDER_H_ */
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Tracer.h"
+#include "applog.h"
+#include <fstream>
+
+namespace Tracing
+{
+
+Tracer::Tracer() : spans_(NULL), capacity_(0), next_(0) { }
+
+Tracer::~Tracer()
+{
+    delete[] spans_;
+}
+
+Tracer& Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+void Tracer::enable(unsigned int capacity, const std::string& exportFile)
+{
+    exportFile_ = exportFile;
+    if ( spans_ == NULL && capacity > 0 )
+    {
+        capacity_ = capacity;
+        spans_ = new Span[capacity_];
+    }
+}
+
+void Tracer::record(const char* name, const void* owner, uint32_t reqId, uint64_t start_us, uint64_t end_us)
+{
+    if ( spans_ == NULL )
+        return;
+
+    unsigned long pos = static_cast<unsigned long>( next_.increment() - 1 );
+    Span& span = spans_[pos % capacity_];
+
+    span.seq_.set( 0 );
+    span.name_ = name;
+    span.owner_ = owner;
+    span.reqId_ = reqId;
+    span.start_us_ = start_us;
+    span.end_us_ = end_us;
+    span.seq_.set( static_cast<long>( pos + 1 ) );
+}
+
+static void writeEvent(std::ostream& os, bool& first, const char* name, char phase, const void* owner, uint32_t reqId, uint64_t ts)
+{
+    if ( !first )
+        os << ",\n";
+    first = false;
+
+    os << "{\"name\":\"" << name << "\",\"cat\":\"request\",\"ph\":\"" << phase << "\""
+       << ",\"id\":\"" << owner << ":" << reqId << "\""
+       << ",\"ts\":" << ts << ",\"pid\":1,\"tid\":1"
+       << ",\"args\":{\"reqId\":" << reqId << "}}";
+}
+
+void Tracer::exportChromeTrace(std::ostream& os) const
+{
+    bool first = true;
+
+    os << "{\"traceEvents\":[\n";
+
+    for ( unsigned int i = 0; spans_ != NULL && i < capacity_; i++ )
+    {
+        const Span& span = spans_[i];
+
+        /* copy the span out and skip it if a writer raced with us */
+        long seq = span.seq_.get();
+        if ( seq == 0 )
+            continue;
+
+        const char* name = span.name_;
+        const void* owner = span.owner_;
+        uint32_t reqId = span.reqId_;
+        uint64_t start = span.start_us_;
+        uint64_t end = span.end_us_;
+
+        if ( span.seq_.get() != seq )
+            continue;
+
+        writeEvent( os, first, name, 'b', owner, reqId, start );
+        writeEvent( os, first, name, 'e', owner, reqId, end );
+    }
+
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+bool Tracer::exportChromeTrace() const
+{
+    std::ofstream file( exportFile_.c_str() );
+    if ( !file )
+    {
+        log(LOG_WARN) << "Could not open " << exportFile_ << " for writing the request trace";
+        return false;
+    }
+
+    exportChromeTrace( file );
+    log(LOG_NOTICE) << "Request trace written to " << exportFile_;
+    return true;
+}
+
+}
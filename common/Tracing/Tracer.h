@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include "Platform/Threads/Atomic.h"
+#include <stdint.h>
+#include <string>
+#include <ostream>
+
+namespace Tracing
+{
+
+/* Records timed spans for client requests so that a single slow request can be
+ * followed from the socket, through the event queue and libspotify, and back out.
+ *
+ * A request is identified by the pair (owner, reqId), where owner is the
+ * IMediaInterfaceCallbackSubscriber that issued it (i.e. the client connection)
+ * and reqId is the protocol request id it carries in ReqEventItem.
+ *
+ * Spans go into a fixed size ring, the oldest are overwritten. Recording never
+ * takes a lock and is a single branch while tracing is disabled. */
+class Tracer
+{
+private:
+    class Span
+    {
+    public:
+        Platform::AtomicInt seq_; /* 0 while being written */
+        const char* name_;        /* must be a string literal */
+        const void* owner_;
+        uint32_t reqId_;
+        uint64_t start_us_;
+        uint64_t end_us_;
+    };
+
+    Span* spans_;
+    unsigned int capacity_;
+    Platform::AtomicInt next_;
+    std::string exportFile_;
+
+    Tracer();
+
+    /* Make non-copyable */
+    Tracer(const Tracer&);
+    Tracer& operator=(const Tracer&);
+
+public:
+    ~Tracer();
+
+    static Tracer& instance();
+
+    /* Allocates room for capacity spans, 0 keeps tracing disabled. Call once, before any thread records */
+    void enable(unsigned int capacity, const std::string& exportFile);
+    bool isEnabled() const { return spans_ != NULL; }
+
+    void record(const char* name, const void* owner, uint32_t reqId, uint64_t start_us, uint64_t end_us);
+
+    /* Writes the recorded spans in Chrome trace-event format (chrome://tracing, ui.perfetto.dev),
+     * one async track per request */
+    void exportChromeTrace(std::ostream& os) const;
+    bool exportChromeTrace() const;
+};
+
+}
+#endif /* TRACER_H_ */
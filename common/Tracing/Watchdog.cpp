@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "Watchdog.h"
+#include "FlightRecorder.h"
+#include "Platform/Utils/Utils.h"
+#include "applog.h"
+#include <signal.h>
+
+#define WATCHDOG_POLL_MS (100)
+
+namespace Tracing
+{
+
+#ifdef SIGUSR1
+static void onDumpSignal(int sig)
+{
+    FlightRecorder::instance().requestDump();
+}
+#endif
+
+Watchdog::Watchdog(const Heartbeat& heartbeat, unsigned int stallThreshold_ms) : Platform::Runnable(true, SIZE_SMALL, PRIO_LOW),
+                                                                                   heartbeat_(heartbeat),
+                                                                                   stallThreshold_ms_(stallThreshold_ms),
+                                                                                   running_(FlightRecorder::instance().isEnabled())
+{
+    if(running_)
+    {
+#ifdef SIGUSR1
+        signal(SIGUSR1, onDumpSignal);
+#endif
+        startThread();
+    }
+}
+
+Watchdog::~Watchdog()
+{
+}
+
+void Watchdog::destroy()
+{
+    if(running_)
+    {
+        cancelThread();
+        cond_.signal();
+        joinThread();
+        running_ = false;
+    }
+}
+
+void Watchdog::run()
+{
+    long lastBeat = heartbeat_.get();
+    uint64_t lastChange = getMonotonicTime_us();
+    bool stallReported = false;
+
+    while(isCancellationPending() == false)
+    {
+        mtx_.lock();
+        cond_.timedWait(mtx_, WATCHDOG_POLL_MS);
+        mtx_.unlock();
+
+        if(FlightRecorder::instance().dumpRequested())
+            FlightRecorder::instance().dump("SIGUSR1");
+
+        long beat = heartbeat_.get();
+        uint64_t now = getMonotonicTime_us();
+        if(beat != lastBeat)
+        {
+            lastBeat = beat;
+            lastChange = now;
+            stallReported = false;
+        }
+        else if((beat & 1) && !stallReported && stallThreshold_ms_ > 0 &&
+                now - lastChange >= stallThreshold_ms_ * 1000ULL)
+        {
+            uint32_t stuck_ms = static_cast<uint32_t>((now - lastChange) / 1000);
+            log(LOG_WARN) << "Event loop stuck for " << stuck_ms << " ms, dumping flight recorder";
+            FlightRecorder::instance().record(FR_STALL, stuck_ms);
+            FlightRecorder::instance().dump("stall");
+            stallReported = true;
+        }
+    }
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#include "Platform/Threads/Runnable.h"
+#include "Platform/Threads/Condition.h"
+#include "Platform/Threads/Mutex.h"
+#include "Platform/Threads/Atomic.h"
+
+namespace Tracing
+{
+
+/* Bumped on entry to and exit from one iteration of a watched loop, so it is odd while inside it */
+class Heartbeat
+{
+private:
+    Platform::AtomicInt beats_;
+
+public:
+    void enter()        { beats_.increment(); }
+    void leave()        { beats_.increment(); }
+    long get() const    { return beats_.get(); }
+};
+
+/* Dumps the flight recorder when the watched loop has been inside one iteration
+ * for longer than the stall threshold (0 disables), or when asked to with SIGUSR1.
+ * Does nothing unless the flight recorder is enabled. */
+class Watchdog : public Platform::Runnable
+{
+private:
+    const Heartbeat& heartbeat_;
+    unsigned int stallThreshold_ms_;
+    bool running_;
+    Platform::Mutex mtx_;
+    Platform::Condition cond_;
+
+public:
+    Watchdog(const Heartbeat& heartbeat, unsigned int stallThreshold_ms);
+    virtual ~Watchdog();
+
+    void run();
+    void destroy();
+};
+
+}
+#endif /* WATCHDOG_H_ */
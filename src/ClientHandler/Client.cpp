@@ -28,12 +28,30 @@
 #include "Client.h"
 #include "applog.h"
 #include "MessageFactory/TlvDefinitions.h"
+#include "Metrics/Metrics.h"
+#include "Tracing/Tracer.h"
+#include "Platform/Utils/Utils.h"
+#include <algorithm>
+
+/* first protocol minor version that takes responses in parts, see TLV_MORE_TO_COME */
+static const uint32_t minorWithResponseParts = 5;
+
+/* search results each client keeps for paging on */
+static const size_t maxSearchCursors = 4;
 
 Client::Client(Socket* socket, MediaInterface& spotifyif) : SocketPeer(socket),
                                                             spotify_(spotifyif),
                                                             loggedIn_(true),
                                                             networkUsername_(""),
                                                             networkPassword_(""),
+                                                            peerProtocolMajor_(0),
+                                                            peerProtocolMinor_(0),
+                                                            nextCursor_(1),
+                                                            librarySubscribed_(false),
+                                                            libraryVersion_(0),
+                                                            tracingSend_(false),
+                                                            sendReqId_(0),
+                                                            sendStart_us_(0),
                                                             audioEp(NULL),
                                                             reqId_(0)
 {
@@ -53,7 +71,9 @@ void Client::setPassword(std::string password) { networkPassword_ = password; }
 
 void Client::processMessage(const Message* msg)
 {
-    log(LOG_NOTICE) << *(msg);
+    /* the full tlv tree is only worth walking when debugging */
+    log(LOG_NOTICE) << messageTypeToString(msg->getType()) << " id " << msg->getId();
+    log(LOG_DEBUG) << *(msg);
 
     /*require login before doing anything else (??if either username or password is set, for backward compatibility??)*/
     if ( /*(!networkUsername_.empty() || !networkPassword_.empty()) && */!loggedIn_ && msg->getType() != HELLO_REQ )
@@ -61,6 +81,18 @@ void Client::processMessage(const Message* msg)
         return;
     }
 
+    uint64_t arrival = getMonotonicTime_us();
+    if ( MSG_IS_REQUEST( msg->getType() ) )
+    {
+        static Metrics::Counter& requests = Metrics::Registry::instance().getCounter("client.requests");
+        requests.increment();
+        /* a request reusing the id of one still pending is dropped by its handler,
+         * the latency stays that of the first one */
+        pendingMessageMtx_.lock();
+        requestTimeMap_.insert( RequestTimeMap::value_type( msg->getId(), arrival ) );
+        pendingMessageMtx_.unlock();
+    }
+
     switch(msg->getType())
     {
         case HELLO_REQ:          handleHelloReq(msg);         break;
@@ -70,14 +102,246 @@ void Client::processMessage(const Message* msg)
         case PLAY_TRACK_REQ:     handlePlayTrackReq(msg);     break;
         case PLAY_CONTROL_REQ:   handlePlayControlReq(msg);   break;
         case GENERIC_SEARCH_REQ: handleGenericSearchReq(msg); break;
+        case SEARCH_SUGGEST_REQ: handleSearchSuggestReq(msg); break;
+        case LIBRARY_SUBSCRIBE_REQ: handleLibrarySubscribeReq(msg); break;
         case GET_STATUS_REQ:     handleGetStatusReq(msg);     break;
         case GET_IMAGE_REQ:      handleGetImageReq(msg);      break;
         case GET_ALBUM_REQ:      handleGetAlbumReq(msg);      break;
         case ADD_AUDIO_ENDPOINT_REQ: handleAddAudioEpReq(msg); break;
+        case GET_STATS_REQ:      handleGetStatsReq(msg);      break;
 
         default:
+            forgetRequest( msg->getId() );
             break;
     }
+
+    if ( MSG_IS_REQUEST( msg->getType() ) )
+    {
+        Tracing::Tracer::instance().record( "handle", static_cast<IMediaInterfaceCallbackSubscriber*>(this),
+                                            msg->getId(), arrival, getMonotonicTime_us() );
+    }
+}
+
+void Client::queueResponse( Message* rsp, const Message* req )
+{
+    queueResponse( rsp, req->getId() );
+}
+
+void Client::queueResponse( Message* rsp, unsigned int reqId )
+{
+    uint64_t arrival = 0;
+    Metrics::Histogram* latency = NULL;
+    /* response type is the request type with the response bit set */
+    MessageType_t reqType = static_cast<MessageType_t>( rsp->getType() & ~RSP_BIT );
+    pendingMessageMtx_.lock();
+    RequestTimeMap::iterator it = requestTimeMap_.find( reqId );
+    if ( it != requestTimeMap_.end() )
+    {
+        arrival = it->second;
+        requestTimeMap_.erase( it );
+
+        LatencyHistogramMap::iterator hist = latencyHistograms_.find( reqType );
+        if ( hist == latencyHistograms_.end() )
+        {
+            std::string name = std::string( "client." ) + messageTypeToString( reqType ) + ".latency_us";
+            hist = latencyHistograms_.insert( LatencyHistogramMap::value_type( reqType, &Metrics::Registry::instance().getHistogram( name ) ) ).first;
+        }
+        latency = hist->second;
+    }
+    pendingMessageMtx_.unlock();
+
+    if ( latency != NULL )
+    {
+        uint64_t now = getMonotonicTime_us();
+        latency->record( now - arrival );
+        Tracing::Tracer::instance().record( messageTypeToString( reqType ), static_cast<IMediaInterfaceCallbackSubscriber*>(this),
+                                            reqId, arrival, now );
+    }
+    Messenger::queueResponse( rsp, reqId );
+}
+
+/* for requests that are never answered, so their arrival isn't kept for the life of the connection */
+void Client::forgetRequest( unsigned int reqId )
+{
+    pendingMessageMtx_.lock();
+    requestTimeMap_.erase( reqId );
+    pendingMessageMtx_.unlock();
+}
+
+bool Client::addPendingMessage( unsigned int reqId, Message* rsp )
+{
+    pendingMessageMtx_.lock();
+    bool added = pendingMessageMap_.insert( PendingMessageMap::value_type( reqId, rsp ) ).second;
+    pendingMessageMtx_.unlock();
+    return added;
+}
+
+Message* Client::takePendingMessage( unsigned int reqId )
+{
+    Message* msg = NULL;
+    pendingMessageMtx_.lock();
+    PendingMessageMap::iterator it = pendingMessageMap_.find( reqId );
+    if ( it != pendingMessageMap_.end() )
+    {
+        msg = it->second;
+        pendingMessageMap_.erase( it );
+    }
+    pendingMessageMtx_.unlock();
+    return msg;
+}
+
+void Client::addResultPage( const Message* req, bool keepResult )
+{
+    const IntTlv* offset = (const IntTlv*) req->getTlvRoot()->getTlv( TLV_RESULT_OFFSET );
+    const IntTlv* count = (const IntTlv*) req->getTlvRoot()->getTlv( TLV_RESULT_COUNT );
+    if ( count == NULL )
+        return;
+
+    ResultPage page( offset ? offset->getVal() : 0, count->getVal() );
+    if ( keepResult )
+        page.result_.reset( new std::deque<Track> );
+
+    pendingMessageMtx_.lock();
+    resultPageMap_.insert( ResultPageMap::value_type( req->getId(), page ) );
+    pendingMessageMtx_.unlock();
+}
+
+/* adds the tracks that are on the requested page to parent (the message itself if NULL),
+ * all of them if no page was asked for. With the last tracks of the list the total,
+ * and for a search that goes on for more pages its cursor, are added. Returns the tracks added */
+uint32_t Client::addPagedTracks( Message* rsp, TlvContainer* parent, unsigned int reqId, const std::deque<Track>& tracks, bool last )
+{
+    uint32_t added = 0;
+    pendingMessageMtx_.lock();
+    ResultPageMap::iterator it = resultPageMap_.find( reqId );
+    for ( std::deque<Track>::const_iterator trackIt = tracks.begin(); trackIt != tracks.end(); trackIt++ )
+    {
+        if ( it != resultPageMap_.end() )
+        {
+            ResultPage& page = it->second;
+            uint32_t index = page.passed_++;
+            if ( !page.result_.isNull() )
+                page.result_->push_back( *trackIt );
+            if ( index < page.offset_ || index - page.offset_ >= page.count_ )
+                continue;
+        }
+
+        if ( parent )
+            parent->addTlv( (*trackIt).toTlv() );
+        else
+            rsp->addTlv( (*trackIt).toTlv() );
+        added++;
+    }
+
+    if ( last && it != resultPageMap_.end() )
+    {
+        ResultPage& page = it->second;
+        rsp->addTlv( TLV_RESULT_TOTAL, page.passed_ );
+        if ( !page.result_.isNull() && page.passed_ > page.count_ )
+        {
+            searchCursors_.push_back( std::make_pair( nextCursor_, Platform::SharedPtr<const std::deque<Track> >( page.result_ ) ) );
+            if ( searchCursors_.size() > maxSearchCursors )
+                searchCursors_.pop_front();
+            rsp->addTlv( TLV_RESULT_CURSOR, nextCursor_++ );
+        }
+        resultPageMap_.erase( it );
+    }
+    pendingMessageMtx_.unlock();
+    return added;
+}
+
+/* answers a request for another page of a kept search result,
+ * false if the request has no cursor or it is not kept any more */
+bool Client::respondFromCursor( const Message* req )
+{
+    const IntTlv* cursor = (const IntTlv*) req->getTlvRoot()->getTlv( TLV_RESULT_CURSOR );
+    if ( cursor == NULL )
+        return false;
+
+    Platform::SharedPtr<const std::deque<Track> > result;
+    pendingMessageMtx_.lock();
+    for ( SearchCursors::const_iterator it = searchCursors_.begin(); it != searchCursors_.end(); it++ )
+    {
+        if ( it->first == cursor->getVal() )
+            result = it->second;
+    }
+    pendingMessageMtx_.unlock();
+
+    if ( result.isNull() )
+        return false;
+
+    Message* rsp = new Message( GENERIC_SEARCH_RSP );
+    addResultPage( req, false );
+    addPagedTracks( rsp, NULL, req->getId(), *result, true );
+    rsp->addTlv( TLV_RESULT_CURSOR, cursor->getVal() );
+    if ( peerProtocolMinor_ >= minorWithResponseParts )
+        rsp->addTlv( TLV_MORE_TO_COME, 0 );
+    queueResponse( rsp, req );
+    return true;
+}
+
+void Client::addKnownVersion( const Message* req )
+{
+    const IntTlv* version = (const IntTlv*) req->getTlvRoot()->getTlv( TLV_CONTENT_VERSION );
+    if ( version == NULL )
+        return;
+
+    pendingMessageMtx_.lock();
+    knownVersionMap_[req->getId()] = version->getVal();
+    pendingMessageMtx_.unlock();
+}
+
+/* adds the version to the response. True if the client already has it,
+ * the response is then complete and the content is to be left out */
+bool Client::isNotModified( Message* rsp, unsigned int reqId, uint32_t version )
+{
+    bool notModified = false;
+    pendingMessageMtx_.lock();
+    KnownVersionMap::iterator it = knownVersionMap_.find( reqId );
+    if ( it != knownVersionMap_.end() )
+    {
+        notModified = ( it->second == version );
+        knownVersionMap_.erase( it );
+    }
+    if ( notModified )
+        resultPageMap_.erase( reqId );
+    pendingMessageMtx_.unlock();
+
+    rsp->addTlv( TLV_CONTENT_VERSION, version );
+    if ( notModified )
+        rsp->addTlv( TLV_NOT_MODIFIED, 1 );
+    return notModified;
+}
+
+void Client::messageEncoding( const Message* msg )
+{
+    tracingSend_ = MSG_IS_RESPONSE( msg->getType() ) && Tracing::Tracer::instance().isEnabled();
+    if ( tracingSend_ )
+    {
+        sendReqId_ = msg->getId();
+        sendStart_us_ = getMonotonicTime_us();
+    }
+}
+
+void Client::messageEncoded( const Message* msg )
+{
+    if ( tracingSend_ )
+    {
+        uint64_t now = getMonotonicTime_us();
+        Tracing::Tracer::instance().record( "encode", static_cast<IMediaInterfaceCallbackSubscriber*>(this),
+                                            sendReqId_, sendStart_us_, now );
+        sendStart_us_ = now;
+    }
+}
+
+void Client::messageSent()
+{
+    if ( tracingSend_ )
+    {
+        Tracing::Tracer::instance().record( "send", static_cast<IMediaInterfaceCallbackSubscriber*>(this),
+                                            sendReqId_, sendStart_us_, getMonotonicTime_us() );
+        tracingSend_ = false;
+    }
 }
 
 void Client::connectionState( bool up )
@@ -119,31 +383,25 @@ void Client::statusUpdateInd( PlaybackState_t state, bool repeatStatus, bool shu
 
 void Client::getStatusResponse( MediaInterfaceRequestId reqId, PlaybackState_t state, bool repeatStatus, bool shuffleStatus, const Track& currentTrack, unsigned int progress )
 {
-    PendingMessageMap::iterator msgIt = pendingMessageMap_.find(reqId);
-    if (msgIt != pendingMessageMap_.end())
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
     {
-        Message* msg = msgIt->second;
-
         addStatusMsgMandatoryParameters( msg, state, repeatStatus, shuffleStatus );
         addStatusMsgOptionalParameters( msg, currentTrack, progress );
 
         queueResponse( msg, reqId );
-        pendingMessageMap_.erase(msgIt);
     }
     else log(LOG_WARN) << "Could not match the getStatusResponse() to a pending response";
 
 }
 void Client::getStatusResponse( MediaInterfaceRequestId reqId, PlaybackState_t state, bool repeatStatus, bool shuffleStatus )
 {
-    PendingMessageMap::iterator msgIt = pendingMessageMap_.find(reqId);
-    if (msgIt != pendingMessageMap_.end())
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
     {
-        Message* msg = msgIt->second;
-
         addStatusMsgMandatoryParameters( msg, state, repeatStatus, shuffleStatus );
 
         queueResponse( msg, reqId );
-        pendingMessageMap_.erase(msgIt);
     }
     else log(LOG_WARN) << "Could not match the getStatusResponse() to a pending response";
 }
@@ -151,16 +409,14 @@ void Client::getStatusResponse( MediaInterfaceRequestId reqId, PlaybackState_t s
 
 void Client::getPlaylistsResponse( MediaInterfaceRequestId reqId, const Folder& rootfolder )
 {
-    PendingMessageMap::iterator msgIt = pendingMessageMap_.find(reqId);
-    if (msgIt != pendingMessageMap_.end())
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
     {
-        Message* msg = msgIt->second;
-
         /*get playlist*/
-        msg->addTlv( rootfolder.toTlv() );
+        if (!isNotModified(msg, reqId, rootfolder.getVersion()))
+            msg->addTlv( rootfolder.toTlv() );
 
         queueResponse( msg, reqId );
-        pendingMessageMap_.erase(msgIt);
     }
     else log(LOG_WARN) << "Could not match the getPlaylistsResponse() to a pending response";
 }
@@ -168,45 +424,54 @@ void Client::getTracksResponse(MediaInterfaceRequestId reqId, const std::deque<T
 {
     log(LOG_DEBUG) << "Client::getTracksResponse()";
 
-    PendingMessageMap::iterator msgIt = pendingMessageMap_.find(reqId);
-    if (msgIt != pendingMessageMap_.end())
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
     {
-        Message* msg = msgIt->second;
-        for (std::deque<Track>::const_iterator trackIt = tracks.begin(); trackIt != tracks.end(); trackIt++)
-        {
-            log(LOG_DEBUG) << "\t" << (*trackIt).getName();
-            msg->addTlv((*trackIt).toTlv());
-        }
+        if (!isNotModified(msg, reqId, Playlist::getTracksVersion(tracks)))
+            addPagedTracks(msg, NULL, reqId, tracks, true);
         log(LOG_DEBUG) << "#tracks found=" << tracks.size();
 
         queueResponse( msg, reqId );
-        pendingMessageMap_.erase(msgIt);
     }
     else log(LOG_WARN) << "Could not match the getTracksResponse() to a pending response";
 }
 
+void Client::requestFailed(MediaInterfaceRequestId reqId, FailureCause_t cause)
+{
+    pendingMessageMtx_.lock();
+    resultPageMap_.erase(reqId);
+    knownVersionMap_.erase(reqId);
+    pendingMessageMtx_.unlock();
+
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
+    {
+        msg->addTlv(TLV_FAILURE, cause);
+
+        queueResponse( msg, reqId );
+    }
+    else log(LOG_WARN) << "Could not match the requestFailed() to a pending response";
+}
+
 void Client::getAlbumResponse(MediaInterfaceRequestId reqId, const Album& album)
 {
     log(LOG_DEBUG) << "Client::getAlbumResponse()";
 
-    PendingMessageMap::iterator msgIt = pendingMessageMap_.find(reqId);
-    if (msgIt != pendingMessageMap_.end())
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
     {
-        Message* msg = msgIt->second;
-        TlvContainer* albumTlv = album.toTlv();
-        const std::deque<Track>& tracks = album.getTracks();
-
-        for (std::deque<Track>::const_iterator trackIt = tracks.begin(); trackIt != tracks.end(); trackIt++)
+        if (!isNotModified(msg, reqId, album.getVersion()))
         {
-            log(LOG_DEBUG) << "\t" << (*trackIt).getName();
-            albumTlv->addTlv((*trackIt).toTlv());
-        }
-        log(LOG_DEBUG) << "#tracks found=" << tracks.size();
+            TlvContainer* albumTlv = album.toTlv();
+            const std::deque<Track>& tracks = album.getTracks();
+
+            addPagedTracks(msg, albumTlv, reqId, tracks, true);
+            log(LOG_DEBUG) << "#tracks found=" << tracks.size();
 
-        msg->addTlv(albumTlv);
+            msg->addTlv(albumTlv);
+        }
 
         queueResponse( msg, reqId );
-        pendingMessageMap_.erase(msgIt);
     }
     else log(LOG_WARN) << "Could not match the getAlbumResponse() to a pending response";
 }
@@ -214,10 +479,9 @@ void Client::getAlbumResponse(MediaInterfaceRequestId reqId, const Album& album)
 void Client::getImageResponse(MediaInterfaceRequestId reqId, const void* data, size_t dataSize)
 {
     log(LOG_DEBUG) << "Client::getImageResponse() " << dataSize << " bytes";
-    PendingMessageMap::iterator msgIt = pendingMessageMap_.find(reqId);
-    if (msgIt != pendingMessageMap_.end())
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
     {
-        Message* msg = msgIt->second;
         if(data && dataSize)
         {
             TlvContainer* image = new TlvContainer(TLV_IMAGE);
@@ -226,33 +490,143 @@ void Client::getImageResponse(MediaInterfaceRequestId reqId, const void* data, s
             msg->addTlv(image);
         }
         queueResponse( msg, reqId );
-        pendingMessageMap_.erase(msgIt);
     }
     else log(LOG_WARN) << "Could not match the getImageResponse() to a pending response";
 
 }
 
+void Client::getImageFileResponse(MediaInterfaceRequestId reqId, const std::string& path)
+{
+    log(LOG_DEBUG) << "Client::getImageFileResponse() " << path;
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
+    {
+        /* the file is opened when the message is encoded and sent straight from it */
+        TlvContainer* image = new TlvContainer(TLV_IMAGE);
+        image->addTlv(TLV_IMAGE_FORMAT, IMAGE_FORMAT_JPEG);
+        image->addTlv(new FileTlv(TLV_IMAGE_DATA, path));
+        msg->addTlv(image);
+        queueResponse( msg, reqId );
+    }
+    else log(LOG_WARN) << "Could not match the getImageFileResponse() to a pending response";
+}
+
 void Client::genericSearchCallback(MediaInterfaceRequestId reqId, const std::deque<Track>& tracks, const std::string& didYouMean)
 {
     log(LOG_DEBUG) << "\tdid you mean:" << didYouMean;
 
-    PendingMessageMap::iterator msgIt = pendingMessageMap_.find(reqId);
-    if (msgIt != pendingMessageMap_.end())
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
     {
-        Message* msg = msgIt->second;
-        for (std::deque<Track>::const_iterator trackIt = tracks.begin(); trackIt != tracks.end(); trackIt++)
-        {
-            log(LOG_DEBUG) << "\t" << (*trackIt).getName();
-            msg->addTlv((*trackIt).toTlv());
-        }
+        addPagedTracks(msg, NULL, reqId, tracks, true);
         log(LOG_DEBUG) << "#tracks found=" << tracks.size();
 
+        if (peerProtocolMinor_ >= minorWithResponseParts)
+            msg->addTlv(TLV_MORE_TO_COME, 0);
+
         queueResponse( msg, reqId );
-        pendingMessageMap_.erase(msgIt);
     }
     else log(LOG_WARN) << "Could not match the genericSearchCallback() to a pending response";
 }
 
+void Client::genericSearchPartCallback(MediaInterfaceRequestId reqId, const std::deque<Track>& tracks)
+{
+    log(LOG_DEBUG) << "#tracks in part=" << tracks.size();
+
+    pendingMessageMtx_.lock();
+    PendingMessageMap::iterator it = pendingMessageMap_.find( reqId );
+    Message* pending = ( it != pendingMessageMap_.end() ) ? it->second : NULL;
+    pendingMessageMtx_.unlock();
+
+    if ( pending == NULL )
+    {
+        log(LOG_WARN) << "Could not match the genericSearchPartCallback() to a pending response";
+    }
+    else if ( peerProtocolMinor_ < minorWithResponseParts )
+    {
+        /* the peer expects a single response, collect the parts in it.
+         * Nothing else touches it before the last part takes it, all parts come from the same thread */
+        addPagedTracks( pending, NULL, reqId, tracks, false );
+    }
+    else
+    {
+        /* the pending response stays for the final part, parts that are all off the requested page are left out */
+        Message* part = new Message(GENERIC_SEARCH_RSP);
+        if ( addPagedTracks( part, NULL, reqId, tracks, false ) > 0 )
+        {
+            part->addTlv(TLV_MORE_TO_COME, 1);
+            queueResponse( part, reqId );
+        }
+        else delete part;
+    }
+}
+
+void Client::searchSuggestResponse(MediaInterfaceRequestId reqId, const std::vector<Suggestion>& suggestions)
+{
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
+    {
+        for (std::vector<Suggestion>::const_iterator it = suggestions.begin(); it != suggestions.end(); it++)
+            msg->addTlv(it->toTlv());
+
+        queueResponse( msg, reqId );
+    }
+    else log(LOG_WARN) << "Could not match the searchSuggestResponse() to a pending response";
+}
+
+void Client::addLibraryChanges( Message* msg, unsigned int version, const std::vector<LibraryChange>& changes, const Folder* resync )
+{
+    msg->addTlv( TLV_LIBRARY_VERSION, version );
+    if (resync)
+    {
+        msg->addTlv( TLV_LIBRARY_RESYNC, 1 );
+        msg->addTlv( resync->toTlv() );
+    }
+    else
+    {
+        for (std::vector<LibraryChange>::const_iterator it = changes.begin(); it != changes.end(); it++)
+            msg->addTlv( it->toTlv() );
+    }
+    libraryVersion_ = version;
+}
+
+void Client::librarySubscribeResponse( MediaInterfaceRequestId reqId, unsigned int epoch, unsigned int version, const std::vector<LibraryChange>& changes, const Folder* resync )
+{
+    Message* msg = takePendingMessage(reqId);
+    if (msg)
+    {
+        msg->addTlv( TLV_LIBRARY_EPOCH, epoch );
+        addLibraryChanges( msg, version, changes, resync );
+        librarySubscribed_ = true;
+
+        queueResponse( msg, reqId );
+    }
+    else log(LOG_WARN) << "Could not match the librarySubscribeResponse() to a pending response";
+}
+
+void Client::libraryChangedInd( unsigned int from, unsigned int to, const std::vector<LibraryChange>& changes, const Folder* resync )
+{
+    if (!librarySubscribed_)
+        return;
+
+    Message* msg = new Message(LIBRARY_CHANGED_IND);
+
+    if (from != libraryVersion_ && !resync)
+    {
+        /* the changes don't apply to what the peer has, it has to get the root folder again */
+        log(LOG_NOTICE) << "Library of peer at version " << libraryVersion_ << ", changes are from " << from;
+        msg->addTlv( TLV_LIBRARY_VERSION, to );
+        msg->addTlv( TLV_LIBRARY_RESYNC, 1 );
+        libraryVersion_ = to;
+    }
+    else
+    {
+        addLibraryChanges( msg, to, changes, resync );
+    }
+
+    queueMessage( msg, reqId_++ );
+}
+
 void Client::handleGetTracksReq(const Message* msg)
 {
     GetTracksReq* req = (GetTracksReq*)msg;
@@ -260,9 +634,18 @@ void Client::handleGetTracksReq(const Message* msg)
 
     Message* rsp  = new Message(GET_TRACKS_RSP);
     unsigned int headerId = req->getId();
-    pendingMessageMap_[headerId] = rsp;
 
-    spotify_.getTracks( req->getPlaylist(), this, headerId );
+    /* make sure that the pending message queue does not already contain such a message */
+    if (addPendingMessage(headerId, rsp))
+    {
+        addResultPage(msg, false);
+        addKnownVersion(msg);
+        spotify_.getTracks( req->getPlaylist(), this, headerId );
+    }
+    else
+    {
+        delete rsp;
+    }
 }
 
 void Client::handleHelloReq(const Message* msg)
@@ -319,9 +702,9 @@ void Client::handleGetPlaylistsReq(const Message* msg)
     Message* rsp = new Message(GET_PLAYLISTS_RSP);
 
     /* make sure that the pending message queue does not already contain such a message */
-    if (pendingMessageMap_.find(headerId) == pendingMessageMap_.end())
+    if (addPendingMessage(headerId, rsp))
     {
-        pendingMessageMap_[headerId] = rsp;
+        addKnownVersion(msg);
         spotify_.getPlaylists( this, headerId );
     }
     else
@@ -336,9 +719,8 @@ void Client::handleGetStatusReq(const Message* msg)
     Message* rsp = new Message(GET_STATUS_RSP);
 
     /* make sure that the pending message queue does not already contain such a message */
-    if (pendingMessageMap_.find(headerId) == pendingMessageMap_.end())
+    if (addPendingMessage(headerId, rsp))
     {
-        pendingMessageMap_[headerId] = rsp;
         spotify_.getStatus( this, headerId );
     }
     else
@@ -440,9 +822,8 @@ void Client::handleGetImageReq(const Message* msg)
     Message* rsp = new Message(GET_IMAGE_RSP);
 
     /* make sure that the pending message queue does not already contain such a message */
-    if (pendingMessageMap_.find(headerId) == pendingMessageMap_.end())
+    if (addPendingMessage(headerId, rsp))
     {
-        pendingMessageMap_[headerId] = rsp;
         spotify_.getImage( link ? link->getString() : std::string(""), this, headerId );
     }
     else
@@ -455,15 +836,19 @@ void Client::handleGenericSearchReq(const Message* msg)
 {
     const StringTlv* query = (const StringTlv*) msg->getTlvRoot()->getTlv(TLV_SEARCH_QUERY);
 
+    /* another page of a result that is kept, no need to search again */
+    if (respondFromCursor(msg))
+        return;
+
     if (query && query->getString() != "")
     {
         unsigned int headerId = msg->getId();
         Message* rsp = new Message(GENERIC_SEARCH_RSP);
 
         /* make sure that the pending message queue does not already contain such a message */
-        if (pendingMessageMap_.find(headerId) == pendingMessageMap_.end())
+        if (addPendingMessage(headerId, rsp))
         {
-            pendingMessageMap_[headerId] = rsp;
+            addResultPage(msg, true);
             spotify_.search( query->getString(), this, headerId );
         }
         else
@@ -471,9 +856,58 @@ void Client::handleGenericSearchReq(const Message* msg)
             delete rsp;
         }
     }
+    else if (msg->getTlvRoot()->getTlv(TLV_RESULT_CURSOR))
+    {
+        Message* rsp = new Message(GENERIC_SEARCH_RSP);
+        rsp->addTlv(TLV_FAILURE, FAIL_CURSOR_EXPIRED);
+        queueResponse( rsp, msg );
+    }
     else
     {
         /*error handling?*/
+        forgetRequest( msg->getId() );
+    }
+}
+
+void Client::handleSearchSuggestReq(const Message* msg)
+{
+    /* an empty or missing prefix gives the best suggestions overall */
+    const StringTlv* prefix = (const StringTlv*) msg->getTlvRoot()->getTlv(TLV_SEARCH_QUERY);
+    const IntTlv* count = (const IntTlv*) msg->getTlvRoot()->getTlv(TLV_SEARCH_COUNT);
+
+    unsigned int headerId = msg->getId();
+    Message* rsp = new Message(SEARCH_SUGGEST_RSP);
+
+    /* make sure that the pending message queue does not already contain such a message */
+    if (addPendingMessage(headerId, rsp))
+    {
+        spotify_.suggest( prefix ? prefix->getString() : std::string(""),
+                          count ? std::min<unsigned int>(count->getVal(), 50) : 10,
+                          this, headerId );
+    }
+    else
+    {
+        delete rsp;
+    }
+}
+
+void Client::handleLibrarySubscribeReq(const Message* msg)
+{
+    /* the version of the root folder the peer has and the epoch it is from, none means nothing */
+    const IntTlv* epoch = (const IntTlv*) msg->getTlvRoot()->getTlv(TLV_LIBRARY_EPOCH);
+    const IntTlv* version = (const IntTlv*) msg->getTlvRoot()->getTlv(TLV_LIBRARY_VERSION);
+
+    unsigned int headerId = msg->getId();
+    Message* rsp = new Message(LIBRARY_SUBSCRIBE_RSP);
+
+    /* make sure that the pending message queue does not already contain such a message */
+    if (addPendingMessage(headerId, rsp))
+    {
+        spotify_.subscribeLibrary( epoch ? epoch->getVal() : 0, version ? version->getVal() : 0, this, headerId );
+    }
+    else
+    {
+        delete rsp;
     }
 }
 
@@ -485,9 +919,10 @@ void Client::handleGetAlbumReq(const Message* msg)
     Message* rsp = new Message(GET_ALBUM_RSP);
 
     /* make sure that the pending message queue does not already contain such a message */
-    if (pendingMessageMap_.find(headerId) == pendingMessageMap_.end())
+    if (addPendingMessage(headerId, rsp))
     {
-        pendingMessageMap_[headerId] = rsp;
+        addResultPage(msg, false);
+        addKnownVersion(msg);
         spotify_.getAlbum( link ? link->getString() : std::string(""), this, headerId );
     }
     else
@@ -501,7 +936,12 @@ void Client::handleAddAudioEpReq(const Message* msg)
 {
     /*audioEp = new Platform::AudioEndpointRemote();
     spotify_.setAudioEndpoint(audioEp);*/
+    forgetRequest( msg->getId() );
 }
 
-
-
+void Client::handleGetStatsReq(const Message* msg)
+{
+    Message* rsp = new Message( GET_STATS_RSP );
+    rsp->addTlv( Metrics::Registry::instance().toTlv() );
+    queueResponse( rsp, msg );
+}
@@ -32,7 +32,11 @@
 #include "SocketHandling/SocketPeer.h"
 #include "MessageFactory/MessageEncoder.h"
 #include "Platform/AudioEndpoints/AudioEndpointRemote.h"
+#include "Platform/Threads/Mutex.h"
+#include "Platform/Threads/SharedPtr.h"
+#include "Metrics/Metrics.h"
 #include <map>
+#include <deque>
 
 using namespace LibSpotify;
 
@@ -52,6 +56,71 @@ private:
     typedef std::map<unsigned int, Message*>  PendingMessageMap;
     PendingMessageMap pendingMessageMap_;
 
+    /* when each outstanding request arrived, for the latency metrics */
+    typedef std::map<unsigned int, uint64_t>  RequestTimeMap;
+    RequestTimeMap requestTimeMap_;
+    void forgetRequest( unsigned int reqId );
+    /* latency histogram of each request type, looked up in the registry the first time */
+    typedef std::map<MessageType_t, Metrics::Histogram*> LatencyHistogramMap;
+    LatencyHistogramMap latencyHistograms_;
+
+    /* the page of a track list that a request asked for, see TLV_RESULT_OFFSET/COUNT */
+    class ResultPage
+    {
+    public:
+        uint32_t offset_;
+        uint32_t count_;
+        /* tracks of the list passed on so far, a search result comes in parts */
+        uint32_t passed_;
+        /* the whole search result, kept for the following pages */
+        Platform::SharedPtr<std::deque<Track> > result_;
+        ResultPage( uint32_t offset, uint32_t count ) : offset_(offset), count_(count), passed_(0) {}
+    };
+    typedef std::map<unsigned int, ResultPage> ResultPageMap;
+    ResultPageMap resultPageMap_;
+
+    /* the TLV_CONTENT_VERSION requests came with */
+    typedef std::map<unsigned int, uint32_t> KnownVersionMap;
+    KnownVersionMap knownVersionMap_;
+
+    /* search results that more pages may be asked for, oldest first */
+    typedef std::deque< std::pair<uint32_t, Platform::SharedPtr<const std::deque<Track> > > > SearchCursors;
+    SearchCursors searchCursors_;
+    uint32_t nextCursor_;
+
+    /* responses are filled in from other threads than the one requests arrive on */
+    Platform::Mutex pendingMessageMtx_;
+    bool addPendingMessage( unsigned int reqId, Message* rsp );
+    Message* takePendingMessage( unsigned int reqId );
+
+    /* paging state is kept under pendingMessageMtx_ as well */
+    void addResultPage( const Message* req, bool keepResult );
+    uint32_t addPagedTracks( Message* rsp, TlvContainer* parent, unsigned int reqId, const std::deque<Track>& tracks, bool last );
+    bool respondFromCursor( const Message* req );
+
+    /* conditional requests, also under pendingMessageMtx_ */
+    void addKnownVersion( const Message* req );
+    bool isNotModified( Message* rsp, unsigned int reqId, uint32_t version );
+
+    /* LIBRARY_CHANGED_IND is only sent after LIBRARY_SUBSCRIBE, and only from the version
+     * last sent. Both are only touched from the library callbacks, which come in order */
+    bool librarySubscribed_;
+    unsigned int libraryVersion_;
+    void addLibraryChanges( Message* msg, unsigned int version, const std::vector<LibraryChange>& changes, const Folder* resync );
+
+    /* hides the Messenger versions so that every response gets its latency recorded */
+    void queueResponse( Message* rsp, const Message* req );
+    void queueResponse( Message* rsp, unsigned int reqId );
+
+    /* the response currently being encoded/sent, for the request trace */
+    bool tracingSend_;
+    unsigned int sendReqId_;
+    uint64_t sendStart_us_;
+
+    virtual void messageEncoding(const Message* msg);
+    virtual void messageEncoded(const Message* msg);
+    virtual void messageSent();
+
     Platform::AudioEndpointRemote* audioEp;
 
     unsigned int reqId_;
@@ -70,10 +139,16 @@ private:
     virtual void getPlaylistsResponse( MediaInterfaceRequestId reqId, const Folder& rootfolder );
     virtual void getTracksResponse( MediaInterfaceRequestId reqId, const std::deque<Track>& tracks );
     virtual void getImageResponse( MediaInterfaceRequestId reqId, const void* data, size_t dataSize );
+    virtual void getImageFileResponse( MediaInterfaceRequestId reqId, const std::string& path );
     virtual void getAlbumResponse( MediaInterfaceRequestId reqId, const Album& album );
     virtual void genericSearchCallback( MediaInterfaceRequestId reqId, const std::deque<Track>& listOfTracks, const std::string& didYouMean);
+    virtual void genericSearchPartCallback( MediaInterfaceRequestId reqId, const std::deque<Track>& listOfTracks );
+    virtual void searchSuggestResponse( MediaInterfaceRequestId reqId, const std::vector<Suggestion>& suggestions );
+    virtual void librarySubscribeResponse( MediaInterfaceRequestId reqId, unsigned int epoch, unsigned int version, const std::vector<LibraryChange>& changes, const Folder* resync );
+    virtual void libraryChangedInd( unsigned int from, unsigned int to, const std::vector<LibraryChange>& changes, const Folder* resync );
     virtual void getStatusResponse( MediaInterfaceRequestId reqId, PlaybackState_t state, bool repeatStatus, bool shuffleStatus, const Track& currentTrack, unsigned int progress );
     virtual void getStatusResponse( MediaInterfaceRequestId reqId, PlaybackState_t state, bool repeatStatus, bool shuffleStatus );
+    virtual void requestFailed( MediaInterfaceRequestId reqId, FailureCause_t cause );
 
 private:
     /* Message Handler functions*/
@@ -87,9 +162,12 @@ private:
     void handlePlayControlReq(const Message* msg);
     void handleGetImageReq(const Message* msg);
     void handleGenericSearchReq(const Message* msg);
+    void handleSearchSuggestReq(const Message* msg);
+    void handleLibrarySubscribeReq(const Message* msg);
     void handleGetAlbumReq(const Message* msg);
     void handleAddAudioEpReq(const Message* msg);
     void handleRemAudioEpReq(const Message* msg);
+    void handleGetStatsReq(const Message* msg);
 
 public:
 
@@ -47,6 +47,15 @@ void ConfigHandler::parseConfigFile()
     std::string spotifyPassword;
     std::string spotifyCacheLocation;
     std::string spotifySettingsLocation;
+    std::string spotifyMetadataCacheSize;
+    std::string spotifyImageCacheSize;
+    std::string spotifyImageCacheLocation;
+    std::string spotifyImageCacheDiskSize;
+    std::string spotifyLibrarySnapshotFile;
+    std::string spotifyResponseWorkers;
+    std::string spotifyReadaheadTracks;
+    std::string spotifyReadaheadConcurrency;
+    std::string spotifySuggestionTrieSize;
     /* Network Section*/
     std::string networkBindType;
     std::string networkIp;
@@ -60,6 +69,15 @@ void ConfigHandler::parseConfigFile()
     /* Logger Section */
     std::string loggerLogLevel;
     std::string loggerLogFile;
+    std::string loggerMaxLogFileSize;
+    std::string loggerLogFileRotations;
+    std::string loggerMetricsLogInterval;
+    std::string loggerTraceBufferSize;
+    std::string loggerTraceFile;
+    std::string loggerFlightRecorderSize;
+    std::string loggerFlightRecorderFile;
+    std::string loggerStallThreshold;
+    std::string loggerMutexWaitThreshold;
 
     SectionAttributes parseDefintion[] = {
 
@@ -69,6 +87,15 @@ void ConfigHandler::parseConfigFile()
         {1,     TYPE_ATTRIBUTE,               "Password",              &spotifyPassword            },
         {1,     TYPE_ATTRIBUTE,               "CacheLocation",         &spotifyCacheLocation       },
         {1,     TYPE_ATTRIBUTE,               "SettingsLocation",      &spotifySettingsLocation    },
+        {1,     TYPE_ATTRIBUTE,               "MetadataCacheSize",     &spotifyMetadataCacheSize   },
+        {1,     TYPE_ATTRIBUTE,               "ImageCacheSize",        &spotifyImageCacheSize      },
+        {1,     TYPE_ATTRIBUTE,               "ImageCacheLocation",    &spotifyImageCacheLocation  },
+        {1,     TYPE_ATTRIBUTE,               "ImageCacheDiskSize",    &spotifyImageCacheDiskSize  },
+        {1,     TYPE_ATTRIBUTE,               "LibrarySnapshotFile",   &spotifyLibrarySnapshotFile },
+        {1,     TYPE_ATTRIBUTE,               "ResponseWorkers",       &spotifyResponseWorkers     },
+        {1,     TYPE_ATTRIBUTE,               "ReadaheadTracks",       &spotifyReadaheadTracks     },
+        {1,     TYPE_ATTRIBUTE,               "ReadaheadConcurrency",  &spotifyReadaheadConcurrency},
+        {1,     TYPE_ATTRIBUTE,               "SuggestionTrieSize",    &spotifySuggestionTrieSize  },
 
         /* Network Section*/
         {0,     TYPE_SECTION,                 "Network",               NULL                        },
@@ -88,7 +115,16 @@ void ConfigHandler::parseConfigFile()
         /* Logger Section*/
         {0,     TYPE_SECTION,                 "Logger",                NULL                        },
         {1,     TYPE_ATTRIBUTE,               "LogLevel",              &loggerLogLevel             },
-        {1,     TYPE_ATTRIBUTE,               "LogFile",               &loggerLogFile              }
+        {1,     TYPE_ATTRIBUTE,               "LogFile",               &loggerLogFile              },
+        {1,     TYPE_ATTRIBUTE,               "MaxLogFileSize",        &loggerMaxLogFileSize       },
+        {1,     TYPE_ATTRIBUTE,               "LogFileRotations",      &loggerLogFileRotations     },
+        {1,     TYPE_ATTRIBUTE,               "MetricsLogInterval",    &loggerMetricsLogInterval   },
+        {1,     TYPE_ATTRIBUTE,               "TraceBufferSize",       &loggerTraceBufferSize      },
+        {1,     TYPE_ATTRIBUTE,               "TraceFile",             &loggerTraceFile            },
+        {1,     TYPE_ATTRIBUTE,               "FlightRecorderSize",    &loggerFlightRecorderSize   },
+        {1,     TYPE_ATTRIBUTE,               "FlightRecorderFile",    &loggerFlightRecorderFile   },
+        {1,     TYPE_ATTRIBUTE,               "StallThreshold",        &loggerStallThreshold       },
+        {1,     TYPE_ATTRIBUTE,               "MutexWaitThreshold",    &loggerMutexWaitThreshold   }
 	};
 
 	parseConfig(configString, parseDefintion);
@@ -98,6 +134,15 @@ void ConfigHandler::parseConfigFile()
 	spotifyConfig_.setPassword(spotifyPassword);
 	spotifyConfig_.setCacheLocation(spotifyCacheLocation);
 	spotifyConfig_.setSettingsLocation(spotifySettingsLocation);
+	spotifyConfig_.setMetadataCacheSize(spotifyMetadataCacheSize);
+	spotifyConfig_.setImageCacheSize(spotifyImageCacheSize);
+	spotifyConfig_.setImageCacheLocation(spotifyImageCacheLocation);
+	spotifyConfig_.setImageCacheDiskSize(spotifyImageCacheDiskSize);
+	spotifyConfig_.setLibrarySnapshotFile(spotifyLibrarySnapshotFile);
+	spotifyConfig_.setResponseWorkers(spotifyResponseWorkers);
+	spotifyConfig_.setReadaheadTracks(spotifyReadaheadTracks);
+	spotifyConfig_.setReadaheadConcurrency(spotifyReadaheadConcurrency);
+	spotifyConfig_.setSuggestionTrieSize(spotifySuggestionTrieSize);
 
 	/* Network */
 	networkConfig_.setBindType(networkBindType);
@@ -114,6 +159,15 @@ void ConfigHandler::parseConfigFile()
 	/* Logger */
 	loggerConfig_.setLogLevel(loggerLogLevel);
 	loggerConfig_.setLogFile(loggerLogFile);
+	loggerConfig_.setMaxLogFileSize(loggerMaxLogFileSize);
+	loggerConfig_.setLogFileRotations(loggerLogFileRotations);
+	loggerConfig_.setMetricsLogInterval(loggerMetricsLogInterval);
+	loggerConfig_.setTraceBufferSize(loggerTraceBufferSize);
+	loggerConfig_.setTraceFile(loggerTraceFile);
+	loggerConfig_.setFlightRecorderSize(loggerFlightRecorderSize);
+	loggerConfig_.setFlightRecorderFile(loggerFlightRecorderFile);
+	loggerConfig_.setStallThreshold(loggerStallThreshold);
+	loggerConfig_.setMutexWaitThreshold(loggerMutexWaitThreshold);
 
 }
 
@@ -67,14 +67,41 @@ public:
     const std::string& getLogFile() const;
     LogLevel getLogLevel() const;
     LogTo getLogTo() const;
+    unsigned long getMaxLogFileSize() const;
+    unsigned int getLogFileRotations() const;
+    unsigned int getMetricsLogInterval() const;
+    unsigned int getTraceBufferSize() const;
+    const std::string& getTraceFile() const;
+    unsigned int getFlightRecorderSize() const;
+    const std::string& getFlightRecorderFile() const;
+    unsigned int getStallThreshold() const;
+    unsigned int getMutexWaitThreshold() const;
     void setLogFile(const std::string& logFile);
     void setLogLevel(const std::string& logLevel);
     void setLogTo(LogTo logTo);
+    void setMaxLogFileSize(const std::string& maxLogFileSize);
+    void setLogFileRotations(const std::string& logFileRotations);
+    void setMetricsLogInterval(const std::string& metricsLogInterval);
+    void setTraceBufferSize(const std::string& traceBufferSize);
+    void setTraceFile(const std::string& traceFile);
+    void setFlightRecorderSize(const std::string& flightRecorderSize);
+    void setFlightRecorderFile(const std::string& flightRecorderFile);
+    void setStallThreshold(const std::string& stallThreshold);
+    void setMutexWaitThreshold(const std::string& mutexWaitThreshold);
 
 private:
     LogLevel logLevel_;
     std::string logFile_;
     LogTo logTo_;
+    unsigned long maxLogFileSize_;
+    unsigned int logFileRotations_;
+    unsigned int metricsLogInterval_;
+    unsigned int traceBufferSize_;
+    std::string traceFile_;
+    unsigned int flightRecorderSize_;
+    std::string flightRecorderFile_;
+    unsigned int stallThreshold_;
+    unsigned int mutexWaitThreshold_;
 };
 
 
@@ -121,16 +148,43 @@ private:
     std::string password_;
     std::string cacheLocation_;
     std::string settingsLocation_;
+    unsigned long metadataCacheSize_;
+    unsigned long imageCacheSize_;
+    std::string imageCacheLocation_;
+    unsigned long imageCacheDiskSize_;
+    std::string librarySnapshotFile_;
+    unsigned int responseWorkers_;
+    unsigned int readaheadTracks_;
+    unsigned int readaheadConcurrency_;
+    unsigned long suggestionTrieSize_;
 public:
     SpotifyConfig();
     const std::string& getCacheLocation() const;
     const std::string& getPassword() const;
     const std::string& getSettingsLocation() const;
     const std::string& getUsername() const;
+    unsigned long getMetadataCacheSize() const;
+    unsigned long getImageCacheSize() const;
+    const std::string& getImageCacheLocation() const;
+    unsigned long getImageCacheDiskSize() const;
+    const std::string& getLibrarySnapshotFile() const;
+    unsigned int getResponseWorkers() const;
+    unsigned int getReadaheadTracks() const;
+    unsigned int getReadaheadConcurrency() const;
+    unsigned long getSuggestionTrieSize() const;
     void setCacheLocation(std::string& cacheLocation);
     void setPassword(std::string& password);
     void setSettingsLocation(std::string& settingsLocation);
     void setUsername(std::string& username);
+    void setMetadataCacheSize(std::string& metadataCacheSize);
+    void setImageCacheSize(std::string& imageCacheSize);
+    void setImageCacheLocation(std::string& imageCacheLocation);
+    void setImageCacheDiskSize(std::string& imageCacheDiskSize);
+    void setLibrarySnapshotFile(std::string& librarySnapshotFile);
+    void setResponseWorkers(std::string& responseWorkers);
+    void setReadaheadTracks(std::string& readaheadTracks);
+    void setReadaheadConcurrency(std::string& readaheadConcurrency);
+    void setSuggestionTrieSize(std::string& suggestionTrieSize);
 };
 
 class ConfigHandler
@@ -34,7 +34,16 @@ namespace ConfigHandling
 
 LoggerConfig::LoggerConfig() : logLevel_(LOG_DEBUG),
                                logFile_("./output.log"),
-                               logTo_(FILE)
+                               logTo_(FILE),
+                               maxLogFileSize_(10*1024*1024),
+                               logFileRotations_(3),
+                               metricsLogInterval_(300),
+                               traceBufferSize_(4096),
+                               traceFile_("./trace.json"),
+                               flightRecorderSize_(8192),
+                               flightRecorderFile_("./flightrecorder.log"),
+                               stallThreshold_(2000),
+                               mutexWaitThreshold_(1000)
 { }
 
 const std::string& LoggerConfig::getLogFile() const
@@ -52,6 +61,51 @@ LoggerConfig::LogTo LoggerConfig::getLogTo() const
     return logTo_;
 }
 
+unsigned long LoggerConfig::getMaxLogFileSize() const
+{
+    return maxLogFileSize_;
+}
+
+unsigned int LoggerConfig::getLogFileRotations() const
+{
+    return logFileRotations_;
+}
+
+unsigned int LoggerConfig::getMetricsLogInterval() const
+{
+    return metricsLogInterval_;
+}
+
+unsigned int LoggerConfig::getTraceBufferSize() const
+{
+    return traceBufferSize_;
+}
+
+const std::string& LoggerConfig::getTraceFile() const
+{
+    return traceFile_;
+}
+
+unsigned int LoggerConfig::getFlightRecorderSize() const
+{
+    return flightRecorderSize_;
+}
+
+const std::string& LoggerConfig::getFlightRecorderFile() const
+{
+    return flightRecorderFile_;
+}
+
+unsigned int LoggerConfig::getStallThreshold() const
+{
+    return stallThreshold_;
+}
+
+unsigned int LoggerConfig::getMutexWaitThreshold() const
+{
+    return mutexWaitThreshold_;
+}
+
 void LoggerConfig::setLogFile(const std::string& logFile)
 {
     if(!logFile.empty())logFile_ = logFile;
@@ -78,4 +132,49 @@ void LoggerConfig::setLogTo(LogTo logTo)
     logTo_ = logTo;
 }
 
+void LoggerConfig::setMaxLogFileSize(const std::string& maxLogFileSize)
+{
+    if(!maxLogFileSize.empty())maxLogFileSize_ = strtoul(maxLogFileSize.c_str(), NULL, 10);
+}
+
+void LoggerConfig::setLogFileRotations(const std::string& logFileRotations)
+{
+    if(!logFileRotations.empty())logFileRotations_ = strtoul(logFileRotations.c_str(), NULL, 10);
+}
+
+void LoggerConfig::setMetricsLogInterval(const std::string& metricsLogInterval)
+{
+    if(!metricsLogInterval.empty())metricsLogInterval_ = strtoul(metricsLogInterval.c_str(), NULL, 10);
+}
+
+void LoggerConfig::setTraceBufferSize(const std::string& traceBufferSize)
+{
+    if(!traceBufferSize.empty())traceBufferSize_ = strtoul(traceBufferSize.c_str(), NULL, 10);
+}
+
+void LoggerConfig::setTraceFile(const std::string& traceFile)
+{
+    if(!traceFile.empty())traceFile_ = traceFile;
+}
+
+void LoggerConfig::setFlightRecorderSize(const std::string& flightRecorderSize)
+{
+    if(!flightRecorderSize.empty())flightRecorderSize_ = strtoul(flightRecorderSize.c_str(), NULL, 10);
+}
+
+void LoggerConfig::setFlightRecorderFile(const std::string& flightRecorderFile)
+{
+    if(!flightRecorderFile.empty())flightRecorderFile_ = flightRecorderFile;
+}
+
+void LoggerConfig::setStallThreshold(const std::string& stallThreshold)
+{
+    if(!stallThreshold.empty())stallThreshold_ = strtoul(stallThreshold.c_str(), NULL, 10);
+}
+
+void LoggerConfig::setMutexWaitThreshold(const std::string& mutexWaitThreshold)
+{
+    if(!mutexWaitThreshold.empty())mutexWaitThreshold_ = strtoul(mutexWaitThreshold.c_str(), NULL, 10);
+}
+
 } /* namespace ConfigHandling */
@@ -26,6 +26,7 @@
  */
 
 #include "../ConfigHandler.h"
+#include <stdlib.h>
 
 namespace ConfigHandling
 {
@@ -33,7 +34,16 @@ namespace ConfigHandling
 SpotifyConfig::SpotifyConfig() : username_(""),
                                  password_(""),
                                  cacheLocation_("./tmp/"),
-                                 settingsLocation_("./tmp/")
+                                 settingsLocation_("./tmp/"),
+                                 metadataCacheSize_(4*1024*1024),
+                                 imageCacheSize_(4*1024*1024),
+                                 imageCacheLocation_("./tmp/images/"),
+                                 imageCacheDiskSize_(64*1024*1024),
+                                 librarySnapshotFile_("./tmp/library.snapshot"),
+                                 responseWorkers_(2),
+                                 readaheadTracks_(3),
+                                 readaheadConcurrency_(2),
+                                 suggestionTrieSize_(16*1024*1024)
 { }
 
 const std::string& SpotifyConfig::getCacheLocation() const
@@ -56,6 +66,51 @@ const std::string& SpotifyConfig::getUsername() const
     return username_;
 }
 
+unsigned long SpotifyConfig::getMetadataCacheSize() const
+{
+    return metadataCacheSize_;
+}
+
+unsigned long SpotifyConfig::getImageCacheSize() const
+{
+    return imageCacheSize_;
+}
+
+const std::string& SpotifyConfig::getImageCacheLocation() const
+{
+    return imageCacheLocation_;
+}
+
+unsigned long SpotifyConfig::getImageCacheDiskSize() const
+{
+    return imageCacheDiskSize_;
+}
+
+const std::string& SpotifyConfig::getLibrarySnapshotFile() const
+{
+    return librarySnapshotFile_;
+}
+
+unsigned int SpotifyConfig::getResponseWorkers() const
+{
+    return responseWorkers_;
+}
+
+unsigned int SpotifyConfig::getReadaheadTracks() const
+{
+    return readaheadTracks_;
+}
+
+unsigned int SpotifyConfig::getReadaheadConcurrency() const
+{
+    return readaheadConcurrency_;
+}
+
+unsigned long SpotifyConfig::getSuggestionTrieSize() const
+{
+    return suggestionTrieSize_;
+}
+
 void SpotifyConfig::setCacheLocation(std::string& cacheLocation)
 {
     if(!cacheLocation.empty())cacheLocation_ = cacheLocation;
@@ -75,4 +130,49 @@ void SpotifyConfig::setUsername(std::string& username)
 {
     if(!username.empty())username_ = username;
 }
+
+void SpotifyConfig::setMetadataCacheSize(std::string& metadataCacheSize)
+{
+    if(!metadataCacheSize.empty())metadataCacheSize_ = strtoul(metadataCacheSize.c_str(), NULL, 10);
+}
+
+void SpotifyConfig::setImageCacheSize(std::string& imageCacheSize)
+{
+    if(!imageCacheSize.empty())imageCacheSize_ = strtoul(imageCacheSize.c_str(), NULL, 10);
+}
+
+void SpotifyConfig::setImageCacheLocation(std::string& imageCacheLocation)
+{
+    if(!imageCacheLocation.empty())imageCacheLocation_ = imageCacheLocation;
+}
+
+void SpotifyConfig::setImageCacheDiskSize(std::string& imageCacheDiskSize)
+{
+    if(!imageCacheDiskSize.empty())imageCacheDiskSize_ = strtoul(imageCacheDiskSize.c_str(), NULL, 10);
+}
+
+void SpotifyConfig::setLibrarySnapshotFile(std::string& librarySnapshotFile)
+{
+    if(!librarySnapshotFile.empty())librarySnapshotFile_ = librarySnapshotFile;
+}
+
+void SpotifyConfig::setResponseWorkers(std::string& responseWorkers)
+{
+    if(!responseWorkers.empty())responseWorkers_ = strtoul(responseWorkers.c_str(), NULL, 10);
+}
+
+void SpotifyConfig::setReadaheadTracks(std::string& readaheadTracks)
+{
+    if(!readaheadTracks.empty())readaheadTracks_ = strtoul(readaheadTracks.c_str(), NULL, 10);
+}
+
+void SpotifyConfig::setReadaheadConcurrency(std::string& readaheadConcurrency)
+{
+    if(!readaheadConcurrency.empty())readaheadConcurrency_ = strtoul(readaheadConcurrency.c_str(), NULL, 10);
+}
+
+void SpotifyConfig::setSuggestionTrieSize(std::string& suggestionTrieSize)
+{
+    if(!suggestionTrieSize.empty())suggestionTrieSize_ = strtoul(suggestionTrieSize.c_str(), NULL, 10);
+}
 } /* namespace ConfigHandling */
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ImageCache.h"
+#include "applog.h"
+#include <fstream>
+#include <map>
+#include <list>
+#include <stdio.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <utime.h>
+
+namespace LibSpotify
+{
+
+static const std::string fileSuffix(".jpg");
+
+ImageCache::ImageCache(size_t memoryBytes, const std::string& directory, size_t diskBytes) :
+                                         memory_(memoryBytes),
+                                         disk_(diskBytes),
+                                         directory_(directory),
+                                         hits_(Metrics::Registry::instance().getCounter("cache.image.hits")),
+                                         diskHits_(Metrics::Registry::instance().getCounter("cache.image.disk.hits")),
+                                         misses_(Metrics::Registry::instance().getCounter("cache.image.misses")),
+                                         evictions_(Metrics::Registry::instance().getCounter("cache.image.evictions")),
+                                         diskEvictions_(Metrics::Registry::instance().getCounter("cache.image.disk.evictions")),
+                                         bytes_(Metrics::Registry::instance().getGauge("cache.image.bytes")),
+                                         diskBytes_(Metrics::Registry::instance().getGauge("cache.image.disk.bytes"))
+{
+    if(!directory_.empty())
+    {
+        if(directory_[directory_.size()-1] != '/')directory_ += '/';
+        for(size_t pos = directory_.find('/', 1); pos != std::string::npos; pos = directory_.find('/', pos + 1))
+            mkdir(directory_.substr(0, pos).c_str(), 0755);
+        loadIndex();
+    }
+}
+
+ImageCache::~ImageCache() { }
+
+/* links only contain [a-zA-Z0-9:], so this is unique and keeps the files recognizable */
+std::string ImageCache::fileName(const std::string& key)
+{
+    std::string name(key);
+    for(std::string::iterator it = name.begin(); it != name.end(); it++)
+    {
+        if(!isalnum(static_cast<unsigned char>(*it)))*it = '_';
+    }
+    return name + fileSuffix;
+}
+
+std::string ImageCache::path(const std::string& file) const
+{
+    return directory_ + file;
+}
+
+/* rebuilds the disk LRU from what a previous run left behind, oldest mtime being least recently used */
+void ImageCache::loadIndex()
+{
+    DIR* dir = opendir(directory_.c_str());
+    if(!dir)
+    {
+        log(LOG_WARN) << "Could not open image cache directory " << directory_;
+        directory_.clear();
+        return;
+    }
+
+    std::multimap<time_t, std::pair<std::string, size_t> > files;
+    struct dirent* entry;
+    while((entry = readdir(dir)) != NULL)
+    {
+        std::string name(entry->d_name);
+        struct stat st;
+        if(name.size() <= fileSuffix.size() ||
+           name.compare(name.size() - fileSuffix.size(), fileSuffix.size(), fileSuffix) != 0 ||
+           stat(path(name).c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+        files.insert(std::make_pair(st.st_mtime, std::make_pair(name, static_cast<size_t>(st.st_size))));
+    }
+    closedir(dir);
+
+    for(std::multimap<time_t, std::pair<std::string, size_t> >::const_iterator it = files.begin(); it != files.end(); it++)
+    {
+        std::list<std::string> evicted;
+        diskEvictions_.add(disk_.insert(it->second.first, it->second.second, it->second.second, &evicted));
+        for(std::list<std::string>::const_iterator ev = evicted.begin(); ev != evicted.end(); ev++)
+            unlink(path(*ev).c_str());
+    }
+    diskBytes_.set(disk_.cost());
+
+    log(LOG_NOTICE) << "Image cache: " << disk_.size() << " images, " << disk_.cost() << " bytes in " << directory_;
+}
+
+bool ImageCache::readFile(const std::string& file, std::string& data) const
+{
+    std::ifstream in(path(file).c_str(), std::ios::in | std::ios::binary);
+    if(!in)return false;
+
+    in.seekg(0, std::ios::end);
+    data.resize(in.tellg());
+    in.seekg(0, std::ios::beg);
+    if(!data.empty())in.read(&data[0], data.size());
+    return !in.fail();
+}
+
+/* written to a temporary first, so that a crash never leaves a truncated image behind */
+void ImageCache::writeFile(const std::string& file, const std::string& data)
+{
+    std::string target = path(file);
+    std::string tmp = target + ".tmp";
+    {
+        std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if(!out)
+        {
+            log(LOG_WARN) << "Could not write " << tmp;
+            out.close();
+            unlink(tmp.c_str());
+            return;
+        }
+    }
+    if(rename(tmp.c_str(), target.c_str()) != 0)
+    {
+        log(LOG_WARN) << "Could not rename " << tmp;
+        unlink(tmp.c_str());
+        return;
+    }
+
+    std::list<std::string> evicted;
+    diskEvictions_.add(disk_.insert(file, data.size(), data.size(), &evicted));
+    for(std::list<std::string>::const_iterator it = evicted.begin(); it != evicted.end(); it++)
+        unlink(path(*it).c_str());
+    if(!disk_.find(file))unlink(target.c_str()); /* bigger than the whole disk budget */
+    diskBytes_.set(disk_.cost());
+}
+
+bool ImageCache::get(const std::string& key, const std::string*& data, std::string& file)
+{
+    data = memory_.find(key);
+    if(data)
+    {
+        hits_.increment();
+        return true;
+    }
+
+    if(!directory_.empty())
+    {
+        std::string name = fileName(key);
+        const size_t* size = disk_.find(name);
+        if(size && *size >= fileSendMinSize)
+        {
+            utime(path(name).c_str(), NULL);
+            diskHits_.increment();
+            file = path(name);
+            return true;
+        }
+        else if(size)
+        {
+            if(readFile(name, lastRead_))
+            {
+                utime(path(name).c_str(), NULL);
+                diskHits_.increment();
+                evictions_.add(memory_.insert(key, lastRead_, lastRead_.size()));
+                bytes_.set(memory_.cost());
+                data = memory_.find(key);
+                if(!data)data = &lastRead_;
+                return true;
+            }
+
+            log(LOG_WARN) << "Dropping unreadable " << path(name);
+            disk_.erase(name);
+            unlink(path(name).c_str());
+            diskBytes_.set(disk_.cost());
+        }
+    }
+
+    misses_.increment();
+    return false;
+}
+
+void ImageCache::put(const std::string& key, const void* data, size_t dataSize)
+{
+    if(key.empty() || data == NULL || dataSize == 0)
+        return;
+
+    std::string image(static_cast<const char*>(data), dataSize);
+    if(directory_.empty() || dataSize < fileSendMinSize)
+    {
+        evictions_.add(memory_.insert(key, image, dataSize));
+        bytes_.set(memory_.cost());
+    }
+
+    if(!directory_.empty())
+        writeFile(fileName(key), image);
+}
+
+bool ImageCache::contains(const std::string& key)
+{
+    if(memory_.find(key))
+        return true;
+
+    if(directory_.empty())
+        return false;
+
+    const size_t* size = disk_.find(fileName(key));
+    return size && *size >= fileSendMinSize;
+}
+
+} /* namespace LibSpotify */
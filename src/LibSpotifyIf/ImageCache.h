@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef IMAGECACHE_H_
+#define IMAGECACHE_H_
+
+#include "Metrics/Metrics.h"
+#include "LruCache.h"
+#include <string>
+
+namespace LibSpotify
+{
+
+/* Cover art keyed by the link it was requested for.
+ * Recently used images are kept in memory, every image is also written to a
+ * directory so that the cache survives restarts. Both tiers are LRUs bounded
+ * by total bytes, the disk tier uses file mtime to remember the order.
+ * Large images are not kept in memory, they are sent to clients straight from their file.
+ * Only used from the libspotify thread, so no locking. */
+class ImageCache
+{
+private:
+    Util::LruCache<std::string, std::string> memory_;
+    Util::LruCache<std::string, size_t> disk_; /* file name -> size */
+    std::string directory_;
+    std::string lastRead_;
+
+    Metrics::Counter& hits_;
+    Metrics::Counter& diskHits_;
+    Metrics::Counter& misses_;
+    Metrics::Counter& evictions_;
+    Metrics::Counter& diskEvictions_;
+    Metrics::Gauge& bytes_;
+    Metrics::Gauge& diskBytes_;
+
+    static std::string fileName(const std::string& key);
+    std::string path(const std::string& file) const;
+    void loadIndex();
+    bool readFile(const std::string& file, std::string& data) const;
+    void writeFile(const std::string& file, const std::string& data);
+
+public:
+    /* an empty directory disables the disk tier */
+    ImageCache(size_t memoryBytes, const std::string& directory, size_t diskBytes);
+    ~ImageCache();
+
+    /* images at least this big are sent from their file rather than kept in memory */
+    static const size_t fileSendMinSize = 16*1024;
+
+    /* false on miss. On a hit either data points to the image, valid until the next call
+     * into the cache, or data is NULL and file is the path of the image */
+    bool get(const std::string& key, const std::string*& data, std::string& file);
+    void put(const std::string& key, const void* data, size_t dataSize);
+    /* true if get() would hit without reading the disk. Not counted as a hit or miss */
+    bool contains(const std::string& key);
+};
+
+} /* namespace LibSpotify */
+#endif /* IMAGECACHE_H_ */
@@ -30,18 +30,62 @@
 #include "LibSpotifyIfHelpers.h"
 #include "applog.h"
 #include "MediaContainers/Artist.h"
+#include "MediaContainers/ContentVersion.h"
+#include "Platform/Utils/Utils.h"
+#include "Tracing/FlightRecorder.h"
 
 #include <iostream>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include <time.h>
+#include <algorithm>
 
 
 namespace LibSpotify {
 
 
 static const char* getEventName(LibSpotifyIf::EventItem* event);
+static const LibSpotifyIf::ReqEventItem* getReqEvent(LibSpotifyIf::EventItem* event);
+
+/* how long a request may wait for libspotify to load what it asks for */
+static const uint64_t metadataTimeout_us = 30 * 1000000ULL;
+
+/* how often a changed root folder is written to the library snapshot */
+static const uint64_t librarySnapshotInterval_us = 30 * 1000000ULL;
+
+/* spotify search results are passed on in parts of this many tracks */
+static const size_t searchPartTracks = 25;
+
+/* next playlist and subfolder of a folder while walking the root folder */
+class FolderPosition
+{
+public:
+    Folder* folder_;
+    size_t nextPlaylist_;
+    size_t nextFolder_;
+    FolderPosition(Folder* folder) : folder_(folder), nextPlaylist_(0), nextFolder_(0) {}
+};
+
+/* copy of a request that waits for libspotify (callback userdata or pending metadata),
+ * stamped so the wait shows up in the request trace once it is over */
+template <class T> static T* newWaitingReq(const T& req)
+{
+    T* item = new T(req);
+    item->postTime_ = getMonotonicTime_us();
+    return item;
+}
+
+/* the wall clock tells runs apart across reboots, the monotonic clock restarts in quick succession */
+static unsigned int newLibraryEpoch()
+{
+    ContentVersion epoch;
+    uint64_t now_us = getMonotonicTime_us();
+    epoch.add(static_cast<uint32_t>(time(NULL)));
+    epoch.add(static_cast<uint32_t>(now_us));
+    epoch.add(static_cast<uint32_t>(now_us >> 32));
+    return epoch.get();
+}
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -55,29 +99,111 @@ LibSpotifyIf::LibSpotifyIf(const ConfigHandling::SpotifyConfig& config, Platform
 																		 defaultEndpoint_(endpoint),
 																		 currentEndpoint_(&defaultEndpoint_),
 																		 rootFolder_("root", 0, 0),
+																		 rootFolderLayoutChanged_(false),
+																		 rootFolderVersion_(0),
+																		 rootFolderSnapshot_(new Folder("root", 0, 0)),
+																		 librarySnapshot_(config.getLibrarySnapshotFile()),
+																		 warmStart_(false),
+																		 librarySnapshotDirty_(false),
+																		 librarySnapshotSaved_(0),
+																		 libraryEpoch_(newLibraryEpoch()),
 																		 state_(STATE_INVALID),
 																		 nextTimeoutForLibSpotify(0),
+																		 iteratePending_(false),
+																		 iteratePostTime_(0),
+																		 iterateEvent_(EVENT_ITERATE_MAIN_LOOP),
+																		 eventQueueDepth_(Metrics::Registry::instance().getGauge("libspotify.queue_depth")),
 																		 playbackHandler_(*this),
+																		 prefetches_(Metrics::Registry::instance().getCounter("libspotify.prefetches")),
+																		 readaheadTracks_(config.getReadaheadTracks()),
+																		 readaheadConcurrency_(config.getReadaheadConcurrency()),
+																		 readaheadGeneration_(0),
+																		 readaheadInFlight_(0),
+																		 readaheads_(Metrics::Registry::instance().getCounter("libspotify.readaheads")),
+																		 metadataWaits_(Metrics::Registry::instance().getCounter("libspotify.metadata_waits")),
+																		 metadataTimeouts_(Metrics::Registry::instance().getCounter("libspotify.metadata_timeouts")),
+																		 metadataCache_(config.getMetadataCacheSize()),
+																		 imageCache_(config.getImageCacheSize(), config.getImageCacheLocation(), config.getImageCacheDiskSize()),
+																		 localSearches_(Metrics::Registry::instance().getCounter("libspotify.local_searches")),
+																		 localSearchTime_(Metrics::Registry::instance().getHistogram("libspotify.local_search_us")),
+																		 suggestTime_(Metrics::Registry::instance().getHistogram("libspotify.suggest_us")),
+																		 suggestionTrieBytes_(Metrics::Registry::instance().getGauge("libspotify.suggestion_trie_bytes")),
+																		 suggestionTrieBuilder_(*this),
+																		 coalescedRequests_(Metrics::Registry::instance().getCounter("libspotify.coalesced_requests")),
+																		 responseWorkers_(config.getResponseWorkers()),
+																		 responseDeliverTime_(Metrics::Registry::instance().getHistogram("libspotify.responses.deliver_us")),
 																		 itsCallbackWrapper_(*this),
 																		 trackState_(TRACK_STATE_NOT_LOADED),
 																		 currentTrack_("","")
 {
+    for ( int i = 0; i <= EVENT_ITERATE_MAIN_LOOP; i++ )
+    {
+        EventItem event( static_cast<Event>( i ) );
+        std::string name( std::string( "libspotify." ) + getEventName( &event ) );
+        eventWaitTime_[i] = &Metrics::Registry::instance().getHistogram( name + ".wait_us" );
+        eventExecTime_[i] = &Metrics::Registry::instance().getHistogram( name + ".exec_us" );
+    }
+
+	Folder lastRootFolder("root", 0, 0);
+	if (librarySnapshot_.load(lastRootFolder, rootFolderVersion_))
+	{
+	    rootFolderSnapshot_.reset(new Folder(lastRootFolder));
+	    searchIndex_.addFolder(lastRootFolder);
+	    rebuildSuggestionTrie(rootFolderSnapshot_);
+	    warmStart_ = true;
+	}
+
 	libSpotifySessionCreate();
 	startThread();
 }
 
 LibSpotifyIf::~LibSpotifyIf()
 {
-	/*
-	sp_playlistcontainer_remove_callbacks(sp_session_playlistcontainer(spotifySession_),
-										  itsCallbackWrapper_.getRegisteredPlaylistContainerCallbacks(),
-										  NULL);*/
+	suggestionTrieBuilder_.destroy();
+	if (librarySnapshotDirty_)
+		saveLibrarySnapshot();
+	librarySnapshot_.destroy();
+	clearWaiters();
+	unwatchPlaylists();
+	clearInFlight();
+	for (int prio = 0; prio < NUM_EVENT_PRIORITIES; prio++)
+	{
+		while (!eventQueue_[prio].empty())
+			delete eventQueue_[prio].pop();
+	}
+	if (state_ == STATE_LOGGED_IN)
+		sp_playlistcontainer_remove_callbacks(sp_session_playlistcontainer(spotifySession_),
+											  itsCallbackWrapper_.getRegisteredPlaylistContainerCallbacks(),
+											  NULL);
 	sp_session_release(spotifySession_);
 }
 void LibSpotifyIf::destroy()
 {
 	cancelThread();
 	joinThread();
+	responseWorkers_.destroy();
+}
+
+void LibSpotifyIf::unRegisterForCallbacks(IMediaInterfaceCallbackSubscriber& subscriber)
+{
+    MediaInterface::unRegisterForCallbacks(subscriber);
+    /* nothing new gets posted for it now, see deliverResponse(), get rid of what already was */
+    responseWorkers_.forget(&subscriber);
+}
+
+void LibSpotifyIf::deliverResponse(ResponseJob* job)
+{
+    uint64_t startTime = getMonotonicTime_us();
+
+    /* an unregistering subscriber waits for this to be released, so it can't slip in between */
+    CallbackSubscribers subscribers = getCallbackSubscribers();
+    if (subscribers->count(job->subscriber_) > 0)
+        responseWorkers_.post(job);
+    else
+        delete job;
+
+    /* how long the libspotify thread is held up by each response */
+    responseDeliverTime_.record(getMonotonicTime_us() - startTime);
 }
 
 void LibSpotifyIf::logIn()
@@ -90,9 +216,28 @@ void LibSpotifyIf::logOut()
     postToEventThread( new EventItem( EVENT_LOGGING_OUT ) );
 }
 
+const Tracing::Heartbeat& LibSpotifyIf::getHeartbeat() const
+{
+    return heartbeat_;
+}
+
+unsigned int LibSpotifyIf::getRootFolderVersion() const
+{
+    return rootFolderVersion_;
+}
+
+Platform::SharedPtr<const Folder> LibSpotifyIf::getRootFolder()
+{
+    rootFolderSnapshotMtx_.lock();
+    Platform::SharedPtr<const Folder> snapshot(rootFolderSnapshot_);
+    rootFolderSnapshotMtx_.unlock();
+    return snapshot;
+}
+
 void LibSpotifyIf::getPlaylists( IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId )
 {
-    subscriber->getPlaylistsResponse( reqId, rootFolder_ );
+    Platform::SharedPtr<const Folder> snapshot = getRootFolder();
+    subscriber->getPlaylistsResponse( reqId, *snapshot );
 }
 
 void LibSpotifyIf::getTracks( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId )
@@ -102,7 +247,17 @@ void LibSpotifyIf::getTracks( std::string link, IMediaInterfaceCallbackSubscribe
 
 void LibSpotifyIf::search( std::string query, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId )
 {
-    postToEventThread( new QueryReqEventItem( EVENT_GENERIC_SEARCH, reqId, subscriber, query ) );
+    postToEventThread( new SearchReqEventItem( reqId, subscriber, query ) );
+}
+
+void LibSpotifyIf::suggest( std::string prefix, unsigned int maxSuggestions, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId )
+{
+    postToEventThread( new SuggestReqEventItem( reqId, subscriber, prefix, maxSuggestions ) );
+}
+
+void LibSpotifyIf::subscribeLibrary( unsigned int epoch, unsigned int version, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId )
+{
+    postToEventThread( new LibrarySubscribeReqEventItem( reqId, subscriber, epoch, version ) );
 }
 
 void LibSpotifyIf::getImage( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId )
@@ -152,6 +307,11 @@ void LibSpotifyIf::playTrack(const Track& track)
     postToEventThread( new TrackEventItem(EVENT_PLAY_TRACK, track) );
 }
 
+void LibSpotifyIf::playQueueChangedInd()
+{
+    postToEventThread( new EventItem(EVENT_READAHEAD) );
+}
+
 /* * * * * * * * * * * * * * * * * * * * * * * * * * *
  * * * * * * * * * * * * * * * * * * * * * * * * * * *
  *
@@ -225,27 +385,58 @@ void LibSpotifyIf::run()
         eventQueueMtx_.lock();
         if (nextTimeoutForLibSpotify == 0)
         {
-            while(eventQueue_.empty())cond_.wait(eventQueueMtx_);
+            while(queuedEvents() == 0 && !iteratePending_)cond_.wait(eventQueueMtx_);
         }
-        else if(eventQueue_.empty())
+        else if(queuedEvents() == 0 && !iteratePending_)
         {
             cond_.timedWait(eventQueueMtx_, nextTimeoutForLibSpotify);
         }
 
-        EventItem* currentEvent;
+        EventItem* currentEvent = NULL;
+        uint64_t dispatchTime = getMonotonicTime_us();
+        for (int prio = 0; currentEvent == NULL && prio < NUM_EVENT_PRIORITIES; prio++)
+        {
+            if (!eventQueue_[prio].empty())
+                currentEvent = eventQueue_[prio].pop();
+        }
+        bool timerDriven = (currentEvent == NULL && !iteratePending_);
 
-        if(eventQueue_.empty())
+        if(currentEvent == NULL)
         {
-            currentEvent = new EventItem( EVENT_ITERATE_MAIN_LOOP );
+            currentEvent = &iterateEvent_;
+            if (iteratePending_)
+            {
+                eventWaitTime_[EVENT_ITERATE_MAIN_LOOP]->record( dispatchTime - iteratePostTime_ );
+                Tracing::FlightRecorder::instance().record( Tracing::FR_DISPATCH, EVENT_ITERATE_MAIN_LOOP, 0 );
+            }
         }
         else
         {
-            currentEvent = eventQueue_.front();
-            eventQueue_.pop();
+            eventWaitTime_[currentEvent->event_]->record( dispatchTime - currentEvent->postTime_ );
+            Tracing::FlightRecorder::instance().record( Tracing::FR_DISPATCH, currentEvent->event_, queuedEvents() );
         }
+        /* every event ends with iterating libspotify, so this one covers any notification */
+        iteratePending_ = false;
+        eventQueueDepth_.set( queuedEvents() );
         eventQueueMtx_.unlock();
+
+        const ReqEventItem* reqEvent = getReqEvent( currentEvent );
+        if ( reqEvent )
+            reqEvent->trace( "queue", currentEvent->postTime_, dispatchTime );
+
+        heartbeat_.enter();
         stateMachineEventHandler(currentEvent);
-        delete currentEvent;
+        heartbeat_.leave();
+
+        uint64_t doneTime = getMonotonicTime_us();
+        eventExecTime_[currentEvent->event_]->record( doneTime - dispatchTime );
+        /* libspotify timeouts can fire every few ms, only slow ones are worth a flight record */
+        if ( !timerDriven || doneTime - dispatchTime >= 1000 )
+            Tracing::FlightRecorder::instance().record( Tracing::FR_DISPATCH_DONE, currentEvent->event_, doneTime - dispatchTime );
+        if ( reqEvent )
+            reqEvent->trace( getEventName( currentEvent ), dispatchTime, doneTime );
+        if ( currentEvent != &iterateEvent_ )
+            delete currentEvent;
     }
     log(LOG_DEBUG) << "Exiting LibSpotifyIf::run()";
 }
@@ -257,23 +448,40 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 	switch(event->event_)
 	{
 		case EVENT_METADATA_UPDATED:
-			updateRootFolder(sp_session_playlistcontainer(spotifySession_));
-
-            while(!pendingMetadata.empty())
-            {
-                EventItem* item = pendingMetadata.front();
-                postToEventThread(item);
-                pendingMetadata.pop();
-            }
-
+		    wakeTrackWaiters();
 			break;
 
+		case EVENT_SUGGESTION_TRIE_BUILT:
+		    swapInSuggestionTrie();
+		    break;
+
 		case EVENT_GET_TRACKS:
 		{
 		    QueryReqEventItem* reqEvent = static_cast<QueryReqEventItem*>( event );
 
 			const char* playlist_uri = reqEvent->query_.c_str();
-		    if (state_ == STATE_LOGGED_IN)
+		    const Playlist* cached = NULL;
+		    Playlist warmPlaylist("", "");
+		    if (joinInFlight(reqEvent))
+		    {
+		        /* answered along with the identical request ahead of it */
+		    }
+		    else if ((cached = metadataCache_.getPlaylist(reqEvent->query_)) != NULL)
+		    {
+		        InFlightReqs reqs = takeInFlight(reqEvent);
+		        for (InFlightReqs::iterator it = reqs.begin(); it != reqs.end(); it++)
+		            deliverResponse(new TracksResponseJob((*it)->callbackSubscriber_, (*it)->reqId_, *cached));
+		        releaseInFlight(reqs);
+		    }
+		    else if (warmStart_ && rootFolderSnapshot_->findPlaylist(reqEvent->query_, warmPlaylist))
+		    {
+		        /* still serving last run's root folder, answer from it as well */
+		        InFlightReqs reqs = takeInFlight(reqEvent);
+		        for (InFlightReqs::iterator it = reqs.begin(); it != reqs.end(); it++)
+		            deliverResponse(new TracksResponseJob((*it)->callbackSubscriber_, (*it)->reqId_, warmPlaylist));
+		        releaseInFlight(reqs);
+		    }
+		    else if (state_ == STATE_LOGGED_IN)
 			{
 				sp_link* link = sp_link_create_from_string(playlist_uri);
 				if(link)
@@ -287,13 +495,25 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 							log(LOG_DEBUG) << "Got playlist " << playlist_uri;
 	                         Playlist playlistObj = spotifyGetPlaylist(playlist, spotifySession_);
 
-
-	                         reqEvent->callbackSubscriber_->getTracksResponse(reqEvent->reqId_, playlistObj.getTracks());
+	                         /* tracks still waiting for metadata would be cached without names */
+	                         bool tracksLoaded = true;
+	                         for (int i = 0; tracksLoaded && i < sp_playlist_num_tracks(playlist); i++)
+	                             tracksLoaded = sp_track_is_loaded(sp_playlist_track(playlist, i));
+	                         if (tracksLoaded)
+	                         {
+	                             metadataCache_.putPlaylist(playlistObj);
+	                             watchPlaylist(playlist);
+	                         }
+
+	                         InFlightReqs reqs = takeInFlight(reqEvent);
+	                         for (InFlightReqs::iterator it = reqs.begin(); it != reqs.end(); it++)
+	                             deliverResponse(new TracksResponseJob((*it)->callbackSubscriber_, (*it)->reqId_, playlistObj));
+	                         releaseInFlight(reqs);
 						}
 						else
 						{
-							/*not sure if we're waiting for metadata or playlist_state_changed here*/
-                            pendingMetadata.push(new QueryReqEventItem(*reqEvent) );
+                            leadInFlight(reqEvent);
+                            waitForPlaylist( playlist, newWaitingReq( *reqEvent ) );
 							log(LOG_DEBUG) << "Waiting for metadata for playlist " << playlist_uri;
 						}
 					}
@@ -311,7 +531,16 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
         {
             QueryReqEventItem* reqEvent = static_cast<QueryReqEventItem*>( event );
             const char* album_uri = reqEvent->query_.c_str();
-            if (state_ == STATE_LOGGED_IN)
+            const Album* cached = NULL;
+            if (joinInFlight(reqEvent))
+            {
+                /* answered along with the identical request ahead of it */
+            }
+            else if ((cached = metadataCache_.getAlbum(reqEvent->query_)) != NULL)
+            {
+                deliverResponse(new AlbumResponseJob(reqEvent->callbackSubscriber_, reqEvent->reqId_, *cached));
+            }
+            else if (state_ == STATE_LOGGED_IN)
             {
                 sp_link* link = sp_link_create_from_string(album_uri);
                 if (link)
@@ -319,7 +548,8 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
                     if (sp_link_type(link) == SP_LINKTYPE_ALBUM)
                     {
                         sp_album* album = sp_link_as_album(link);
-                        sp_albumbrowse_create( spotifySession_, album, &LibSpotifyIfCallbackWrapper::albumLoadedCallback, new QueryReqEventItem(*reqEvent));
+                        leadInFlight(reqEvent);
+                        sp_albumbrowse_create( spotifySession_, album, &LibSpotifyIfCallbackWrapper::albumLoadedCallback, newWaitingReq( *reqEvent ));
                     }
                     else
                     {
@@ -337,7 +567,24 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 
 		case EVENT_GENERIC_SEARCH:
 		{
-		    QueryReqEventItem* reqEvent = static_cast<QueryReqEventItem*>( event );
+		    SearchReqEventItem* reqEvent = static_cast<SearchReqEventItem*>( event );
+
+		    /* what the library has goes out right away, spotify's results follow in later parts */
+		    uint64_t searchStart = getMonotonicTime_us();
+		    Playlist localReply("", "");
+		    if (searchIndex_.search(reqEvent->query_, 100, localReply))
+		    {
+		        localSearchTime_.record(getMonotonicTime_us() - searchStart);
+		        localSearches_.increment();
+		        for (std::deque<Track>::const_iterator it = localReply.getTracks().begin(); it != localReply.getTracks().end(); it++)
+		            reqEvent->sentLinks_.insert(it->getLink());
+		        deliverResponse(new SearchPartResponseJob(reqEvent->callbackSubscriber_, reqEvent->reqId_, localReply.getTracks()));
+		    }
+
+		    if (joinInFlight(reqEvent))
+		        break;
+
+		    leadInFlight(reqEvent);
 			/* search, but only interested in the first 100 results,
 			 * 0, = track_offset
 			 * 100, = track_count
@@ -354,18 +601,65 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 							0,
 							100,
 							&LibSpotifyIfCallbackWrapper::genericSearchCallback,
-							new QueryReqEventItem(*reqEvent));
+							newWaitingReq( *reqEvent ));
 
 			break;
 		}
 
+		case EVENT_SEARCH_SUGGEST:
+		{
+		    /* answered from memory, so it's not queued behind metadata requests */
+		    SuggestReqEventItem* reqEvent = static_cast<SuggestReqEventItem*>( event );
+		    uint64_t suggestStart = getMonotonicTime_us();
+		    std::vector<Suggestion> suggestions;
+		    suggestionTrie_.suggest(reqEvent->query_, reqEvent->maxSuggestions_, suggestions);
+		    suggestTime_.record(getMonotonicTime_us() - suggestStart);
+		    deliverResponse(new SuggestResponseJob(reqEvent->callbackSubscriber_, reqEvent->reqId_, suggestions));
+		    break;
+		}
+
+		case EVENT_LIBRARY_SUBSCRIBE:
+		{
+		    /* answered here rather than right away, so no LIBRARY_CHANGED can come in between
+		     * the version it answers with and the subscriber hearing about it */
+		    LibrarySubscribeReqEventItem* reqEvent = static_cast<LibrarySubscribeReqEventItem*>( event );
+		    std::vector<LibraryChange> changes;
+		    Platform::SharedPtr<const Folder> resync;
+		    if (!getLibraryChanges(reqEvent->epoch_, reqEvent->version_, changes))
+		        resync = getRootFolder();
+		    deliverResponse(new LibrarySubscribeResponseJob(reqEvent->callbackSubscriber_, reqEvent->reqId_, libraryEpoch_, rootFolderVersion_, changes, resync));
+		    break;
+		}
+
 		case EVENT_GET_IMAGE:
 		{
             QueryReqEventItem* reqEvent = static_cast<QueryReqEventItem*>( event );
 
-            std::string linkStr = reqEvent->query_.empty() ? currentTrack_.getAlbumLink() : reqEvent->query_;
+            /* resolved here, so that a request waiting for libspotify sticks to the same album */
+            if (reqEvent->query_.empty())
+                reqEvent->query_ = currentTrack_.getAlbumLink();
+            const std::string& linkStr = reqEvent->query_;
+
+            const std::string* cached = NULL;
+            std::string cachedFile;
+            const void* data = NULL;
+            size_t dataSize = 0;
+            sp_image* img = NULL;
+            bool waiting = false;
 
-            if (!linkStr.empty())
+            if (joinInFlight(reqEvent))
+            {
+                waiting = true;
+            }
+            else if (!linkStr.empty() && imageCache_.get(linkStr, cached, cachedFile))
+            {
+                if (cached)
+                {
+                    data = cached->data();
+                    dataSize = cached->size();
+                }
+            }
+            else if (!linkStr.empty())
             {
                 sp_link* link = sp_link_create_from_string(linkStr.c_str());
                 if (link)
@@ -382,18 +676,16 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
                         else
                         {
                             log(LOG_WARN) << "No metadata for album";
-                            sp_albumbrowse_create( spotifySession_, album, &LibSpotifyIfCallbackWrapper::albumLoadedCallback, new QueryReqEventItem( *reqEvent ));
+                            leadInFlight(reqEvent);
+                            sp_albumbrowse_create( spotifySession_, album, &LibSpotifyIfCallbackWrapper::albumLoadedCallback, newWaitingReq( *reqEvent ));
+                            waiting = true;
                         }
                     }
-                    else
-                    {
-                        /*not supported yet*/
-                        reqEvent->callbackSubscriber_->getImageResponse(reqEvent->reqId_, NULL, 0);
-                    }
+                    /*other link types not supported yet*/
 
                     if (imgRef)
                     {
-                        sp_image* img = sp_image_create(spotifySession_, imgRef);
+                        img = sp_image_create(spotifySession_, imgRef);
                         if ( img )
                         {
                             sp_error error;
@@ -401,21 +693,20 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 
                             if ( sp_image_is_loaded(img) )
                             {
-                                size_t dataSize;
-                                const void* data = sp_image_data(img, &dataSize);
-                                reqEvent->callbackSubscriber_->getImageResponse(reqEvent->reqId_, data, dataSize);
-                                sp_image_release(img);
+                                data = sp_image_data(img, &dataSize);
+                                imageCache_.put(linkStr, data, dataSize);
                             }
                             else if ( error == SP_ERROR_IS_LOADING )
                             {
                                 log(LOG_DEBUG) << "waiting for image load";
-                                sp_image_add_load_callback(img, &LibSpotifyIfCallbackWrapper::imageLoadedCallback, new QueryReqEventItem(*reqEvent));
+                                leadInFlight(reqEvent);
+                                sp_image_add_load_callback(img, &LibSpotifyIfCallbackWrapper::imageLoadedCallback, newWaitingReq( *reqEvent ));
+                                img = NULL;
+                                waiting = true;
                             }
                             else
                             {
                                 log(LOG_WARN) << "Image load error: " << sp_error_message(error);
-                                reqEvent->callbackSubscriber_->getImageResponse(reqEvent->reqId_, NULL, 0);
-                                sp_image_release(img);
                             }
                         }
                     }
@@ -424,10 +715,26 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
                 else
                 {
                     log(LOG_WARN) << "Bad link?" << linkStr;
-                    reqEvent->callbackSubscriber_->getImageResponse(reqEvent->reqId_, NULL, 0);
                 }
+            }
 
+            if (!waiting && !linkStr.empty())
+            {
+                /* the data belongs to libspotify or the cache, the workers get their own copy */
+                Platform::SharedPtr<const std::string> image(data ? new std::string(static_cast<const char*>(data), dataSize) : new std::string());
+                InFlightReqs reqs = takeInFlight(reqEvent);
+                for (InFlightReqs::iterator it = reqs.begin(); it != reqs.end(); it++)
+                {
+                    if (!cachedFile.empty())
+                        deliverResponse(new ImageFileResponseJob((*it)->callbackSubscriber_, (*it)->reqId_, cachedFile));
+                    else
+                        deliverResponse(new ImageResponseJob((*it)->callbackSubscriber_, (*it)->reqId_, image));
+                }
+                releaseInFlight(reqs);
             }
+
+            if (img)
+                sp_image_release(img);
 		}
 		break;
 
@@ -443,27 +750,53 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 				    {
 				        case SP_LINKTYPE_TRACK:
                             {
-                                sp_track* track = sp_link_as_track(link);
-                                Track trackObj(spotifyGetTrack(track, spotifySession_));
-                                playbackHandler_.playTrack(trackObj);
+                                const Track* cached = metadataCache_.getTrack(reqEvent->query_);
+                                if (cached)
+                                {
+                                    playbackHandler_.playTrack(*cached);
+                                }
+                                else
+                                {
+                                    sp_track* track = sp_link_as_track(link);
+                                    Track trackObj(spotifyGetTrack(track, spotifySession_));
+                                    if (sp_track_is_loaded(track))
+                                        metadataCache_.putTrack(trackObj);
+                                    playbackHandler_.playTrack(trackObj);
+                                }
                             }
                             break;
 
 
 				        case SP_LINKTYPE_PLAYLIST:
                             {
-                                sp_playlist* playlist = sp_playlist_create(spotifySession_, link);
-                                Playlist playlistObj(spotifyGetPlaylist(playlist, spotifySession_));
-                                playbackHandler_.playPlaylist(playlistObj, reqEvent->startIndex_);
+                                const Playlist* cached = metadataCache_.getPlaylist(reqEvent->query_);
+                                if (cached)
+                                {
+                                    playbackHandler_.playPlaylist(*cached, reqEvent->startIndex_);
+                                }
+                                else
+                                {
+                                    sp_playlist* playlist = sp_playlist_create(spotifySession_, link);
+                                    Playlist playlistObj(spotifyGetPlaylist(playlist, spotifySession_));
+                                    playbackHandler_.playPlaylist(playlistObj, reqEvent->startIndex_);
+                                }
                                 log(LOG_NOTICE) << "Adding " << reqEvent->query_ << " to playbackhandler";
                             }
                             break;
 
                         case SP_LINKTYPE_ALBUM:
                             {
-                                sp_album* album = sp_link_as_album(link);
-                                sp_albumbrowse_create (spotifySession_, album, &LibSpotifyIfCallbackWrapper::albumLoadedCallback, new PlayReqEventItem( *reqEvent ) );
-                                log(LOG_NOTICE) << "Created sp_albumbrowse for " << reqEvent->query_ << ", waiting for load finished callback";
+                                const Album* cached = metadataCache_.getAlbum(reqEvent->query_);
+                                if (cached)
+                                {
+                                    playbackHandler_.playAlbum(*cached, reqEvent->startIndex_);
+                                }
+                                else
+                                {
+                                    sp_album* album = sp_link_as_album(link);
+                                    sp_albumbrowse_create (spotifySession_, album, &LibSpotifyIfCallbackWrapper::albumLoadedCallback, newWaitingReq( *reqEvent ) );
+                                    log(LOG_NOTICE) << "Created sp_albumbrowse for " << reqEvent->query_ << ", waiting for load finished callback";
+                                }
                             }
                             break;
 				        /* FALL_THROUGH */
@@ -483,15 +816,14 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
         case EVENT_STOP_REQ:
             if (trackState_ != TRACK_STATE_NOT_LOADED)
             {
-                callbackSubscriberMtx_.lock();
-                for( std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-                        it != callbackSubscriberList_.end(); it++)
+                CallbackSubscribers subscribers = getCallbackSubscribers();
+                for( MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+                        it != subscribers->end(); it++)
                 {
                     (*it)->statusUpdateInd( PLAYBACK_IDLE,
                                             playbackHandler_.getRepeat(),
                                             playbackHandler_.getShuffle() );
                 }
-                callbackSubscriberMtx_.unlock();
 
                 sp_session_player_play(spotifySession_, 0);
                 currentEndpoint_->flushAudioData();
@@ -507,9 +839,9 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 		        currentEndpoint_->pause();
 		        trackState_ = TRACK_STATE_PAUSED;
 
-		        callbackSubscriberMtx_.lock();
-		        for(std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-		                it != callbackSubscriberList_.end(); it++)
+		        CallbackSubscribers subscribers = getCallbackSubscribers();
+		        for(MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+		                it != subscribers->end(); it++)
 		        {
 		            (*it)->statusUpdateInd( PLAYBACK_PAUSED,
 		                                    playbackHandler_.getRepeat(),
@@ -517,7 +849,6 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 		                                    currentTrack_,
 		                                    progress_/10 );
 		        }
-		        callbackSubscriberMtx_.unlock();
 		    }
 			break;
 
@@ -528,9 +859,9 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
                 currentEndpoint_->resume();
                 trackState_ = TRACK_STATE_PLAYING;
 
-                callbackSubscriberMtx_.lock();
-                for(std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-                        it != callbackSubscriberList_.end(); it++)
+                CallbackSubscribers subscribers = getCallbackSubscribers();
+                for(MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+                        it != subscribers->end(); it++)
                 {
                     (*it)->statusUpdateInd( PLAYBACK_PLAYING,
                                             playbackHandler_.getRepeat(),
@@ -538,7 +869,6 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
                                             currentTrack_,
                                             progress_/10 );
                 }
-                callbackSubscriberMtx_.unlock();
             }
 			break;
 
@@ -564,11 +894,12 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
                             sp_session_player_play(spotifySession_, 1);
                             currentEndpoint_->resume();
                             progress_ = 0;
+                            suggestionTrie_.played(currentTrack_);
 
-                            callbackSubscriberMtx_.lock();
+                            CallbackSubscribers subscribers = getCallbackSubscribers();
                             /* Tell all subscribers that the track is playing */
-                            for(std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-                                it != callbackSubscriberList_.end(); it++)
+                            for(MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+                                it != subscribers->end(); it++)
                             {
                                 (*it)->statusUpdateInd( PLAYBACK_PLAYING,
                                                         playbackHandler_.getRepeat(),
@@ -576,7 +907,8 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
                                                         currentTrack_,
                                                         progress_/10 );
                             }
-                            callbackSubscriberMtx_.unlock();
+
+                            prefetchNextTrack();
                         }
                         else
                         {
@@ -586,7 +918,7 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
                     }
                     else if (err == SP_ERROR_IS_LOADING)
                     {
-                        pendingMetadata.push(new TrackEventItem( *trackEvent ));
+                        waitForTrack(track, new TrackEventItem( *trackEvent ));
                         log(LOG_DEBUG) << "Waiting for metadata for track " << trackObj->getLink().c_str();
                     }
                     else
@@ -599,6 +931,38 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 	        }
 		    break;
 
+		case EVENT_END_OF_TRACK:
+		{
+		    trackState_ = TRACK_STATE_NOT_LOADED;
+
+		    /* status for the next track follows right away if there is one */
+		    Track next("", "");
+		    if (!playbackHandler_.getNextTrack(next))
+		    {
+		        CallbackSubscribers subscribers = getCallbackSubscribers();
+		        for(MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+		            it != subscribers->end(); it++)
+		        {
+		            (*it)->statusUpdateInd( PLAYBACK_IDLE,
+		                                    playbackHandler_.getRepeat(),
+		                                    playbackHandler_.getShuffle() );
+		        }
+		    }
+
+		    /* what's left of this track in the audio fifo keeps playing while the next one is loaded */
+		    playbackHandler_.trackEndedInd();
+		    break;
+		}
+
+		case EVENT_PREFETCH_TRACK:
+		    /* metadata arrived, the next track may have changed meanwhile though */
+		    prefetchNextTrack();
+		    break;
+
+		case EVENT_READAHEAD:
+		    startReadahead();
+		    break;
+
 		/* Session Handling*/
 
 		case EVENT_LOGGING_IN:
@@ -609,7 +973,10 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 
         case EVENT_LOGGED_IN:
             state_ = STATE_LOGGED_IN;
-            updateRootFolder(sp_session_playlistcontainer(spotifySession_));
+            sp_playlistcontainer_add_callbacks(sp_session_playlistcontainer(spotifySession_),
+                                               itsCallbackWrapper_.getRegisteredPlaylistContainerCallbacks(),
+                                               NULL);
+            rootFolderLayoutChanged_ = true;
             break;
 
 		case EVENT_CONNECTION_LOST:
@@ -628,6 +995,18 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 			break;
 		case EVENT_LOGGED_OUT:
 			state_ = STATE_LOGGED_OUT;
+			sp_playlistcontainer_remove_callbacks(sp_session_playlistcontainer(spotifySession_),
+			                                      itsCallbackWrapper_.getRegisteredPlaylistContainerCallbacks(),
+			                                      NULL);
+			/* the next user may see different playlists */
+			rootFolderLayout_.clear();
+			rootFolderPlaylists_.clear();
+			changedPlaylists_.clear();
+			clearWaiters();
+			unwatchPlaylists();
+			metadataCache_.clear();
+			clearInFlight();
+			cancelReadahead();
 			break;
 
 		default:
@@ -637,19 +1016,197 @@ void LibSpotifyIf::stateMachineEventHandler(EventItem* event)
 	{
 		sp_session_process_events(spotifySession_, &nextTimeoutForLibSpotify);
 	} while (nextTimeoutForLibSpotify == 0);
+
+	if (rootFolderLayoutChanged_ || !changedPlaylists_.empty())
+		updateRootFolder();
+
+	if (!changedWaitedPlaylists_.empty())
+		wakePlaylistWaiters();
+	if (!playlistWaiters_.empty() || !trackWaiters_.empty())
+		expireWaiters();
+
+	if (librarySnapshotDirty_ && getMonotonicTime_us() - librarySnapshotSaved_ >= librarySnapshotInterval_us)
+		saveLibrarySnapshot();
 }
 void LibSpotifyIf::postToEventThread(EventItem* event)
 {
+	event->postTime_ = getMonotonicTime_us();
 	eventQueueMtx_.lock();
-	eventQueue_.push(event);
+	eventQueue_[getEventPriority(event->event_)].push(event);
+	eventQueueDepth_.set( queuedEvents() );
 	eventQueueMtx_.unlock();
 	cond_.signal();
 }
 
-void LibSpotifyIf::updateRootFolder(sp_playlistcontainer* plContainer)
+/* called with eventQueueMtx_ held */
+size_t LibSpotifyIf::queuedEvents() const
+{
+	size_t events = 0;
+	for (int prio = 0; prio < NUM_EVENT_PRIORITIES; prio++)
+		events += eventQueue_[prio].size();
+	return events;
+}
+
+LibSpotifyIf::EventPriority LibSpotifyIf::getEventPriority(Event event)
+{
+	switch (event)
+	{
+		/* METADATA_UPDATED stays with control, it is cheap and may wake a track about to be played */
+		case EVENT_GET_TRACKS:
+		case EVENT_GENERIC_SEARCH:
+		case EVENT_GET_IMAGE:
+		case EVENT_GET_ALBUM:
+		case EVENT_READAHEAD:
+			return PRIORITY_METADATA;
+		default:
+			return PRIORITY_CONTROL;
+	}
+}
+
+/* applies what the playlist container and playlist callbacks have reported since last time */
+void LibSpotifyIf::updateRootFolder()
+{
+    bool changed = false;
+
+    if (rootFolderLayoutChanged_)
+        changed = rebuildRootFolder(sp_session_playlistcontainer(spotifySession_));
+
+    if (!changed)
+    {
+        /* same layout, only convert the playlists that changed */
+        for (std::set<sp_playlist*>::iterator it = changedPlaylists_.begin(); it != changedPlaylists_.end(); it++)
+        {
+            std::pair<RootFolderPlaylists::iterator, RootFolderPlaylists::iterator> range = rootFolderPlaylists_.equal_range(*it);
+            if (range.first == range.second)
+                continue; /* not in the root folder, only in the metadata cache */
+
+            Playlist playlist(spotifyGetPlaylist(*it, spotifySession_));
+            for (RootFolderPlaylists::iterator pl = range.first; pl != range.second; pl++)
+            {
+                if (*pl->second != playlist)
+                {
+                    searchIndex_.addPlaylist(playlist);
+                    searchIndex_.removePlaylist(*pl->second);
+                    *pl->second = playlist;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    rootFolderLayoutChanged_ = false;
+    changedPlaylists_.clear();
+
+    if (warmStart_)
+    {
+        /* a half loaded container would look like lost playlists, keep serving last run's
+         * root folder until it is complete. Clients only hear about it if it differs */
+        if (!sp_playlistcontainer_is_loaded(sp_session_playlistcontainer(spotifySession_)))
+            return;
+
+        warmStart_ = false;
+        searchIndex_.removeFolder(*rootFolderSnapshot_);
+        changed = librarySnapshot_.differs(rootFolder_);
+        if (!changed)
+        {
+            log(LOG_NOTICE) << "Root folder unchanged since last run, still version " << rootFolderVersion_;
+            publishRootFolder();
+        }
+    }
+
+	if(changed)
+	{
+	    Platform::SharedPtr<const Folder> previous = getRootFolder();
+	    unsigned int previousVersion = rootFolderVersion_;
+	    rootFolderVersion_++;
+	    log(LOG_DEBUG) << "Root folder updated to version " << rootFolderVersion_;
+	    publishRootFolder();
+	    rebuildSuggestionTrie(getRootFolder());
+	    librarySnapshotDirty_ = true;
+		CallbackSubscribers subscribers = getCallbackSubscribers();
+		/* Tell all subscribers that the rootFolder has been updated */
+		for(MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+			it != subscribers->end(); it++)
+		{
+			(*it)->rootFolderUpdatedInd();
+		}
+		recordLibraryChanges(*previous, previousVersion);
+	}
+}
+
+void LibSpotifyIf::recordLibraryChanges(const Folder& previous, unsigned int previousVersion)
+{
+    static const size_t maxLibraryChanges = 32;
+
+    Platform::SharedPtr<const std::vector<LibraryChange> > changes;
+    Platform::SharedPtr<const Folder> resync;
+    std::vector<LibraryChange>* diff = new std::vector<LibraryChange>;
+    changes.reset(diff);
+    if (!diffRootFolders(previous, rootFolder_, *diff))
+    {
+        log(LOG_NOTICE) << "Root folder version " << rootFolderVersion_ << " has other folders, subscribers get all of it";
+        changes.reset();
+        resync = getRootFolder();
+    }
+    else
+    {
+        log(LOG_DEBUG) << "Root folder version " << rootFolderVersion_ << " is " << diff->size() << " changes";
+    }
+
+    libraryChanges_.push_back(LibraryChanges(rootFolderVersion_, changes));
+    if (libraryChanges_.size() > maxLibraryChanges)
+        libraryChanges_.pop_front();
+
+    CallbackSubscribers subscribers = getCallbackSubscribers();
+    for(MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+        it != subscribers->end(); it++)
+    {
+        deliverResponse(new LibraryChangedIndJob(*it, previousVersion, rootFolderVersion_, changes, resync));
+    }
+}
+
+/* false if the subscriber needs the whole root folder instead */
+bool LibSpotifyIf::getLibraryChanges(unsigned int epoch, unsigned int since, std::vector<LibraryChange>& changes) const
+{
+    if (epoch != libraryEpoch_)
+        return false;
+    if (since == rootFolderVersion_)
+        return true;
+    if (since > rootFolderVersion_ || libraryChanges_.empty() || since < libraryChanges_.front().version_ - 1)
+        return false;
+
+    for (std::deque<LibraryChanges>::const_iterator it = libraryChanges_.begin(); it != libraryChanges_.end(); it++)
+    {
+        if (it->version_ <= since)
+            continue;
+        if (it->changes_.isNull())
+        {
+            changes.clear();
+            return false;
+        }
+        changes.insert(changes.end(), it->changes_->begin(), it->changes_->end());
+    }
+    return true;
+}
+
+/* rebuilds the tree if the container layout changed, playlists that haven't changed are
+ * copied from the current tree instead of being converted again. false if the layout is the same */
+bool LibSpotifyIf::rebuildRootFolder(sp_playlistcontainer* plContainer)
 {
 	int numberOfPlaylists = sp_playlistcontainer_num_playlists(plContainer);
-	if(numberOfPlaylists < 0)return;
+	if(numberOfPlaylists < 0)return false;
+
+	std::vector<ContainerEntry> layout;
+	layout.reserve(numberOfPlaylists);
+	for (int playlistIndex = 0; playlistIndex < numberOfPlaylists; ++playlistIndex)
+	{
+	    sp_playlist_type type = sp_playlistcontainer_playlist_type(plContainer, playlistIndex);
+	    layout.push_back(ContainerEntry(type,
+	                                    (type == SP_PLAYLIST_TYPE_PLAYLIST) ? sp_playlistcontainer_playlist(plContainer, playlistIndex) : NULL,
+	                                    (type == SP_PLAYLIST_TYPE_START_FOLDER) ? sp_playlistcontainer_playlist_folder_id(plContainer, playlistIndex) : 0));
+	}
+	if (layout == rootFolderLayout_)
+	    return false;
 
 	/* create the root folder */
 	Folder tmpRootFolder("root", 0, 0);
@@ -658,22 +1215,29 @@ void LibSpotifyIf::updateRootFolder(sp_playlistcontainer* plContainer)
 
 	for (int playlistIndex = 0; playlistIndex < numberOfPlaylists; ++playlistIndex)
 	{
-		switch (sp_playlistcontainer_playlist_type(plContainer, playlistIndex))
+		switch (layout[playlistIndex].type_)
 		{
 			case SP_PLAYLIST_TYPE_PLAYLIST:
 			{
-
-				sp_playlist* pl = sp_playlistcontainer_playlist(plContainer, playlistIndex);
-				Playlist playlist(spotifyGetPlaylist(pl, spotifySession_));
-				currentFolder->addPlaylist(playlist);
+				sp_playlist* pl = layout[playlistIndex].playlist_;
+				RootFolderPlaylists::iterator known = rootFolderPlaylists_.find(pl);
+				if (known != rootFolderPlaylists_.end() && changedPlaylists_.find(pl) == changedPlaylists_.end())
+				{
+				    currentFolder->addPlaylist(*known->second);
+				}
+				else
+				{
+				    Playlist playlist(spotifyGetPlaylist(pl, spotifySession_));
+				    currentFolder->addPlaylist(playlist);
+				}
+				watchPlaylist(pl);
 				break;
 			}
 			case SP_PLAYLIST_TYPE_START_FOLDER:
 			{
 				char folderName[200];
 				sp_playlistcontainer_playlist_folder_name(plContainer, playlistIndex, folderName, sizeof(folderName));
-				unsigned long long id = sp_playlistcontainer_playlist_folder_id(plContainer, playlistIndex);
-				Folder folder(folderName, id, currentFolder);
+				Folder folder(folderName, layout[playlistIndex].folderId_, currentFolder);
 				currentFolder->addFolder(folder);
 				currentFolder = &currentFolder->getFolders().back();
 				break;
@@ -689,19 +1253,104 @@ void LibSpotifyIf::updateRootFolder(sp_playlistcontainer* plContainer)
 		}
 	}
 
-	if(rootFolder_ != tmpRootFolder)
-	{
-	    log(LOG_DEBUG) << "Root folder updated!";
-		rootFolder_ = tmpRootFolder;
-		callbackSubscriberMtx_.lock();
-		/* Tell all subscribers that the rootFolder has been updated */
-		for(std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-			it != callbackSubscriberList_.end(); it++)
-		{
-			(*it)->rootFolderUpdatedInd();
-		}
-		callbackSubscriberMtx_.unlock();
-	}
+	/* unchanged playlists share their tracks with the old tree, so they aren't reindexed */
+	searchIndex_.addFolder(tmpRootFolder);
+	searchIndex_.removeFolder(rootFolder_);
+	rootFolder_ = tmpRootFolder;
+	rootFolderLayout_.swap(layout);
+	indexRootFolder();
+	unwatchRemovedPlaylists(layout);
+	return true;
+}
+
+/* stop watching playlists that were in the old layout but have left the container,
+ * unless someone is still waiting for one of them to load */
+void LibSpotifyIf::unwatchRemovedPlaylists(const std::vector<ContainerEntry>& oldLayout)
+{
+    for (std::vector<ContainerEntry>::const_iterator it = oldLayout.begin(); it != oldLayout.end(); it++)
+    {
+        if (it->playlist_ != NULL &&
+            rootFolderPlaylists_.find(it->playlist_) == rootFolderPlaylists_.end() &&
+            playlistWaiters_.find(it->playlist_) == playlistWaiters_.end())
+        {
+            unwatchPlaylist(it->playlist_);
+        }
+    }
+}
+
+/* The copy shares all track lists with rootFolder_ and so with the previous snapshot,
+ * only the folder/playlist skeleton is copied. Readers still holding the previous
+ * snapshot keep it alive until they are done with it */
+void LibSpotifyIf::publishRootFolder()
+{
+    Platform::SharedPtr<const Folder> snapshot(new Folder(rootFolder_));
+    rootFolderSnapshotMtx_.lock();
+    rootFolderSnapshot_.swap(snapshot);
+    rootFolderSnapshotMtx_.unlock();
+    /* the previous snapshot is released here, outside the lock */
+}
+
+/* the current trie keeps answering until the new one is swapped in */
+void LibSpotifyIf::rebuildSuggestionTrie(const Platform::SharedPtr<const Folder>& root)
+{
+    SuggestionTrie::Plays plays;
+    suggestionTrie_.getPlays(plays);
+    suggestionTrieBuilder_.build(root, config_.getSuggestionTrieSize(), plays);
+}
+
+/* on the builder thread */
+void LibSpotifyIf::suggestionTrieBuilt()
+{
+    postToEventThread(new EventItem(EVENT_SUGGESTION_TRIE_BUILT));
+}
+
+void LibSpotifyIf::swapInSuggestionTrie()
+{
+    SuggestionTrie* built = suggestionTrieBuilder_.takeBuilt();
+    if (built == NULL)
+        return; /* taken by an earlier event */
+
+    /* tracks played while it was being built */
+    built->takePlays(suggestionTrie_);
+    suggestionTrie_.swap(*built);
+    delete built;
+    suggestionTrieBytes_.set(suggestionTrie_.getBytes());
+    log(LOG_DEBUG) << "Suggestion trie swapped in, " << suggestionTrie_.getEntryCount() << " names";
+}
+
+void LibSpotifyIf::saveLibrarySnapshot()
+{
+    /* the published snapshot, the writer thread encodes it while rootFolder_ moves on */
+    librarySnapshot_.save(getRootFolder(), rootFolderVersion_);
+    librarySnapshotDirty_ = false;
+    librarySnapshotSaved_ = getMonotonicTime_us();
+}
+
+/* finds each playlist in rootFolder_ by replaying the layout it was built from */
+void LibSpotifyIf::indexRootFolder()
+{
+    std::vector<FolderPosition> path(1, FolderPosition(&rootFolder_));
+
+    rootFolderPlaylists_.clear();
+    for (std::vector<ContainerEntry>::const_iterator it = rootFolderLayout_.begin(); it != rootFolderLayout_.end(); it++)
+    {
+        FolderPosition& current = path.back();
+        switch (it->type_)
+        {
+            case SP_PLAYLIST_TYPE_PLAYLIST:
+                rootFolderPlaylists_.insert(std::make_pair(it->playlist_, &current.folder_->getPlaylists()[current.nextPlaylist_++]));
+                break;
+            case SP_PLAYLIST_TYPE_START_FOLDER:
+                path.push_back(FolderPosition(&current.folder_->getFolders()[current.nextFolder_++]));
+                break;
+            case SP_PLAYLIST_TYPE_END_FOLDER:
+                if (path.size() > 1)
+                    path.pop_back();
+                break;
+            default:
+                break;
+        }
+    }
 }
 
 /* * * * * * * * * * * * * * * * * * * * * * * * * * *
@@ -753,26 +1402,139 @@ void LibSpotifyIf::metadataUpdatedCb(sp_session *session)
 	*/
 }
 
+/* called from the libspotify audio thread */
 void LibSpotifyIf::endOfTrackCb(sp_session *session)
 {
     log(LOG_DEBUG) << "End of track";
-    log(LOG_WARN) << progress_;
-    trackState_ = TRACK_STATE_NOT_LOADED; /*todo, this should happen when buffer is finished*/
-
-	/* Tell all subscribers that the track has ended */
-	/* JESPER: perhaps this should be done from the main thread?*/
-	callbackSubscriberMtx_.lock();
-	for(std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-		it != callbackSubscriberList_.end(); it++)
-	{
-        (*it)->statusUpdateInd( PLAYBACK_IDLE,
-                                playbackHandler_.getRepeat(),
-                                playbackHandler_.getShuffle() );
-	}
-	callbackSubscriberMtx_.unlock();
+    postToEventThread( new EventItem( EVENT_END_OF_TRACK ) );
+}
 
-	/* special handling for the playbackhandler */
-	playbackHandler_.trackEndedInd();
+void LibSpotifyIf::prefetchNextTrack()
+{
+    Track next("", "");
+    if (!playbackHandler_.getNextTrack(next))
+        return;
+
+    sp_link* link = sp_link_create_from_string(next.getLink().c_str());
+    if (link)
+    {
+        if (sp_link_type(link) == SP_LINKTYPE_TRACK)
+        {
+            sp_track* track = sp_link_as_track(link);
+            sp_error err = sp_track_error(track);
+            if (err == SP_ERROR_OK)
+            {
+                if ((err = sp_session_player_prefetch(spotifySession_, track)) == SP_ERROR_OK)
+                {
+                    log(LOG_DEBUG) << "Prefetching " << next.getLink();
+                    prefetches_.increment();
+                }
+                else log(LOG_DEBUG) << "Prefetch error for " << next.getLink() << " (" << sp_error_message(err) << ")";
+            }
+            else if (err == SP_ERROR_IS_LOADING)
+            {
+                waitForTrack(track, new TrackEventItem(EVENT_PREFETCH_TRACK, next));
+            }
+        }
+        sp_link_release(link);
+    }
+}
+
+/* queues the albums of the upcoming tracks that aren't cached yet, forgetting about the old play queue */
+void LibSpotifyIf::startReadahead()
+{
+    cancelReadahead();
+    if (state_ != STATE_LOGGED_IN)
+        return;
+
+    TrackQueue upcoming;
+    playbackHandler_.getUpcomingTracks(upcoming, readaheadTracks_);
+    for (TrackQueue::const_iterator it = upcoming.begin(); it != upcoming.end(); it++)
+    {
+        const std::string& album = it->getAlbumLink();
+        if (album.empty() || std::find(readaheadPending_.begin(), readaheadPending_.end(), album) != readaheadPending_.end())
+            continue;
+        if (metadataCache_.hasAlbum(album) && imageCache_.contains(album))
+            continue;
+        readaheadPending_.push_back(album);
+    }
+
+    continueReadahead();
+}
+
+void LibSpotifyIf::cancelReadahead()
+{
+    readaheadGeneration_++;
+    readaheadPending_.clear();
+}
+
+/* starts on queued albums as long as there is room */
+void LibSpotifyIf::continueReadahead()
+{
+    while (readaheadInFlight_ < readaheadConcurrency_ && !readaheadPending_.empty())
+    {
+        ReadaheadEventItem* item = new ReadaheadEventItem(readaheadPending_.front(), readaheadGeneration_);
+        readaheadPending_.pop_front();
+
+        sp_link* link = sp_link_create_from_string(item->albumLink_.c_str());
+        if (link == NULL || sp_link_type(link) != SP_LINKTYPE_ALBUM)
+        {
+            log(LOG_DEBUG) << "Not reading ahead " << item->albumLink_;
+            if (link) sp_link_release(link);
+            delete item;
+            continue;
+        }
+
+        log(LOG_DEBUG) << "Reading ahead " << item->albumLink_;
+        readaheadInFlight_++;
+        readaheads_.increment();
+
+        /* item is done with once readaheadDone() is called, which may happen right here */
+        sp_album* album = sp_link_as_album(link);
+        if (metadataCache_.hasAlbum(item->albumLink_) && sp_album_is_loaded(album))
+            readaheadCover(album, item);
+        else
+            sp_albumbrowse_create( spotifySession_, album, &LibSpotifyIfCallbackWrapper::albumLoadedCallback, item );
+        sp_link_release(link);
+    }
+}
+
+/* the album is loaded, on with its cover unless that is cached already */
+void LibSpotifyIf::readaheadCover(sp_album* album, ReadaheadEventItem* item)
+{
+    const byte* imgRef = sp_album_cover(album);
+    sp_image* img = NULL;
+    if (imgRef && !imageCache_.contains(item->albumLink_))
+        img = sp_image_create(spotifySession_, imgRef);
+
+    if (img == NULL)
+    {
+        readaheadDone(item);
+    }
+    else if (sp_image_is_loaded(img))
+    {
+        size_t dataSize = 0;
+        const void* data = sp_image_data(img, &dataSize);
+        imageCache_.put(item->albumLink_, data, dataSize);
+        sp_image_release(img);
+        readaheadDone(item);
+    }
+    else if (sp_image_error(img) == SP_ERROR_IS_LOADING)
+    {
+        sp_image_add_load_callback(img, &LibSpotifyIfCallbackWrapper::imageLoadedCallback, item);
+    }
+    else
+    {
+        sp_image_release(img);
+        readaheadDone(item);
+    }
+}
+
+void LibSpotifyIf::readaheadDone(ReadaheadEventItem* item)
+{
+    readaheadInFlight_--;
+    delete item;
+    continueReadahead();
 }
 
 void LibSpotifyIf::loggedOutCb(sp_session *session)
@@ -794,9 +1556,17 @@ void LibSpotifyIf::connectionErrorCb(sp_session *session, sp_error error)
 	postToEventThread( new EventItem( EVENT_CONNECTION_LOST ) );
 }
 
+/* may be called from any libspotify thread */
 void LibSpotifyIf::notifyLibSpotifyMainThreadCb(sp_session *session)
 {
-	postToEventThread( new EventItem( EVENT_ITERATE_MAIN_LOOP ) );
+	eventQueueMtx_.lock();
+	if (!iteratePending_)
+	{
+		iteratePending_ = true;
+		iteratePostTime_ = getMonotonicTime_us();
+	}
+	eventQueueMtx_.unlock();
+	cond_.signal();
 }
 
 int LibSpotifyIf::musicDeliveryCb(sp_session *sess, const sp_audioformat *format,
@@ -818,19 +1588,36 @@ void LibSpotifyIf::addAudio()
 
 void LibSpotifyIf::genericSearchCb(sp_search *search, void *userdata)
 {
-	QueryReqEventItem* msg = static_cast<QueryReqEventItem*>(userdata);
+	SearchReqEventItem* msg = static_cast<SearchReqEventItem*>(userdata);
+	msg->trace( "libspotify search", msg->postTime_, getMonotonicTime_us() );
 
-	std::deque<Track> searchReply;
 	std::string didYouMean(sp_search_did_you_mean(search));
 
 
     log(LOG_DEBUG) << "Tracks in total: " << sp_search_total_tracks(search);
 
+    /* converted and passed on a part at a time, so the subscribers can start on
+     * the first tracks while the rest are converted. Each request skips the library
+     * matches it was sent when it started, which may differ if the library changed
+     * between the leader and the requests that joined it */
+    InFlightReqs reqs = takeInFlight(msg);
+    std::vector<Playlist> searchReplies(reqs.size(), Playlist("", ""));
     for (int i = 0; i < sp_search_num_tracks(search); ++i)
     {
         sp_track* track = sp_search_track(search, i);
         Track trackObj(spotifyGetTrack(track, spotifySession_));
-        searchReply.push_back(trackObj);
+        for (size_t req = 0; req < reqs.size(); req++)
+        {
+            if (static_cast<SearchReqEventItem*>(reqs[req])->sentLinks_.count(trackObj.getLink()) > 0)
+                continue;
+            searchReplies[req].addTrack(trackObj);
+
+            if (searchReplies[req].getTracks().size() == searchPartTracks && i + 1 < sp_search_num_tracks(search))
+            {
+                deliverResponse(new SearchPartResponseJob(reqs[req]->callbackSubscriber_, reqs[req]->reqId_, searchReplies[req].getTracks()));
+                searchReplies[req] = Playlist("", "");
+            }
+        }
     }
 
     //for (i = 0; i < sp_search_num_albums(search); ++i)
@@ -840,30 +1627,55 @@ void LibSpotifyIf::genericSearchCb(sp_search *search, void *userdata)
         //print_artist(sp_search_artist(search, i));
 
 
-	msg->callbackSubscriber_->genericSearchCallback(msg->reqId_, searchReply, didYouMean);
+	for (size_t req = 0; req < reqs.size(); req++)
+	    deliverResponse(new SearchResponseJob(reqs[req]->callbackSubscriber_, reqs[req]->reqId_, searchReplies[req], didYouMean));
+	releaseInFlight(reqs);
 	sp_search_release(search);
 	delete msg;
 }
 
 void LibSpotifyIf::imageLoadedCb(sp_image* image, void *userdata)
 {
+    if (static_cast<EventItem*>(userdata)->event_ == EVENT_READAHEAD_ALBUM)
+    {
+        ReadaheadEventItem* item = static_cast<ReadaheadEventItem*>(userdata);
+        if (sp_image_error(image) == SP_ERROR_OK)
+        {
+            size_t dataSize = 0;
+            const void* data = sp_image_data(image, &dataSize);
+            imageCache_.put(item->albumLink_, data, dataSize);
+        }
+        sp_image_remove_load_callback(image, &LibSpotifyIfCallbackWrapper::imageLoadedCallback, item);
+        sp_image_release(image);
+        readaheadDone(item);
+        return;
+    }
+
     QueryReqEventItem* msg = static_cast<QueryReqEventItem*>(userdata);
+    msg->trace( "libspotify image", msg->postTime_, getMonotonicTime_us() );
     postToEventThread( msg );
 }
 
 void LibSpotifyIf::albumLoadedCb(sp_albumbrowse* result, void *userdata)
 {
     EventItem* ev = static_cast<EventItem*>(userdata);
+    if (ev->event_ != EVENT_READAHEAD_ALBUM)
+        static_cast<ReqEventItem*>(ev)->trace( "libspotify albumbrowse", ev->postTime_, getMonotonicTime_us() );
     Album album = spotifyGetAlbum(result, spotifySession_);
 
     log(LOG_NOTICE) << "Album \"" << album.getName() << "\" loaded";
+    if (sp_albumbrowse_error(result) == SP_ERROR_OK)
+        metadataCache_.putAlbum(album);
 
     switch ( ev->event_ )
     {
         case EVENT_GET_ALBUM:
         {
             QueryReqEventItem* msg = static_cast<QueryReqEventItem*>(userdata);
-            msg->callbackSubscriber_->getAlbumResponse(msg->reqId_, album);
+            InFlightReqs reqs = takeInFlight(msg);
+            for (InFlightReqs::iterator it = reqs.begin(); it != reqs.end(); it++)
+                deliverResponse(new AlbumResponseJob((*it)->callbackSubscriber_, (*it)->reqId_, album));
+            releaseInFlight(reqs);
             delete msg;
             break;
         }
@@ -880,6 +1692,15 @@ void LibSpotifyIf::albumLoadedCb(sp_albumbrowse* result, void *userdata)
             postToEventThread( msg );
             break;
         }
+        case EVENT_READAHEAD_ALBUM:
+        {
+            ReadaheadEventItem* item = static_cast<ReadaheadEventItem*>(userdata);
+            if (item->generation_ == readaheadGeneration_ && sp_albumbrowse_error(result) == SP_ERROR_OK)
+                readaheadCover(sp_albumbrowse_album(result), item);
+            else
+                readaheadDone(item);
+            break;
+        }
         default:
             assert(1);
     }
@@ -887,9 +1708,300 @@ void LibSpotifyIf::albumLoadedCb(sp_albumbrowse* result, void *userdata)
     sp_albumbrowse_release(result);
 }
 
+void LibSpotifyIf::playlistChangedCb(sp_playlist* playlist)
+{
+    sp_link* link = sp_link_create_from_playlist(playlist);
+    if (link)
+    {
+        char uri[256];
+        sp_link_as_string(link, uri, sizeof(uri));
+        sp_link_release(link);
+        metadataCache_.invalidate(uri);
+    }
+    changedPlaylists_.insert(playlist);
+    if (playlistWaiters_.find(playlist) != playlistWaiters_.end())
+        changedWaitedPlaylists_.insert(playlist);
+}
+
+void LibSpotifyIf::playlistContainerChangedCb(sp_playlistcontainer* plContainer)
+{
+    rootFolderLayoutChanged_ = true;
+}
+
+void LibSpotifyIf::watchPlaylist(sp_playlist* playlist)
+{
+    if (watchedPlaylists_.insert(playlist).second)
+    {
+        sp_playlist_add_ref(playlist);
+        sp_playlist_add_callbacks(playlist, itsCallbackWrapper_.getRegisteredPlaylistCallbacks(), NULL);
+    }
+}
+
+/* without its callbacks a cached copy would go stale, so it leaves the metadata cache
+ * too. It is fetched and watched again if it's asked for */
+void LibSpotifyIf::unwatchPlaylist(sp_playlist* playlist)
+{
+    if (watchedPlaylists_.erase(playlist) == 0)
+        return;
+
+    sp_link* link = sp_link_create_from_playlist(playlist);
+    if (link)
+    {
+        char uri[256];
+        sp_link_as_string(link, uri, sizeof(uri));
+        sp_link_release(link);
+        metadataCache_.invalidate(uri);
+    }
+    changedPlaylists_.erase(playlist);
+    sp_playlist_remove_callbacks(playlist, itsCallbackWrapper_.getRegisteredPlaylistCallbacks(), NULL);
+    sp_playlist_release(playlist);
+}
+
+void LibSpotifyIf::unwatchPlaylists()
+{
+    for (std::set<sp_playlist*>::iterator it = watchedPlaylists_.begin(); it != watchedPlaylists_.end(); it++)
+    {
+        sp_playlist_remove_callbacks(*it, itsCallbackWrapper_.getRegisteredPlaylistCallbacks(), NULL);
+        sp_playlist_release(*it);
+    }
+    watchedPlaylists_.clear();
+}
+
+/* event is handled again once playlist has loaded */
+void LibSpotifyIf::waitForPlaylist(sp_playlist* playlist, EventItem* event)
+{
+    watchPlaylist(playlist); /* for its state changed callback */
+    playlistWaiters_.insert(std::make_pair(playlist, MetadataWaiter(event, getMonotonicTime_us() + metadataTimeout_us)));
+    metadataWaits_.increment();
+}
+
+/* event is handled again once track has loaded */
+void LibSpotifyIf::waitForTrack(sp_track* track, EventItem* event)
+{
+    sp_track_add_ref(track);
+    trackWaiters_.insert(std::make_pair(track, MetadataWaiter(event, getMonotonicTime_us() + metadataTimeout_us)));
+    metadataWaits_.increment();
+}
+
+void LibSpotifyIf::wakeWaiter(EventItem* event)
+{
+    const ReqEventItem* reqItem = getReqEvent(event);
+    if (reqItem)
+        reqItem->trace("libspotify metadata", event->postTime_, getMonotonicTime_us());
+    postToEventThread(event);
+}
+
+void LibSpotifyIf::wakePlaylistWaiters()
+{
+    for (std::set<sp_playlist*>::iterator pl = changedWaitedPlaylists_.begin(); pl != changedWaitedPlaylists_.end(); pl++)
+    {
+        if (!sp_playlist_is_loaded(*pl))
+            continue; /* there will be another callback when it is */
+
+        std::pair<PlaylistWaiters::iterator, PlaylistWaiters::iterator> range = playlistWaiters_.equal_range(*pl);
+        for (PlaylistWaiters::iterator it = range.first; it != range.second; it++)
+            wakeWaiter(it->second.event_);
+        playlistWaiters_.erase(range.first, range.second);
+    }
+    changedWaitedPlaylists_.clear();
+}
+
+void LibSpotifyIf::wakeTrackWaiters()
+{
+    for (TrackWaiters::iterator it = trackWaiters_.begin(); it != trackWaiters_.end(); )
+    {
+        if (sp_track_error(it->first) == SP_ERROR_IS_LOADING)
+        {
+            it++;
+            continue;
+        }
+        wakeWaiter(it->second.event_);
+        sp_track_release(it->first);
+        trackWaiters_.erase(it++);
+    }
+}
+
+/* fails the waiters past their deadline, and makes sure the loop wakes up for the next one */
+void LibSpotifyIf::expireWaiters()
+{
+    uint64_t now = getMonotonicTime_us();
+    uint64_t next = 0;
+
+    for (PlaylistWaiters::iterator it = playlistWaiters_.begin(); it != playlistWaiters_.end(); )
+    {
+        if (it->second.deadline_ > now)
+        {
+            if (next == 0 || it->second.deadline_ < next) next = it->second.deadline_;
+            it++;
+            continue;
+        }
+        failWaiter(it->second.event_);
+        playlistWaiters_.erase(it++);
+    }
+
+    for (TrackWaiters::iterator it = trackWaiters_.begin(); it != trackWaiters_.end(); )
+    {
+        if (it->second.deadline_ > now)
+        {
+            if (next == 0 || it->second.deadline_ < next) next = it->second.deadline_;
+            it++;
+            continue;
+        }
+        failWaiter(it->second.event_);
+        sp_track_release(it->first);
+        trackWaiters_.erase(it++);
+    }
+
+    if (next != 0)
+    {
+        int untilNext = static_cast<int>((next - now) / 1000) + 1;
+        if (untilNext < nextTimeoutForLibSpotify)
+            nextTimeoutForLibSpotify = untilNext;
+    }
+}
+
+/* every request that timed out is answered with FAIL_TIMEOUT, together with the requests
+ * that joined it. Waiters nobody asked for (tracks to play or prefetch) are only logged */
+void LibSpotifyIf::failWaiter(EventItem* event)
+{
+    metadataTimeouts_.increment();
+
+    const ReqEventItem* req = getReqEvent(event);
+    if (req == NULL)
+    {
+        if (event->event_ == EVENT_PLAY_TRACK || event->event_ == EVENT_PREFETCH_TRACK)
+        {
+            log(LOG_WARN) << "Timed out waiting for track " << static_cast<TrackEventItem*>(event)->track_.getLink();
+        }
+        else
+        {
+            log(LOG_WARN) << "Timed out waiting for metadata for " << getEventName(event);
+        }
+        delete event;
+        return;
+    }
+
+    req->trace("libspotify metadata", event->postTime_, getMonotonicTime_us());
+    if (event->event_ == EVENT_LIBRARY_SUBSCRIBE)
+    {
+        log(LOG_WARN) << "Timed out waiting for metadata for " << getEventName(event);
+        deliverResponse(new FailedResponseJob(req->callbackSubscriber_, req->reqId_, FAIL_TIMEOUT));
+    }
+    else
+    {
+        QueryReqEventItem* reqEvent = static_cast<QueryReqEventItem*>(event);
+        log(LOG_WARN) << "Timed out waiting for metadata for " << getEventName(event) << " " << reqEvent->query_;
+        InFlightReqs reqs = takeInFlight(reqEvent);
+        for (InFlightReqs::iterator it = reqs.begin(); it != reqs.end(); it++)
+            deliverResponse(new FailedResponseJob((*it)->callbackSubscriber_, (*it)->reqId_, FAIL_TIMEOUT));
+        releaseInFlight(reqs);
+    }
+    delete event;
+}
+
+void LibSpotifyIf::clearWaiters()
+{
+    size_t waiting = playlistWaiters_.size() + trackWaiters_.size();
+    if (waiting > 0)
+        log(LOG_NOTICE) << "Dropping " << waiting << " requests waiting for metadata";
+
+    for (PlaylistWaiters::iterator it = playlistWaiters_.begin(); it != playlistWaiters_.end(); it++)
+        delete it->second.event_;
+    for (TrackWaiters::iterator it = trackWaiters_.begin(); it != trackWaiters_.end(); it++)
+    {
+        sp_track_release(it->first);
+        delete it->second.event_;
+    }
+    playlistWaiters_.clear();
+    trackWaiters_.clear();
+    changedWaitedPlaylists_.clear();
+}
+
+/* true if an identical request is already waiting for libspotify,
+ * req is then answered together with it and needs no further handling */
+template <class T> bool LibSpotifyIf::joinInFlight(T* req)
+{
+    if (req->leader_)
+        return false;
+
+    InFlightMap::iterator it = inFlight_.find(std::make_pair(req->event_, req->query_));
+    if (it == inFlight_.end())
+        return false;
+
+    log(LOG_DEBUG) << "Joining in flight " << getEventName(req) << " " << req->query_;
+    it->second.push_back(newWaitingReq(*req));
+    coalescedRequests_.increment();
+    return true;
+}
+
+/* req is about to wait for libspotify, call before copying it */
+void LibSpotifyIf::leadInFlight(QueryReqEventItem* req)
+{
+    req->leader_ = true;
+    inFlight_[std::make_pair(req->event_, req->query_)];
+}
+
+/* req followed by the requests that joined it, to be answered with the same result */
+LibSpotifyIf::InFlightReqs LibSpotifyIf::takeInFlight(QueryReqEventItem* req)
+{
+    InFlightReqs reqs(1, req);
+    if (req->leader_)
+    {
+        InFlightMap::iterator it = inFlight_.find(std::make_pair(req->event_, req->query_));
+        if (it != inFlight_.end())
+        {
+            reqs.insert(reqs.end(), it->second.begin(), it->second.end());
+            inFlight_.erase(it);
+        }
+        req->leader_ = false;
+    }
+    return reqs;
+}
+
+/* frees the joined requests, the first one (the leader) stays with the caller */
+void LibSpotifyIf::releaseInFlight(InFlightReqs& reqs)
+{
+    uint64_t now = getMonotonicTime_us();
+    for (InFlightReqs::iterator it = reqs.begin() + 1; it < reqs.end(); it++)
+    {
+        (*it)->trace( "coalesced", (*it)->postTime_, now );
+        delete *it;
+    }
+    reqs.clear();
+}
+
+void LibSpotifyIf::clearInFlight()
+{
+    for (InFlightMap::iterator it = inFlight_.begin(); it != inFlight_.end(); it++)
+    {
+        if (!it->second.empty())
+            log(LOG_NOTICE) << "Dropping " << it->second.size() << " requests waiting for " << it->first.second;
+        for (InFlightReqs::iterator req = it->second.begin(); req != it->second.end(); req++)
+            delete *req;
+    }
+    inFlight_.clear();
+}
+
 /* *****************
  * local helpers
  * *****************/
+const LibSpotifyIf::ReqEventItem* getReqEvent(LibSpotifyIf::EventItem* event)
+{
+    switch(event->event_)
+    {
+        case LibSpotifyIf::EVENT_GET_TRACKS:
+        case LibSpotifyIf::EVENT_GENERIC_SEARCH:
+        case LibSpotifyIf::EVENT_GET_IMAGE:
+        case LibSpotifyIf::EVENT_GET_ALBUM:
+        case LibSpotifyIf::EVENT_SEARCH_SUGGEST:
+        case LibSpotifyIf::EVENT_LIBRARY_SUBSCRIBE:
+        case LibSpotifyIf::EVENT_PLAY_REQ:
+            return static_cast<LibSpotifyIf::ReqEventItem*>( event );
+        default:
+            return NULL;
+    }
+}
+
 const char* getEventName(LibSpotifyIf::EventItem* event)
 {
 	switch(event->event_)
@@ -908,6 +2020,12 @@ const char* getEventName(LibSpotifyIf::EventItem* event)
 		    return "EVENT_GET_IMAGE";
 		case LibSpotifyIf::EVENT_GET_ALBUM:
 		    return "EVENT_GET_ALBUM";
+		case LibSpotifyIf::EVENT_SEARCH_SUGGEST:
+		    return "EVENT_SEARCH_SUGGEST";
+		case LibSpotifyIf::EVENT_LIBRARY_SUBSCRIBE:
+		    return "EVENT_LIBRARY_SUBSCRIBE";
+		case LibSpotifyIf::EVENT_SUGGESTION_TRIE_BUILT:
+		    return "EVENT_SUGGESTION_TRIE_BUILT";
 
 			/* Playback handling */
 		case LibSpotifyIf::EVENT_PLAY_REQ:
@@ -922,6 +2040,14 @@ const char* getEventName(LibSpotifyIf::EventItem* event)
 		    return "EVENT_RESUME_PLAYBACK";
 		case LibSpotifyIf::EVENT_PLAY_TRACK:
 		    return "EVENT_PLAY_TRACK";
+		case LibSpotifyIf::EVENT_END_OF_TRACK:
+		    return "EVENT_END_OF_TRACK";
+		case LibSpotifyIf::EVENT_PREFETCH_TRACK:
+		    return "EVENT_PREFETCH_TRACK";
+		case LibSpotifyIf::EVENT_READAHEAD:
+		    return "EVENT_READAHEAD";
+		case LibSpotifyIf::EVENT_READAHEAD_ALBUM:
+		    return "EVENT_READAHEAD_ALBUM";
 
              /* Session handling */
 		case LibSpotifyIf::EVENT_LOGGING_IN:
@@ -30,6 +30,14 @@
 
 #include "LibSpotifyIfCallbackWrapper.h"
 #include "LibSpotifyPlaybackHandler.h"
+#include "MetadataCache.h"
+#include "ImageCache.h"
+#include "LibrarySnapshot.h"
+#include "LibrarySearchIndex.h"
+#include "SuggestionTrie.h"
+#include "SuggestionTrieBuilder.h"
+#include "LibraryDelta.h"
+#include "ResponseWorkers.h"
 
 #include "ConfigHandling/ConfigHandler.h"
 #include "MediaContainers/Folder.h"
@@ -38,16 +46,22 @@
 #include "MessageFactory/Message.h"
 #include "Platform/Threads/Runnable.h"
 #include "Platform/Threads/Condition.h"
+#include "Platform/Threads/SharedPtr.h"
 #include "MediaInterface/MediaInterface.h"
+#include "Metrics/Metrics.h"
+#include "Tracing/Tracer.h"
+#include "Tracing/Watchdog.h"
 #include <libspotify/api.h>
+#include <stdint.h>
 #include <set>
+#include <map>
 #include <vector>
-#include <queue>
+#include <deque>
 
 namespace LibSpotify
 {
 
-class LibSpotifyIf : Platform::Runnable, public MediaInterface
+class LibSpotifyIf : Platform::Runnable, public MediaInterface, SuggestionTrieBuilder::Listener
 {
 /**********************
  *
@@ -71,6 +85,9 @@ public:
 		EVENT_GENERIC_SEARCH,
 		EVENT_GET_IMAGE,
 		EVENT_GET_ALBUM,
+		EVENT_SEARCH_SUGGEST,
+		EVENT_LIBRARY_SUBSCRIBE,
+		EVENT_SUGGESTION_TRIE_BUILT,
 
 		/* Playback Handling */
 		EVENT_PLAY_REQ,
@@ -79,6 +96,10 @@ public:
 		EVENT_PLAY_TRACK,
         EVENT_PAUSE_PLAYBACK,
         EVENT_RESUME_PLAYBACK,
+        EVENT_END_OF_TRACK,
+        EVENT_PREFETCH_TRACK,
+        EVENT_READAHEAD,
+        EVENT_READAHEAD_ALBUM,
 
         /* Others */
         EVENT_ITERATE_MAIN_LOOP
@@ -88,7 +109,10 @@ public:
     {
     public:
         Event event_;
-        EventItem(Event event) : event_(event) {}
+        uint64_t postTime_;
+        EventItem* next_; /* link in the event queue */
+        EventItem(Event event) : event_(event), postTime_(0), next_(NULL) {}
+        virtual ~EventItem() {}
     };
 
     class TrackEventItem : public EventItem
@@ -98,19 +122,59 @@ public:
         TrackEventItem(Event event, const Track& track) : EventItem(event), track_(track) {}
     };
 
+    /* an album being read ahead, see startReadahead() */
+    class ReadaheadEventItem : public EventItem
+    {
+    public:
+        std::string albumLink_;
+        unsigned int generation_;
+        ReadaheadEventItem(const std::string& albumLink, unsigned int generation) : EventItem(EVENT_READAHEAD_ALBUM), albumLink_(albumLink), generation_(generation) {}
+    };
+
     class ReqEventItem : public EventItem
     {
     public:
         MediaInterfaceRequestId reqId_;
         IMediaInterfaceCallbackSubscriber* callbackSubscriber_;
         ReqEventItem(Event event, MediaInterfaceRequestId reqId, IMediaInterfaceCallbackSubscriber* callbackSubscriber) : EventItem(event), reqId_(reqId), callbackSubscriber_(callbackSubscriber) {}
+
+        /* subscriber and request id together identify the client request in the trace */
+        void trace(const char* name, uint64_t start_us, uint64_t end_us) const
+        {
+            Tracing::Tracer::instance().record(name, callbackSubscriber_, reqId_, start_us, end_us);
+        }
     };
 
     class QueryReqEventItem : public ReqEventItem
     {
     public:
         std::string query_;
-        QueryReqEventItem(Event event, MediaInterfaceRequestId reqId, IMediaInterfaceCallbackSubscriber* callbackSubscriber, std::string query) : ReqEventItem(event, reqId, callbackSubscriber), query_(query) {}
+        /* set when libspotify works on behalf of this request, identical requests then wait for it (see joinInFlight()) */
+        bool leader_;
+        QueryReqEventItem(Event event, MediaInterfaceRequestId reqId, IMediaInterfaceCallbackSubscriber* callbackSubscriber, std::string query) : ReqEventItem(event, reqId, callbackSubscriber), query_(query), leader_(false) {}
+    };
+
+    class SearchReqEventItem : public QueryReqEventItem
+    {
+    public:
+        /* the library matches already sent to this request, not repeated among spotify's results */
+        std::set<std::string> sentLinks_;
+        SearchReqEventItem( MediaInterfaceRequestId reqId, IMediaInterfaceCallbackSubscriber* callbackSubscriber, std::string query) : QueryReqEventItem(EVENT_GENERIC_SEARCH, reqId, callbackSubscriber, query) {}
+    };
+
+    class SuggestReqEventItem : public QueryReqEventItem
+    {
+    public:
+        unsigned int maxSuggestions_;
+        SuggestReqEventItem( MediaInterfaceRequestId reqId, IMediaInterfaceCallbackSubscriber* callbackSubscriber, std::string prefix, unsigned int maxSuggestions) : QueryReqEventItem(EVENT_SEARCH_SUGGEST, reqId, callbackSubscriber, prefix), maxSuggestions_(maxSuggestions) {}
+    };
+
+    class LibrarySubscribeReqEventItem : public ReqEventItem
+    {
+    public:
+        unsigned int epoch_;
+        unsigned int version_;
+        LibrarySubscribeReqEventItem( MediaInterfaceRequestId reqId, IMediaInterfaceCallbackSubscriber* callbackSubscriber, unsigned int epoch, unsigned int version) : ReqEventItem(EVENT_LIBRARY_SUBSCRIBE, reqId, callbackSubscriber), epoch_(epoch), version_(version) {}
     };
 
     class PlayReqEventItem : public QueryReqEventItem
@@ -153,6 +217,57 @@ public:
 private:
 	Folder rootFolder_;
 
+	/* The root folder is kept in sync from the playlist container and playlist callbacks.
+	 * They only record what changed, updateRootFolder() applies it once libspotify is done
+	 * so that only changed playlists are converted again */
+	class ContainerEntry
+	{
+	public:
+	    sp_playlist_type type_;
+	    sp_playlist* playlist_;
+	    sp_uint64 folderId_;
+	    ContainerEntry(sp_playlist_type type, sp_playlist* playlist, sp_uint64 folderId) : type_(type), playlist_(playlist), folderId_(folderId) {}
+	    bool operator==(const ContainerEntry& rhs) const { return type_ == rhs.type_ && playlist_ == rhs.playlist_ && folderId_ == rhs.folderId_; }
+	};
+	std::vector<ContainerEntry> rootFolderLayout_;
+	/* where each playlist of the container lives in rootFolder_ */
+	typedef std::multimap<sp_playlist*, Playlist*> RootFolderPlaylists;
+	RootFolderPlaylists rootFolderPlaylists_;
+	std::set<sp_playlist*> changedPlaylists_;
+	bool rootFolderLayoutChanged_;
+	unsigned int rootFolderVersion_;
+
+	/* rootFolder_ belongs to the event thread, everybody else gets the latest
+	 * published copy of it. A snapshot is never changed, a new one replaces it */
+	Platform::Mutex rootFolderSnapshotMtx_;
+	Platform::SharedPtr<const Folder> rootFolderSnapshot_;
+	void publishRootFolder();
+
+	/* the root folder of the previous run is published at startup and kept until the
+	 * playlist container has loaded, changes are saved back at most every so often */
+	LibrarySnapshot librarySnapshot_;
+	bool warmStart_;
+	bool librarySnapshotDirty_;
+	uint64_t librarySnapshotSaved_;
+	void saveLibrarySnapshot();
+
+	/* what the last few root folder changes were, for LIBRARY_SUBSCRIBE and LIBRARY_CHANGED.
+	 * An entry without changes is one that couldn't be expressed as changes, subscribers
+	 * from before it get the whole root folder. So do subscribers with a version of another
+	 * epoch: the changes are only remembered while the server runs, and the version counts
+	 * again from the last snapshot (or 0) after a restart */
+	const unsigned int libraryEpoch_;
+	class LibraryChanges
+	{
+	public:
+	    unsigned int version_; /* changed from the previous version to this one */
+	    Platform::SharedPtr<const std::vector<LibraryChange> > changes_;
+	    LibraryChanges(unsigned int version, const Platform::SharedPtr<const std::vector<LibraryChange> >& changes) : version_(version), changes_(changes) {}
+	};
+	std::deque<LibraryChanges> libraryChanges_;
+	void recordLibraryChanges(const Folder& previous, unsigned int previousVersion);
+	bool getLibraryChanges(unsigned int epoch, unsigned int since, std::vector<LibraryChange>& changes) const;
+
 	/*********************
 	 * Synchronization
 	 * with libspotify
@@ -164,9 +279,63 @@ private:
 	/****************
 	 * Event queue
 	 ****************/
+	/* FIFO linked through EventItem::next_, so queueing never allocates */
+	class EventQueue
+	{
+	private:
+	    EventItem* head_;
+	    EventItem* tail_;
+	    size_t size_;
+	public:
+	    EventQueue() : head_(NULL), tail_(NULL), size_(0) {}
+	    bool empty() const { return head_ == NULL; }
+	    size_t size() const { return size_; }
+	    void push(EventItem* event)
+	    {
+	        event->next_ = NULL;
+	        if (tail_) tail_->next_ = event;
+	        else head_ = event;
+	        tail_ = event;
+	        size_++;
+	    }
+	    EventItem* pop()
+	    {
+	        EventItem* event = head_;
+	        head_ = event->next_;
+	        if (!head_) tail_ = NULL;
+	        event->next_ = NULL;
+	        size_--;
+	        return event;
+	    }
+	};
+
+	/* Playback control and session events go ahead of metadata requests, so that
+	 * pause/next stay responsive while a burst of searches and browses is queued.
+	 * FIFO within each priority */
+	enum EventPriority
+	{
+	    PRIORITY_CONTROL = 0,
+	    PRIORITY_METADATA,
+	    NUM_EVENT_PRIORITIES
+	};
+	static EventPriority getEventPriority(Event event);
+
 	Platform::Mutex eventQueueMtx_;
-	typedef std::queue<EventItem*> EventQueueMessageQueue;
-	EventQueueMessageQueue eventQueue_;
+	EventQueue eventQueue_[NUM_EVENT_PRIORITIES];
+	size_t queuedEvents() const;
+	/* libspotify asking to be iterated is a flag, not an event. Any event iterates it
+	 * anyway, so pending notifications collapse into one and cost no allocation */
+	bool iteratePending_;
+	uint64_t iteratePostTime_;
+	EventItem iterateEvent_;
+
+	/* time spent in the queue and in the handler, per event type */
+	Metrics::Histogram* eventWaitTime_[EVENT_ITERATE_MAIN_LOOP + 1];
+	Metrics::Histogram* eventExecTime_[EVENT_ITERATE_MAIN_LOOP + 1];
+	Metrics::Gauge& eventQueueDepth_;
+
+	/* odd while an event is being handled, for the stall watchdog */
+	Tracing::Heartbeat heartbeat_;
 
 	/************************
 	 * Statemachine handling
@@ -180,17 +349,108 @@ private:
 	friend class LibSpotifyPlaybackHandler;
 	LibSpotifyPlaybackHandler playbackHandler_;
 	void playTrack(const Track& track);
+	/* gets the upcoming track into libspotify's cache while this one plays, so it can start without a gap */
+	void prefetchNextTrack();
+	Metrics::Counter& prefetches_;
+
+	/* Album details and cover art for the next few tracks in the play queue are
+	 * loaded into the caches in the background, since clients ask for them as soon
+	 * as the track changes. Starts over whenever the play queue changes */
+	void playQueueChangedInd();
+	void startReadahead();
+	void cancelReadahead();
+	void continueReadahead();
+	void readaheadCover(sp_album* album, ReadaheadEventItem* item);
+	void readaheadDone(ReadaheadEventItem* item);
+	unsigned int readaheadTracks_;
+	unsigned int readaheadConcurrency_;
+	/* bumped when the play queue changes, what is in flight for an older one is left unfinished */
+	unsigned int readaheadGeneration_;
+	unsigned int readaheadInFlight_;
+	std::deque<std::string> readaheadPending_;
+	Metrics::Counter& readaheads_;
 
 	/**************************
 	 * libspotify interactions
 	 **************************/
 	void libSpotifySessionCreate();
-	void updateRootFolder(sp_playlistcontainer* plContainer);
+	void updateRootFolder();
+	bool rebuildRootFolder(sp_playlistcontainer* plContainer);
+	void indexRootFolder();
 
    	/************************
      * Metadata handling
      ************************/
-    std::queue<EventItem*> pendingMetadata;
+    /* Requests waiting for a playlist or track to load, keyed by what they wait for.
+     * Playlists are woken by their own callbacks, tracks on metadata updates since
+     * libspotify has nothing per track. Each waiter fails once its deadline passes */
+    class MetadataWaiter
+    {
+    public:
+        EventItem* event_;
+        uint64_t deadline_;
+        MetadataWaiter(EventItem* event, uint64_t deadline) : event_(event), deadline_(deadline) {}
+    };
+    typedef std::multimap<sp_playlist*, MetadataWaiter> PlaylistWaiters;
+    typedef std::multimap<sp_track*, MetadataWaiter> TrackWaiters;
+    PlaylistWaiters playlistWaiters_;
+    TrackWaiters trackWaiters_;
+    std::set<sp_playlist*> changedWaitedPlaylists_;
+    Metrics::Counter& metadataWaits_;
+    Metrics::Counter& metadataTimeouts_;
+    void waitForPlaylist(sp_playlist* playlist, EventItem* event);
+    void waitForTrack(sp_track* track, EventItem* event);
+    void wakeWaiter(EventItem* event);
+    void wakePlaylistWaiters();
+    void wakeTrackWaiters();
+    void expireWaiters();
+    void failWaiter(EventItem* event);
+    void clearWaiters();
+
+    MetadataCache metadataCache_;
+    /* playlists in the metadata cache or waited for, we hold a reference to each and invalidate on changes */
+    std::set<sp_playlist*> watchedPlaylists_;
+    void watchPlaylist(sp_playlist* playlist);
+    void unwatchPlaylist(sp_playlist* playlist);
+    void unwatchPlaylists();
+    void unwatchRemovedPlaylists(const std::vector<ContainerEntry>& oldLayout);
+
+    ImageCache imageCache_;
+
+    /* tracks of the root folder (and of last run's while warm starting), searches
+     * are answered from here when the library has matches */
+    LibrarySearchIndex searchIndex_;
+    Metrics::Counter& localSearches_;
+    Metrics::Histogram& localSearchTime_;
+
+    /* names of the root folder's tracks, artists, albums and playlists for SEARCH_SUGGEST,
+     * rebuilt by the builder thread when the root folder changes and swapped in here */
+    SuggestionTrie suggestionTrie_;
+    Metrics::Histogram& suggestTime_;
+    Metrics::Gauge& suggestionTrieBytes_;
+    SuggestionTrieBuilder suggestionTrieBuilder_;
+    void rebuildSuggestionTrie(const Platform::SharedPtr<const Folder>& root);
+    void suggestionTrieBuilt();
+    void swapInSuggestionTrie();
+
+   	/************************
+     * Request coalescing
+     ************************/
+    /* identical requests (same event and link or query) waiting for libspotify, keyed to the leader */
+    typedef std::vector<QueryReqEventItem*> InFlightReqs;
+    typedef std::map<std::pair<Event, std::string>, InFlightReqs> InFlightMap;
+    InFlightMap inFlight_;
+    Metrics::Counter& coalescedRequests_;
+    template <class T> bool joinInFlight(T* req);
+    void leadInFlight(QueryReqEventItem* req);
+    InFlightReqs takeInFlight(QueryReqEventItem* req);
+    void releaseInFlight(InFlightReqs& reqs);
+    void clearInFlight();
+
+    /* building the response messages is left to these, off the libspotify thread */
+    ResponseWorkers responseWorkers_;
+    Metrics::Histogram& responseDeliverTime_;
+    void deliverResponse(ResponseJob* job);
 
 	//callback wrapper
 	friend class LibSpotifyIfCallbackWrapper;
@@ -213,6 +473,9 @@ private:
 	void genericSearchCb(sp_search *search, void *userdata);
     void imageLoadedCb(sp_image* image, void *userdata);
     void albumLoadedCb(sp_albumbrowse* result, void *userdata);
+    /* playlist callbacks */
+    void playlistChangedCb(sp_playlist* playlist);
+    void playlistContainerChangedCb(sp_playlistcontainer* plContainer);
 	/* Util callbacks */
 	void logMessageCb(sp_session *session, const char *data);
 
@@ -223,6 +486,12 @@ public:
 	void logIn();
 	void logOut();
 
+	const Tracing::Heartbeat& getHeartbeat() const;
+	/* bumped every time the root folder actually changes */
+	unsigned int getRootFolderVersion() const;
+	/* the latest published root folder, safe to hold on to from any thread */
+	Platform::SharedPtr<const Folder> getRootFolder();
+
     virtual void getImage( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId );
     virtual void previous();
     virtual void next();
@@ -237,8 +506,12 @@ public:
     virtual void play( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId );
     virtual void getAlbum( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId );
     virtual void search( std::string query, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId );
+    virtual void suggest( std::string prefix, unsigned int maxSuggestions, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId );
+    virtual void subscribeLibrary( unsigned int epoch, unsigned int version, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId );
     virtual void addAudio();
 
+    virtual void unRegisterForCallbacks(IMediaInterfaceCallbackSubscriber& subscriber);
+
 
     void playSearchResult(const char* searchString);
     void enqueueTrack(const char* track_uri);
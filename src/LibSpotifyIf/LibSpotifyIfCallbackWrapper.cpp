@@ -66,10 +66,30 @@ static sp_session_callbacks libSpotifySessioncallbacks =
  * The playlist container callbacks
  */
 static sp_playlistcontainer_callbacks libSpotifyContainerCallbacks = {
-	NULL,														//.playlist_added
-	NULL,														//.playlist_removed
-	NULL,														//.playlist_moved
-	NULL,														//.container_loaded
+	&LibSpotifyIfCallbackWrapper::playlistAdded,				//.playlist_added
+	&LibSpotifyIfCallbackWrapper::playlistRemoved,				//.playlist_removed
+	&LibSpotifyIfCallbackWrapper::playlistMoved,				//.playlist_moved
+	&LibSpotifyIfCallbackWrapper::playlistContainerLoaded,		//.container_loaded
+};
+
+
+/**
+ * The playlist callbacks, registered on every playlist in the root folder or the metadata cache
+ */
+static sp_playlist_callbacks libSpotifyPlaylistCallbacks = {
+	&LibSpotifyIfCallbackWrapper::tracksAddedCb,				//.tracks_added
+	&LibSpotifyIfCallbackWrapper::tracksRemovedCb,				//.tracks_removed
+	&LibSpotifyIfCallbackWrapper::tracksMovedCb,				//.tracks_moved
+	&LibSpotifyIfCallbackWrapper::playlistRenamedCb,			//.playlist_renamed
+	&LibSpotifyIfCallbackWrapper::playlistStateChangedCb,		//.playlist_state_changed
+	NULL,														//.playlist_update_in_progress
+	&LibSpotifyIfCallbackWrapper::playlistMetadataUpdatedCb,	//.playlist_metadata_updated
+	NULL,														//.track_created_changed
+	NULL,														//.track_seen_changed
+	NULL,														//.description_changed
+	NULL,														//.image_changed
+	NULL,														//.track_message_changed
+	NULL,														//.subscribers_changed
 };
 
 
@@ -92,6 +112,11 @@ sp_playlistcontainer_callbacks* LibSpotifyIfCallbackWrapper::getRegisteredPlayli
 	return &libSpotifyContainerCallbacks;
 }
 
+sp_playlist_callbacks* LibSpotifyIfCallbackWrapper::getRegisteredPlaylistCallbacks()
+{
+	return &libSpotifyPlaylistCallbacks;
+}
+
 /* *************************
  * Session Callbacks
  * **************************/
@@ -135,15 +160,47 @@ void SP_CALLCONV LibSpotifyIfCallbackWrapper::logMessageCb(sp_session *session,
  * **************************/
 void SP_CALLCONV LibSpotifyIfCallbackWrapper::playlistAdded(sp_playlistcontainer *pc, sp_playlist *playlist, int position, void *userdata)
 {
+	libSpotifyIfSingleton->playlistContainerChangedCb(pc);
 }
 void SP_CALLCONV LibSpotifyIfCallbackWrapper::playlistRemoved(sp_playlistcontainer *pc, sp_playlist *playlist, int position, void *userdata)
 {
+	libSpotifyIfSingleton->playlistContainerChangedCb(pc);
 }
 void SP_CALLCONV LibSpotifyIfCallbackWrapper::playlistMoved(sp_playlistcontainer *pc, sp_playlist *playlist, int position, int new_position, void *userdata)
 {
+	libSpotifyIfSingleton->playlistContainerChangedCb(pc);
 }
 void SP_CALLCONV LibSpotifyIfCallbackWrapper::playlistContainerLoaded(sp_playlistcontainer *pc, void *userdata)
 {
+	libSpotifyIfSingleton->playlistContainerChangedCb(pc);
+}
+
+/* **************************
+ * Playlist content Callbacks
+ * **************************/
+void SP_CALLCONV LibSpotifyIfCallbackWrapper::tracksAddedCb(sp_playlist *pl, sp_track * const *tracks, int num_tracks, int position, void *userdata)
+{
+	libSpotifyIfSingleton->playlistChangedCb(pl);
+}
+void SP_CALLCONV LibSpotifyIfCallbackWrapper::tracksRemovedCb(sp_playlist *pl, const int *tracks, int num_tracks, void *userdata)
+{
+	libSpotifyIfSingleton->playlistChangedCb(pl);
+}
+void SP_CALLCONV LibSpotifyIfCallbackWrapper::tracksMovedCb(sp_playlist *pl, const int *tracks, int num_tracks, int new_position, void *userdata)
+{
+	libSpotifyIfSingleton->playlistChangedCb(pl);
+}
+void SP_CALLCONV LibSpotifyIfCallbackWrapper::playlistRenamedCb(sp_playlist *pl, void *userdata)
+{
+	libSpotifyIfSingleton->playlistChangedCb(pl);
+}
+void SP_CALLCONV LibSpotifyIfCallbackWrapper::playlistStateChangedCb(sp_playlist *pl, void *userdata)
+{
+	libSpotifyIfSingleton->playlistChangedCb(pl);
+}
+void SP_CALLCONV LibSpotifyIfCallbackWrapper::playlistMetadataUpdatedCb(sp_playlist *pl, void *userdata)
+{
+	libSpotifyIfSingleton->playlistChangedCb(pl);
 }
 
 /* **************************
@@ -43,6 +43,7 @@ public:
 
 	sp_session_callbacks* getRegisteredSessionCallbacks();
 	sp_playlistcontainer_callbacks* getRegisteredPlaylistContainerCallbacks();
+	sp_playlist_callbacks* getRegisteredPlaylistCallbacks();
 
 	/* Session Callbacks */
 	static void SP_CALLCONV loggedInCb(sp_session *session, sp_error error);
@@ -55,11 +56,19 @@ public:
 	                          const void *frames, int num_frames);
 	static void SP_CALLCONV endOfTrackCb(sp_session *session);
 
-	/* Playlist callbacks */
-	void SP_CALLCONV playlistAdded(sp_playlistcontainer *pc, sp_playlist *playlist, int position, void *userdata);
-	void SP_CALLCONV playlistRemoved(sp_playlistcontainer *pc, sp_playlist *playlist, int position, void *userdata);
-	void SP_CALLCONV playlistMoved(sp_playlistcontainer *pc, sp_playlist *playlist, int position, int new_position, void *userdata);
-	void SP_CALLCONV playlistContainerLoaded(sp_playlistcontainer *pc, void *userdata);
+	/* Playlist container callbacks, all of them mean that the root folder changed structure */
+	static void SP_CALLCONV playlistAdded(sp_playlistcontainer *pc, sp_playlist *playlist, int position, void *userdata);
+	static void SP_CALLCONV playlistRemoved(sp_playlistcontainer *pc, sp_playlist *playlist, int position, void *userdata);
+	static void SP_CALLCONV playlistMoved(sp_playlistcontainer *pc, sp_playlist *playlist, int position, int new_position, void *userdata);
+	static void SP_CALLCONV playlistContainerLoaded(sp_playlistcontainer *pc, void *userdata);
+
+	/* Playlist content callbacks, all of them mean that the playlist changed */
+	static void SP_CALLCONV tracksAddedCb(sp_playlist *pl, sp_track * const *tracks, int num_tracks, int position, void *userdata);
+	static void SP_CALLCONV tracksRemovedCb(sp_playlist *pl, const int *tracks, int num_tracks, void *userdata);
+	static void SP_CALLCONV tracksMovedCb(sp_playlist *pl, const int *tracks, int num_tracks, int new_position, void *userdata);
+	static void SP_CALLCONV playlistRenamedCb(sp_playlist *pl, void *userdata);
+	static void SP_CALLCONV playlistStateChangedCb(sp_playlist *pl, void *userdata);
+	static void SP_CALLCONV playlistMetadataUpdatedCb(sp_playlist *pl, void *userdata);
 
 	/* search callbacks */
 	static void SP_CALLCONV genericSearchCallback(sp_search *search, void *userdata);
@@ -34,38 +34,84 @@ namespace LibSpotify
 
 LibSpotifyPlaybackHandler::LibSpotifyPlaybackHandler(LibSpotifyIf& libspotify) : libSpotifyIf_(libspotify),
                                                                                  historyQueue_(HISTORY_QUEUE_DEPTH),
+                                                                                 playPos_(0),
                                                                                  isShuffle(false),
                                                                                  isRepeat(false)
 {
-    playQueueIter_ = playQueue_.end();
 }
 
 LibSpotifyPlaybackHandler::~LibSpotifyPlaybackHandler() { }
 
 
+/* called with mtx_ held */
+unsigned int LibSpotifyPlaybackHandler::playQueueSize() const
+{
+    return playTable_.isNull() ? 0 : playTable_->size();
+}
+
+bool LibSpotifyPlaybackHandler::playQueueEnded() const
+{
+    return playPos_ >= playQueueSize();
+}
+
+LibSpotifyPlaybackHandler::QueuedTrack LibSpotifyPlaybackHandler::playQueueTrack(unsigned int pos) const
+{
+    return QueuedTrack(playTable_, isShuffle ? shuffleOrder_[pos] : pos);
+}
+
+void LibSpotifyPlaybackHandler::nextPlayPos(unsigned int& pos) const
+{
+    pos++;
+    if( isRepeat && pos == playQueueSize())
+        pos = 0;
+}
+
+/* startPos is the table index to start from (past the end if there is nothing to play),
+ * or -1 to start from the beginning of the play order */
+void LibSpotifyPlaybackHandler::setPlayTable(const TrackTable& table, int startPos)
+{
+    playTable_ = table;
+    if ( startPos < 0 )
+    {
+        playPos_ = 0;
+        if ( isShuffle )
+            shuffle( playQueueSize() );
+    }
+    else
+    {
+        playPos_ = startPos;
+        if ( isShuffle )
+        {
+            shuffle( startPos );
+            if ( !playQueueEnded() )
+                playPos_ = 0;
+        }
+    }
+}
+
 void LibSpotifyPlaybackHandler::playTrack(const Track& track)
 {
     mtx_.lock();
-    playQueue_.clear();
     currentlyPlayingFromName_ = track.getName();
     currentlyPlayingFromUri_ = track.getLink();
     currentlyPlayingFromType_ = TRACK;
-    playQueue_.push_back(track);
-    playQueueIter_ = playQueue_.begin();
-    if(enquedQueue_.empty())libSpotifyIf_.playTrack(playQueue_.front());
+    setPlayTable(TrackTable(new TrackQueue(1, track)), 0);
+    if(enquedQueue_.empty())libSpotifyIf_.playTrack(track);
+    libSpotifyIf_.playQueueChangedInd();
     mtx_.unlock();
 }
 
 void LibSpotifyPlaybackHandler::playFolder(const Folder& folder)
 {
     mtx_.lock();
-    playQueue_.clear();
     currentlyPlayingFromName_ = folder.getName();
     currentlyPlayingFromUri_ = ""; //Unknown so far as how to get the folder link..
     currentlyPlayingFromType_ = FOLDER;
-    folder.getAllTracks(playQueue_);
-    playQueueIter_ = playQueue_.begin();
-    if(enquedQueue_.empty())libSpotifyIf_.playTrack(playQueue_.front());
+    TrackQueue* tracks = new TrackQueue;
+    folder.getAllTracks(*tracks);
+    setPlayTable(TrackTable(tracks), -1);
+    if(enquedQueue_.empty() && !playQueueEnded())libSpotifyIf_.playTrack(playQueueTrack(playPos_).get());
+    libSpotifyIf_.playQueueChangedInd();
     mtx_.unlock();
 }
 
@@ -74,8 +120,9 @@ void LibSpotifyPlaybackHandler::playPlaylist( const Playlist& playlist, int star
     mtx_.lock();
     currentlyPlayingFromType_ = PLAYLIST;
     loadPlaylist( playlist, startIndex );
-    if( enquedQueue_.empty()  && ( playQueueIter_ != playQueue_.end() ) )
-        libSpotifyIf_.playTrack(*playQueueIter_);
+    if( enquedQueue_.empty()  && !playQueueEnded() )
+        libSpotifyIf_.playTrack(playQueueTrack(playPos_).get());
+    libSpotifyIf_.playQueueChangedInd();
     mtx_.unlock();
 
 }
@@ -85,36 +132,29 @@ void LibSpotifyPlaybackHandler::playAlbum( const Album& album, int startIndex )
     mtx_.lock();
     currentlyPlayingFromType_ = ALBUM;
     loadPlaylist( album, startIndex );
-    if( enquedQueue_.empty()  && ( playQueueIter_ != playQueue_.end() ) )
-        libSpotifyIf_.playTrack(*playQueueIter_);
+    if( enquedQueue_.empty()  && !playQueueEnded() )
+        libSpotifyIf_.playTrack(playQueueTrack(playPos_).get());
+    libSpotifyIf_.playQueueChangedInd();
     mtx_.unlock();
 }
 
 void LibSpotifyPlaybackHandler::loadPlaylist( const Playlist& playlist, int startIndex )
 {
-    playQueue_.clear();
     currentlyPlayingFromName_ = playlist.getName();
     currentlyPlayingFromUri_ = playlist.getLink();
-    playQueue_.insert(playQueue_.end(), playlist.getTracks().begin(), playlist.getTracks().end());
-    playQueueIter_ = playQueue_.begin();
-    if ( startIndex >= 0 )
-    {
-        while ( ( playQueueIter_ != playQueue_.end() ) && ( (*playQueueIter_).getIndex() != startIndex ) )
-            playQueueIter_++;
+    /* the playlist's own track list, nothing is copied. An empty playlist may have none */
+    TrackTable tracks = playlist.getSharedTracks();
+    if ( tracks.isNull() )
+        tracks.reset(new TrackQueue);
 
-        if ( playQueueIter_ != playQueue_.end() && isShuffle )
-        {
-            Track first = *playQueueIter_;
-            playQueue_.erase(playQueueIter_);
-            shuffle();
-            playQueue_.push_front(first);
-            playQueueIter_ = playQueue_.begin();
-        }
-    }
-    else if ( isShuffle )
+    int startPos = -1;
+    if ( startIndex >= 0 )
     {
-        shuffle();
+        startPos = 0;
+        while ( ( startPos < static_cast<int>(tracks->size()) ) && ( (*tracks)[startPos].getIndex() != startIndex ) )
+            startPos++;
     }
+    setPlayTable(tracks, startPos);
 }
 
 void LibSpotifyPlaybackHandler::playSearchResult(const std::string& searchString,
@@ -122,13 +162,12 @@ void LibSpotifyPlaybackHandler::playSearchResult(const std::string& searchString
                                                  const TrackQueue& searchResult)
 {
     mtx_.lock();
-    playQueue_.clear();
     currentlyPlayingFromName_ = searchString;
     currentlyPlayingFromUri_ = searchLink;
     currentlyPlayingFromType_ = SEARCH;
-    playQueue_ = searchResult;
-    playQueueIter_ = playQueue_.begin();
-    if(enquedQueue_.empty())libSpotifyIf_.playTrack(playQueue_.front());
+    setPlayTable(TrackTable(new TrackQueue(searchResult)), -1);
+    if(enquedQueue_.empty() && !playQueueEnded())libSpotifyIf_.playTrack(playQueueTrack(playPos_).get());
+    libSpotifyIf_.playQueueChangedInd();
     mtx_.unlock();
 }
 
@@ -136,7 +175,8 @@ void LibSpotifyPlaybackHandler::enqueueTrack(const Track& track)
 {
     mtx_.lock();
     if(enquedQueue_.empty())libSpotifyIf_.playTrack(track);
-    enquedQueue_.push_back(track);
+    enquedQueue_.push_back(QueuedTrack(TrackTable(new TrackQueue(1, track)), 0));
+    libSpotifyIf_.playQueueChangedInd();
     mtx_.unlock();
 }
 
@@ -148,7 +188,8 @@ void LibSpotifyPlaybackHandler::playNext()
     {
         historyQueue_.push_back(enquedQueue_.front());
         enquedQueue_.pop_front();
-        libSpotifyIf_.playTrack(enquedQueue_.front());
+        libSpotifyIf_.playTrack(enquedQueue_.front().get());
+        libSpotifyIf_.playQueueChangedInd();
     }
     mtx_.unlock();
 }
@@ -160,14 +201,68 @@ void LibSpotifyPlaybackHandler::playPrevious()
     {
         enquedQueue_.push_front(historyQueue_.back());
         historyQueue_.pop_back();
-        libSpotifyIf_.playTrack(enquedQueue_.front());
+        libSpotifyIf_.playTrack(enquedQueue_.front().get());
+        libSpotifyIf_.playQueueChangedInd();
+    }
+    mtx_.unlock();
+}
+
+bool LibSpotifyPlaybackHandler::getNextTrack(Track& next)
+{
+    TrackQueue upcoming;
+    getUpcomingTracks(upcoming, 1);
+    if(upcoming.empty())
+        return false;
+
+    next = upcoming.front();
+    return true;
+}
+
+void LibSpotifyPlaybackHandler::getUpcomingTracks(TrackQueue& upcoming, unsigned int count)
+{
+    mtx_.lock();
+    /* same order as trackEndedInd(), enqueued tracks first */
+    for(std::deque<QueuedTrack>::iterator it = enquedQueue_.begin(); it != enquedQueue_.end() && upcoming.size() < count; it++)
+    {
+        if(it != enquedQueue_.begin()) /*the first one is playing*/
+            upcoming.push_back(it->get());
+    }
+
+    if(!playQueueEnded())
+    {
+        /* the play queue continues where it was left, or after the current track if it is playing */
+        unsigned int pos = playPos_;
+        if(enquedQueue_.empty())
+            nextPlayPos(pos);
+
+        while(pos < playQueueSize() && upcoming.size() < count)
+        {
+            upcoming.push_back(playQueueTrack(pos).get());
+            nextPlayPos(pos);
+            if(pos == playPos_)
+                break; /* been through all of it */
+        }
     }
     mtx_.unlock();
 }
 
-void LibSpotifyPlaybackHandler::shuffle()
+/* a new play order, starting with first unless that is past the end */
+void LibSpotifyPlaybackHandler::shuffle(unsigned int first)
 {
-    random_shuffle( playQueue_.begin(), playQueue_.end() );
+    unsigned int size = playQueueSize();
+    shuffleOrder_.resize(size);
+    for ( unsigned int i = 0; i < size; i++ )
+        shuffleOrder_[i] = i;
+
+    if ( first < size )
+    {
+        std::swap( shuffleOrder_[0], shuffleOrder_[first] );
+        random_shuffle( shuffleOrder_.begin() + 1, shuffleOrder_.end() );
+    }
+    else
+    {
+        random_shuffle( shuffleOrder_.begin(), shuffleOrder_.end() );
+    }
 }
 
 /***************************************************
@@ -183,11 +278,11 @@ void LibSpotifyPlaybackHandler::trackEndedInd()
     /* 1. Move to history queue */
     if(enquedQueue_.empty())
     {
-        historyQueue_.push_back(*playQueueIter_);
-        playQueueIter_++;
-
-        if( isRepeat && playQueueIter_ == playQueue_.end())
-            playQueueIter_ = playQueue_.begin();
+        if(!playQueueEnded())
+        {
+            historyQueue_.push_back(playQueueTrack(playPos_));
+            nextPlayPos(playPos_);
+        }
     }
     else
     {
@@ -196,12 +291,11 @@ void LibSpotifyPlaybackHandler::trackEndedInd()
     }
 
     /* 2. Play next item */
-    if ( ( enquedQueue_.empty() == false ) ||
-         ( playQueue_.empty() == false && playQueueIter_ != playQueue_.end() ) )
-    {
-        if(enquedQueue_.empty())libSpotifyIf_.playTrack(*playQueueIter_);
-        else libSpotifyIf_.playTrack(enquedQueue_.front());
-    }
+    if(enquedQueue_.empty() == false)
+        libSpotifyIf_.playTrack(enquedQueue_.front().get());
+    else if(!playQueueEnded())
+        libSpotifyIf_.playTrack(playQueueTrack(playPos_).get());
+    libSpotifyIf_.playQueueChangedInd();
     mtx_.unlock();
 }
 
@@ -210,8 +304,6 @@ void LibSpotifyPlaybackHandler::rootFolderUpdatedInd()
     /* TODO: Should update the playQueue/Folder lists.. */
 }
 
-static bool playQueueCompareTrack (Track a, Track b) { return ( a.getIndex() < b.getIndex() ); }
-
 void LibSpotifyPlaybackHandler::setShuffle(bool shuffleOn)
 {
     if ( isShuffle == shuffleOn )
@@ -220,33 +312,28 @@ void LibSpotifyPlaybackHandler::setShuffle(bool shuffleOn)
     mtx_.lock();
     if ( shuffleOn )
     {
-        shuffle();
+        /* the current track (if we have one) stays current, the rest is shuffled */
+        shuffle( playPos_ );
+        if ( !playQueueEnded() )
+            playPos_ = 0;
     }
-    else
+    else if ( !playQueueEnded() )
     {
-        /*get the index of the current track (if we have one)*/
-        int currentIndex = -1;
-        if ( playQueueIter_ != playQueue_.end() )
-            currentIndex = (*playQueueIter_).getIndex();
-
-        /*put playqueue back in order*/
-        sort( playQueue_.begin(), playQueue_.end(), playQueueCompareTrack );
-
-        /*find the current track again (if we had one)*/
-        playQueueIter_ = playQueue_.begin();
-        if ( currentIndex >= 0 )
-        {
-            while ( ( playQueueIter_ != playQueue_.end() ) && ( (*playQueueIter_).getIndex() != currentIndex ) )
-                playQueueIter_++;
-        }
+        /* back to table order, from where the current track is */
+        playPos_ = shuffleOrder_[playPos_];
     }
     isShuffle = shuffleOn;
+    libSpotifyIf_.playQueueChangedInd();
     mtx_.unlock();
 }
 
 void LibSpotifyPlaybackHandler::setRepeat(bool repeatOn)
 {
+    if ( isRepeat == repeatOn )
+        return;
+
     isRepeat = repeatOn;
+    libSpotifyIf_.playQueueChangedInd();
 }
 
 bool LibSpotifyPlaybackHandler::getShuffle() { return isShuffle; }
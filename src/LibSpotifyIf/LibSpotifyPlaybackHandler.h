@@ -33,7 +33,9 @@
 #include "MediaContainers/Playlist.h"
 #include "MediaContainers/Album.h"
 #include "Platform/Threads/Mutex.h"
+#include "Platform/Threads/SharedPtr.h"
 #include <deque>
+#include <vector>
 #include "CircularQueue.h"
 
 
@@ -57,24 +59,48 @@ private:
     class LibSpotifyIf& libSpotifyIf_;
 
     Platform::Mutex mtx_;
+
+    /* Tracks are only ever copied into a table, once, the queues refer to them by index.
+     * A table is never modified once created, so it is shared by whoever still refers to it */
+    typedef Platform::SharedPtr<const TrackQueue> TrackTable;
+    class QueuedTrack
+    {
+    public:
+        TrackTable table_;
+        unsigned int index_;
+        QueuedTrack() : index_(0) {}
+        QueuedTrack(const TrackTable& table, unsigned int index) : table_(table), index_(index) {}
+        const Track& get() const { return (*table_)[index_]; }
+    };
+
     /*Contains all tracks that are enqued */
-    TrackQueue enquedQueue_;
+    std::deque<QueuedTrack> enquedQueue_;
 
     #define HISTORY_QUEUE_DEPTH 50
-    Util::CircularQueue<Track> historyQueue_;
+    Util::CircularQueue<QueuedTrack> historyQueue_;
 
     std::string currentlyPlayingFromName_;
     std::string currentlyPlayingFromUri_;
     CurrentlyPlayingFromType currentlyPlayingFromType_;
 
-    TrackQueue::iterator playQueueIter_;
-    TrackQueue playQueue_;
+    /* What is played from, playPos_ is where in the play order we are, playTable_->size()
+     * once it has all been played. The play order is the table order, or shuffleOrder_
+     * (a permutation of table indexes) when shuffling */
+    TrackTable playTable_;
+    std::vector<unsigned int> shuffleOrder_;
+    unsigned int playPos_;
 
     bool isShuffle;
     bool isRepeat;
 
+    unsigned int playQueueSize() const;
+    bool playQueueEnded() const;
+    QueuedTrack playQueueTrack(unsigned int pos) const;
+    void nextPlayPos(unsigned int& pos) const;
+
+    void setPlayTable(const TrackTable& table, int startPos);
     void loadPlaylist(const Playlist& playlist, int startIndex);
-    void shuffle();
+    void shuffle(unsigned int first);
 
 public:
     LibSpotifyPlaybackHandler(class LibSpotifyIf& spotifyIf);
@@ -91,6 +117,10 @@ public:
 
     void playNext();
     void playPrevious();
+    /* the track trackEndedInd() would start, so that it can be prefetched */
+    bool getNextTrack(Track& next);
+    /* up to count tracks in the order they will be played, after the current one */
+    void getUpcomingTracks(TrackQueue& upcoming, unsigned int count);
 
     void rootFolderUpdatedInd();
     void trackEndedInd();
@@ -30,6 +30,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
+#include <time.h>
 
 static sp_session_config g_config;
 
@@ -244,7 +246,12 @@ void sp_session_release(sp_session *sess) { }
 sp_user* sp_session_user(sp_session *session) { return &session->user; }
 int sp_session_user_country(sp_session *session) { return session->user_country; }
 sp_connectionstate sp_session_connectionstate(sp_session *session) { return session->connectionstate; }
-void sp_session_process_events(sp_session *session, int *next_timeout){ *next_timeout = 1;}
+static void deliverAudio(sp_session *session);
+void sp_session_process_events(sp_session *session, int *next_timeout)
+{
+	deliverAudio(session);
+	*next_timeout = 1;
+}
 
 
 
@@ -265,6 +272,7 @@ const char* sp_user_canonical_name(sp_user *user){ return user->canonicalName;}
  * *************************************/
 sp_playlistcontainer* sp_session_playlistcontainer(sp_session *session) { return &session->playlistcontainer; }
 int sp_playlistcontainer_num_playlists(sp_playlistcontainer *pc) { return pc->num_playlists; }
+bool sp_playlistcontainer_is_loaded(sp_playlistcontainer *pc) { return true; }
 
 sp_playlist* sp_playlist_create(sp_session* session, sp_link* link)
 {
@@ -336,6 +344,26 @@ bool sp_playlist_is_loaded(sp_playlist *playlist)
 	return 1;
 }
 
+void sp_playlist_add_callbacks(sp_playlist *playlist, sp_playlist_callbacks *callbacks, void *userdata)
+{
+	return;
+}
+
+void sp_playlist_remove_callbacks(sp_playlist *playlist, sp_playlist_callbacks *callbacks, void *userdata)
+{
+	return;
+}
+
+void sp_playlistcontainer_add_callbacks(sp_playlistcontainer *pc, sp_playlistcontainer_callbacks *callbacks, void *userdata)
+{
+	return;
+}
+
+void sp_playlistcontainer_remove_callbacks(sp_playlistcontainer *pc, sp_playlistcontainer_callbacks *callbacks, void *userdata)
+{
+	return;
+}
+
 
 /* ************************************
  * Track stubs
@@ -366,6 +394,11 @@ int sp_track_duration(sp_track *track)
     return track->duration;
 }
 
+bool sp_track_is_loaded(sp_track *track)
+{
+	return 1;
+}
+
 bool sp_track_is_starred(sp_session *session, sp_track *track)
 {
 	return track->is_starred;
@@ -443,6 +476,11 @@ void sp_albumbrowse_release(sp_albumbrowse *alb)
     return;
 }
 
+sp_error sp_albumbrowse_error(sp_albumbrowse *alb)
+{
+    return SP_ERROR_OK;
+}
+
 sp_album * sp_albumbrowse_album(sp_albumbrowse *alb)
 {
     return alb->album;
@@ -503,6 +541,11 @@ void sp_image_add_load_callback(sp_image *image, image_loaded_cb *callback, void
 
 }
 
+void sp_image_remove_load_callback(sp_image *image, image_loaded_cb *callback, void *userdata)
+{
+
+}
+
 /* ************************************
  * Link stubs
  * * *********************************/
@@ -593,13 +636,85 @@ sp_linktype sp_link_type(sp_link *link)
 /* ************************************
  * Playback stubs
  * * *********************************/
+/* Tracks play a tone, as fast as music_delivery takes it. A track that wasn't
+ * prefetched starts STUB_LOAD_LATENCY_MS after being loaded, as if it had to be
+ * fetched first. */
+#define STUB_RATE             44100
+#define STUB_CHANNELS         2
+#define STUB_TRACK_MS         3000
+#define STUB_LOAD_LATENCY_MS  1500 /* longer than the audio fifo */
+#define STUB_DELIVERY_FRAMES  2048
+
+static struct
+{
+	sp_track* loaded;
+	sp_track* prefetched;
+	bool playing;
+	uint64_t startTime_ms;
+	int deliveredFrames;
+	int totalFrames;
+} g_player;
+
+static uint64_t stubTime_ms(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void deliverAudio(sp_session *session)
+{
+	static int16_t frames[STUB_DELIVERY_FRAMES * STUB_CHANNELS];
+	sp_audioformat format = { SP_SAMPLETYPE_INT16_NATIVE_ENDIAN, STUB_RATE, STUB_CHANNELS };
+
+	if (!g_player.loaded || !g_player.playing || stubTime_ms() < g_player.startTime_ms)
+		return;
+
+	while (g_player.deliveredFrames < g_player.totalFrames)
+	{
+		int i, c;
+		int n = g_player.totalFrames - g_player.deliveredFrames;
+		if (n > STUB_DELIVERY_FRAMES)
+			n = STUB_DELIVERY_FRAMES;
+
+		/* 441Hz triangle */
+		for (i = 0; i < n; i++)
+		{
+			int phase = (g_player.deliveredFrames + i) % 100;
+			int16_t sample = (int16_t)(((phase < 50) ? phase : 100 - phase) * 400 - 10000);
+			for (c = 0; c < STUB_CHANNELS; c++)
+				frames[i * STUB_CHANNELS + c] = sample;
+		}
+
+		n = g_config.callbacks->music_delivery(session, &format, frames, n);
+		if (n <= 0)
+			return; /* full, try again later */
+		g_player.deliveredFrames += n;
+	}
+
+	g_player.loaded = NULL;
+	g_config.callbacks->end_of_track(session);
+}
+
 sp_error sp_session_player_load(sp_session *session, sp_track *track)
 {
-	/* callback!*/
+	g_player.loaded = track;
+	g_player.playing = 0;
+	g_player.deliveredFrames = 0;
+	g_player.totalFrames = (track->duration > 0 ? track->duration : STUB_TRACK_MS) * (STUB_RATE / 1000);
+	g_player.startTime_ms = stubTime_ms() + (track == g_player.prefetched ? 0 : STUB_LOAD_LATENCY_MS);
+	g_player.prefetched = NULL;
+	return SP_ERROR_OK;
+}
+
+void sp_session_player_play(sp_session *session, bool play){ g_player.playing = play; }
+void sp_session_player_unload(sp_session *session){ g_player.loaded = NULL; }
+
+sp_error sp_session_player_prefetch(sp_session *session, sp_track *track)
+{
+	g_player.prefetched = track;
 	return SP_ERROR_OK;
 }
-/* playback not supported on stub */
-void sp_session_player_play(sp_session *session, bool play){ /*g_config.callbacks->end_of_track(session);*/}
 
 sp_error sp_track_error(sp_track *track){ return SP_ERROR_OK; }
 
@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LibraryDelta.h"
+#include <map>
+#include <set>
+
+namespace LibSpotify
+{
+
+typedef std::vector<std::vector<const Playlist*> > PlaylistSlots;
+
+static void flatten(const Folder& folder, std::vector<const Folder*>& folders)
+{
+    folders.push_back(&folder);
+    for (FolderContainer::const_iterator f = folder.getFolders().begin(); f != folder.getFolders().end(); f++)
+        flatten(*f, folders);
+}
+
+static void slots(const std::vector<const Folder*>& folders, PlaylistSlots& playlists)
+{
+    playlists.resize(folders.size());
+    for (size_t f = 0; f < folders.size(); f++)
+    {
+        const PlaylistContainer& pls = folders[f]->getPlaylists();
+        for (PlaylistContainer::const_iterator p = pls.begin(); p != pls.end(); p++)
+            playlists[f].push_back(&(*p));
+    }
+}
+
+static bool sameTrack(const Track& a, const Track& b)
+{
+    return a.getLink() == b.getLink() && a == b;
+}
+
+static void diffTracks(const Playlist& from, const Playlist& to, std::vector<LibraryChange>& changes)
+{
+    if (from.getSharedTracks().get() == to.getSharedTracks().get())
+        return;
+
+    const std::deque<Track>& a = from.getTracks();
+    const std::deque<Track>& b = to.getTracks();
+
+    size_t prefix = 0;
+    while (prefix < a.size() && prefix < b.size() && sameTrack(a[prefix], b[prefix]))
+        prefix++;
+    size_t suffix = 0;
+    while (suffix < a.size() - prefix && suffix < b.size() - prefix &&
+           sameTrack(a[a.size() - 1 - suffix], b[b.size() - 1 - suffix]))
+        suffix++;
+
+    size_t removed = a.size() - prefix - suffix;
+    size_t inserted = b.size() - prefix - suffix;
+    if (removed > 0)
+    {
+        LibraryChange change(CHANGE_TRACKS_REMOVED, to.getLink());
+        change.setPosition(0, prefix);
+        change.setCount(removed);
+        changes.push_back(change);
+    }
+    if (inserted > 0)
+    {
+        LibraryChange change(CHANGE_TRACKS_INSERTED, to.getLink());
+        change.setPosition(0, prefix);
+        for (size_t i = prefix; i < prefix + inserted; i++)
+            change.addTrack(b[i]);
+        changes.push_back(change);
+    }
+    if (removed > 0 || inserted > 0)
+        changes.back().setVersion(Playlist::getTracksVersion(b));
+}
+
+bool diffRootFolders(const Folder& from, const Folder& to, std::vector<LibraryChange>& changes)
+{
+    std::vector<const Folder*> fromFolders;
+    std::vector<const Folder*> toFolders;
+    flatten(from, fromFolders);
+    flatten(to, toFolders);
+
+    if (fromFolders.size() != toFolders.size())
+        return false;
+    for (size_t f = 0; f < fromFolders.size(); f++)
+    {
+        if (fromFolders[f]->getName() != toFolders[f]->getName() ||
+            fromFolders[f]->getFolders().size() != toFolders[f]->getFolders().size())
+            return false;
+    }
+
+    /* cur is what the client has, changed along with every change added */
+    PlaylistSlots cur;
+    PlaylistSlots tgt;
+    slots(fromFolders, cur);
+    slots(toFolders, tgt);
+
+    /* removed playlists, and copies beyond as many as there will be. Backwards
+     * so that the positions of the ones before stay put */
+    std::map<std::string, size_t> wanted;
+    for (size_t f = 0; f < tgt.size(); f++)
+        for (size_t i = 0; i < tgt[f].size(); i++)
+            wanted[tgt[f][i]->getLink()]++;
+
+    for (size_t f = 0; f < cur.size(); f++)
+    {
+        std::vector<size_t> removed;
+        for (size_t j = 0; j < cur[f].size(); j++)
+        {
+            size_t& left = wanted[cur[f][j]->getLink()];
+            if (left > 0)
+                left--;
+            else
+                removed.push_back(j);
+        }
+        for (std::vector<size_t>::reverse_iterator j = removed.rbegin(); j != removed.rend(); j++)
+        {
+            LibraryChange change(CHANGE_PLAYLIST_REMOVED, cur[f][*j]->getLink());
+            change.setPosition(f, *j);
+            changes.push_back(change);
+            cur[f].erase(cur[f].begin() + *j);
+        }
+    }
+
+    /* fill in the target in order, everything before (f, i) is in place */
+    for (size_t f = 0; f < tgt.size(); f++)
+    {
+        for (size_t i = 0; i < tgt[f].size(); i++)
+        {
+            const Playlist* want = tgt[f][i];
+
+            if (i >= cur[f].size() || cur[f][i]->getLink() != want->getLink())
+            {
+                /* moved from somewhere not yet in place: later in this folder, a later
+                 * folder, or past the end of an earlier one */
+                size_t fromFolder = 0;
+                size_t fromPos = 0;
+                bool found = false;
+                for (size_t g = 0; g < cur.size() && !found; g++)
+                {
+                    size_t first = (g < f) ? tgt[g].size() : (g == f) ? i + 1 : 0;
+                    for (size_t j = first; j < cur[g].size() && !found; j++)
+                    {
+                        if (cur[g][j]->getLink() == want->getLink())
+                        {
+                            fromFolder = g;
+                            fromPos = j;
+                            found = true;
+                        }
+                    }
+                }
+
+                if (found)
+                {
+                    const Playlist* moved = cur[fromFolder][fromPos];
+                    LibraryChange change(CHANGE_PLAYLIST_MOVED, want->getLink());
+                    change.setPosition(fromFolder, fromPos);
+                    change.setToPosition(f, i);
+                    changes.push_back(change);
+                    cur[fromFolder].erase(cur[fromFolder].begin() + fromPos);
+                    cur[f].insert(cur[f].begin() + i, moved);
+                }
+                else
+                {
+                    LibraryChange change(CHANGE_PLAYLIST_ADDED, want->getLink());
+                    change.setName(want->getName());
+                    change.setPosition(f, i);
+                    changes.push_back(change);
+                    cur[f].insert(cur[f].begin() + i, want);
+                    continue;
+                }
+            }
+
+            if (cur[f][i]->getName() != want->getName())
+            {
+                LibraryChange change(CHANGE_PLAYLIST_RENAMED, want->getLink());
+                change.setName(want->getName());
+                change.setPosition(f, i);
+                changes.push_back(change);
+            }
+        }
+    }
+
+    /* added playlists are sent without tracks, same as in GET_PLAYLISTS_RSP */
+    std::set<std::string> diffed;
+    for (size_t f = 0; f < tgt.size(); f++)
+    {
+        for (size_t i = 0; i < tgt[f].size(); i++)
+        {
+            if (cur[f][i] != tgt[f][i] && diffed.insert(tgt[f][i]->getLink()).second)
+                diffTracks(*cur[f][i], *tgt[f][i], changes);
+        }
+    }
+
+    return true;
+}
+
+} /* namespace LibSpotify */
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBRARYDELTA_H_
+#define LIBRARYDELTA_H_
+
+#include "MediaContainers/Folder.h"
+#include "MediaContainers/LibraryChange.h"
+#include <vector>
+
+namespace LibSpotify
+{
+
+/* The changes that turn one root folder into another, for pushing to clients
+ * instead of the whole tree. Playlists are matched by link; renamed, moved,
+ * added and removed playlists are found first, then the tracks of every link
+ * that is in both are compared from the ends in (a playlist edited in one place
+ * costs the tracks in that place, not the playlist). Track changes apply to every
+ * playlist with that link.
+ * Returns false, and no changes, if the folders themselves differ: they are rare
+ * and the client is better off fetching the tree again. */
+bool diffRootFolders(const Folder& from, const Folder& to, std::vector<LibraryChange>& changes);
+
+} /* namespace LibSpotify */
+#endif /* LIBRARYDELTA_H_ */
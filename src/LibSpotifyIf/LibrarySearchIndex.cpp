@@ -0,0 +1,451 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LibrarySearchIndex.h"
+#include <algorithm>
+#include <queue>
+
+namespace LibSpotify
+{
+
+/* latin-1 supplement and latin extended-a letters folded to what they'd be typed as */
+struct Folding
+{
+    unsigned int first;
+    unsigned int last;
+    const char* folded;
+};
+
+static const Folding latinFoldings[] =
+{
+    { 0xC0, 0xC5, "a" },  { 0xC6, 0xC6, "ae" }, { 0xC7, 0xC7, "c" },  { 0xC8, 0xCB, "e" },
+    { 0xCC, 0xCF, "i" },  { 0xD0, 0xD0, "d" },  { 0xD1, 0xD1, "n" },  { 0xD2, 0xD6, "o" },
+    { 0xD8, 0xD8, "o" },  { 0xD9, 0xDC, "u" },  { 0xDD, 0xDD, "y" },  { 0xDE, 0xDE, "th" },
+    { 0xDF, 0xDF, "ss" }, { 0xE0, 0xE5, "a" },  { 0xE6, 0xE6, "ae" }, { 0xE7, 0xE7, "c" },
+    { 0xE8, 0xEB, "e" },  { 0xEC, 0xEF, "i" },  { 0xF0, 0xF0, "d" },  { 0xF1, 0xF1, "n" },
+    { 0xF2, 0xF6, "o" },  { 0xF8, 0xF8, "o" },  { 0xF9, 0xFC, "u" },  { 0xFD, 0xFD, "y" },
+    { 0xFE, 0xFE, "th" }, { 0xFF, 0xFF, "y" },
+    { 0x100, 0x105, "a" },  { 0x106, 0x10D, "c" },  { 0x10E, 0x111, "d" },  { 0x112, 0x11B, "e" },
+    { 0x11C, 0x123, "g" },  { 0x124, 0x127, "h" },  { 0x128, 0x131, "i" },  { 0x132, 0x133, "ij" },
+    { 0x134, 0x135, "j" },  { 0x136, 0x138, "k" },  { 0x139, 0x142, "l" },  { 0x143, 0x14B, "n" },
+    { 0x14C, 0x151, "o" },  { 0x152, 0x153, "oe" }, { 0x154, 0x159, "r" },  { 0x15A, 0x161, "s" },
+    { 0x162, 0x167, "t" },  { 0x168, 0x173, "u" },  { 0x174, 0x175, "w" },  { 0x176, 0x178, "y" },
+    { 0x179, 0x17E, "z" },  { 0x17F, 0x17F, "s" },
+};
+
+/* next code point of a utf-8 string, broken sequences come out as U+FFFD */
+static unsigned int decodeUtf8(const std::string& str, size_t& pos)
+{
+    unsigned char c = str[pos++];
+    if (c < 0x80)
+        return c;
+
+    unsigned int length = (c >= 0xF0) ? 3 : (c >= 0xE0) ? 2 : (c >= 0xC0) ? 1 : 0;
+    if (length == 0 || c >= 0xF8)
+        return 0xFFFD;
+
+    unsigned int cp = c & (0x3F >> length);
+    for (unsigned int i = 0; i < length; i++)
+    {
+        if (pos >= str.size() || (static_cast<unsigned char>(str[pos]) & 0xC0) != 0x80)
+            return 0xFFFD;
+        cp = (cp << 6) | (static_cast<unsigned char>(str[pos++]) & 0x3F);
+    }
+    return cp;
+}
+
+static void encodeUtf8(unsigned int cp, std::string& out)
+{
+    if (cp < 0x80)
+        out += static_cast<char>(cp);
+    else if (cp < 0x800)
+    {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+/* appends the folded code point to word, false if it separates words */
+static bool foldInto(unsigned int cp, std::string& word)
+{
+    if ((cp >= 'a' && cp <= 'z') || (cp >= '0' && cp <= '9'))
+        word += static_cast<char>(cp);
+    else if (cp >= 'A' && cp <= 'Z')
+        word += static_cast<char>(cp - 'A' + 'a');
+    else if (cp == '\'' || cp == 0x2018 || cp == 0x2019)
+        ; /* "don't" is searched for as "dont" */
+    else if (cp < 0xC0 || cp == 0xD7 || cp == 0xF7)
+        return false;
+    else if (cp <= 0x17F)
+    {
+        for (size_t i = 0; i < sizeof(latinFoldings) / sizeof(latinFoldings[0]); i++)
+        {
+            if (cp >= latinFoldings[i].first && cp <= latinFoldings[i].last)
+            {
+                word += latinFoldings[i].folded;
+                break;
+            }
+        }
+    }
+    else if ((cp >= 0x2000 && cp <= 0x2BFF) || (cp >= 0x3000 && cp <= 0x303F) || cp == 0xFFFD)
+        return false; /* punctuation and symbols */
+    else
+    {
+        /* other scripts are kept as they are, only greek and cyrillic capitals are lowered */
+        if ((cp >= 0x391 && cp <= 0x3A9) || (cp >= 0x410 && cp <= 0x42F))
+            cp += 0x20;
+        else if (cp >= 0x400 && cp <= 0x40F)
+            cp += 0x50;
+        encodeUtf8(cp, word);
+    }
+    return true;
+}
+
+void LibrarySearchIndex::tokenize(const std::string& text, std::vector<std::string>& words)
+{
+    std::string word;
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        if (!foldInto(decodeUtf8(text, pos), word) && !word.empty())
+        {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.empty())
+        words.push_back(word);
+}
+
+static bool startsWith(const std::string& str, const std::string& prefix)
+{
+    return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+LibrarySearchIndex::LibrarySearchIndex() : liveDocs_(0)
+{
+}
+
+LibrarySearchIndex::~LibrarySearchIndex()
+{
+}
+
+void LibrarySearchIndex::insertDoc(const TrackList& list, unsigned int pos, unsigned int refs)
+{
+    DocId id = docs_.size();
+    docs_.push_back(Doc(list, pos, refs));
+    Doc& doc = docs_.back();
+    const Track& track = doc.track();
+    docsByLink_[track.getLink()] = id;
+    liveDocs_++;
+
+    std::vector<std::string> words;
+    tokenize(track.getName(), words);
+    tokenize(track.getAlbum(), words);
+    for (std::vector<Artist>::const_iterator it = track.getArtists().begin(); it != track.getArtists().end(); it++)
+        tokenize(it->getName(), words);
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    doc.terms_.reserve(words.size());
+    for (std::vector<std::string>::const_iterator it = words.begin(); it != words.end(); it++)
+    {
+        Terms::iterator term = terms_.insert(std::make_pair(*it, Postings())).first;
+        term->second.push_back(id); /* ids only grow, so this keeps it sorted */
+        doc.terms_.push_back(term);
+    }
+}
+
+void LibrarySearchIndex::addList(const TrackList& list)
+{
+    if (list.isNull())
+        return;
+
+    std::map<const std::deque<Track>*, IndexedList>::iterator indexed = lists_.find(list.get());
+    if (indexed != lists_.end())
+    {
+        indexed->second.refs_++;
+        return;
+    }
+    lists_.insert(std::make_pair(list.get(), IndexedList(list)));
+
+    for (unsigned int pos = 0; pos < list->size(); pos++)
+    {
+        const std::string& link = (*list)[pos].getLink();
+        if (link.empty())
+            continue;
+
+        std::map<std::string, DocId>::iterator known = docsByLink_.find(link);
+        if (known == docsByLink_.end())
+        {
+            insertDoc(list, pos, 1);
+        }
+        else
+        {
+            /* point at the newest list, so older ones can be released */
+            Doc& doc = docs_[known->second];
+            doc.refs_++;
+            doc.list_ = list;
+            doc.pos_ = pos;
+        }
+    }
+}
+
+static bool lessPostings(const std::map<std::string, std::vector<uint32_t> >::iterator& a,
+                         const std::map<std::string, std::vector<uint32_t> >::iterator& b)
+{
+    return &a->second < &b->second;
+}
+
+static bool samePostings(const std::map<std::string, std::vector<uint32_t> >::iterator& a,
+                         const std::map<std::string, std::vector<uint32_t> >::iterator& b)
+{
+    return &a->second == &b->second;
+}
+
+void LibrarySearchIndex::removeList(const TrackList& list)
+{
+    if (list.isNull())
+        return;
+
+    std::map<const std::deque<Track>*, IndexedList>::iterator indexed = lists_.find(list.get());
+    if (indexed == lists_.end() || --indexed->second.refs_ > 0)
+        return;
+    lists_.erase(indexed);
+
+    std::vector<DocId> removed;
+    std::vector<Terms::iterator> touched;
+    for (unsigned int pos = 0; pos < list->size(); pos++)
+    {
+        std::map<std::string, DocId>::iterator known = docsByLink_.find((*list)[pos].getLink());
+        if (known == docsByLink_.end())
+            continue;
+
+        Doc& doc = docs_[known->second];
+        if (--doc.refs_ == 0)
+        {
+            removed.push_back(known->second);
+            touched.insert(touched.end(), doc.terms_.begin(), doc.terms_.end());
+            docsByLink_.erase(known);
+            doc.list_.reset();
+            doc.terms_.clear();
+        }
+        else if (doc.list_.get() == list.get())
+        {
+            /* still in some other list, but which one isn't known. Keep a copy of just
+             * this track rather than the whole list alive */
+            doc.list_.reset(new std::deque<Track>(1, (*list)[pos]));
+            doc.pos_ = 0;
+        }
+    }
+    if (removed.empty())
+        return;
+
+    /* one pass per touched posting list, however many of its tracks went */
+    std::sort(removed.begin(), removed.end());
+    std::sort(touched.begin(), touched.end(), lessPostings);
+    touched.erase(std::unique(touched.begin(), touched.end(), samePostings), touched.end());
+    for (std::vector<Terms::iterator>::iterator it = touched.begin(); it != touched.end(); it++)
+    {
+        Postings& postings = (*it)->second;
+        Postings::iterator out = postings.begin();
+        for (Postings::const_iterator in = postings.begin(); in != postings.end(); in++)
+        {
+            if (!std::binary_search(removed.begin(), removed.end(), *in))
+                *out++ = *in;
+        }
+        postings.erase(out, postings.end());
+        if (postings.empty())
+            terms_.erase(*it);
+        else
+            Postings(postings).swap(postings); /* shrink */
+    }
+    liveDocs_ -= removed.size();
+
+    /* removed tracks leave holes in the id space, renumber once they dominate */
+    if (docs_.size() > 1024 && docs_.size() > 2 * liveDocs_)
+        compact();
+}
+
+void LibrarySearchIndex::compact()
+{
+    std::vector<Doc> docs;
+    docs.swap(docs_);
+    terms_.clear();
+    docsByLink_.clear();
+    liveDocs_ = 0;
+    docs_.reserve(docs.size() / 2);
+
+    for (std::vector<Doc>::const_iterator it = docs.begin(); it != docs.end(); it++)
+    {
+        if (!it->list_.isNull())
+            insertDoc(it->list_, it->pos_, it->refs_);
+    }
+}
+
+void LibrarySearchIndex::addPlaylist(const Playlist& playlist)
+{
+    addList(playlist.getSharedTracks());
+}
+
+void LibrarySearchIndex::removePlaylist(const Playlist& playlist)
+{
+    removeList(playlist.getSharedTracks());
+}
+
+void LibrarySearchIndex::addFolder(const Folder& folder)
+{
+    for (PlaylistContainer::const_iterator it = folder.getPlaylists().begin(); it != folder.getPlaylists().end(); it++)
+        addPlaylist(*it);
+    for (FolderContainer::const_iterator it = folder.getFolders().begin(); it != folder.getFolders().end(); it++)
+        addFolder(*it);
+}
+
+void LibrarySearchIndex::removeFolder(const Folder& folder)
+{
+    for (PlaylistContainer::const_iterator it = folder.getPlaylists().begin(); it != folder.getPlaylists().end(); it++)
+        removePlaylist(*it);
+    for (FolderContainer::const_iterator it = folder.getFolders().begin(); it != folder.getFolders().end(); it++)
+        removeFolder(*it);
+}
+
+void LibrarySearchIndex::clear()
+{
+    terms_.clear();
+    docs_.clear();
+    docsByLink_.clear();
+    lists_.clear();
+    liveDocs_ = 0;
+}
+
+bool LibrarySearchIndex::matches(const Doc& doc, const std::string& word) const
+{
+    for (std::vector<Terms::iterator>::const_iterator it = doc.terms_.begin(); it != doc.terms_.end(); it++)
+    {
+        if (startsWith((*it)->first, word))
+            return true;
+    }
+    return false;
+}
+
+/* position in one of the posting lists being merged, ordered so the lowest id is on top */
+class PostingCursor
+{
+public:
+    const std::vector<uint32_t>* postings_;
+    size_t pos_;
+
+    PostingCursor(const std::vector<uint32_t>* postings) : postings_(postings), pos_(0) {}
+    uint32_t id() const { return (*postings_)[pos_]; }
+    bool operator<(const PostingCursor& rhs) const { return id() > rhs.id(); }
+};
+
+bool LibrarySearchIndex::search(const std::string& query, unsigned int maxTracks, Playlist& result) const
+{
+    std::vector<std::string> words;
+    tokenize(query, words);
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    if (words.empty() || maxTracks == 0)
+        return false;
+
+    /* walk the word with the fewest postings (summed over every word it is a prefix of)
+     * and check the others against each candidate's own words */
+    size_t driver = 0;
+    size_t driverPostings = 0;
+    for (size_t i = 0; i < words.size(); i++)
+    {
+        size_t postings = 0;
+        for (Terms::const_iterator it = terms_.lower_bound(words[i]); it != terms_.end() && startsWith(it->first, words[i]); it++)
+            postings += it->second.size();
+        if (postings == 0)
+            return false;
+        if (i == 0 || postings < driverPostings)
+        {
+            driver = i;
+            driverPostings = postings;
+        }
+    }
+
+    std::priority_queue<PostingCursor> cursors;
+    for (Terms::const_iterator it = terms_.lower_bound(words[driver]); it != terms_.end() && startsWith(it->first, words[driver]); it++)
+        cursors.push(PostingCursor(&it->second));
+
+    unsigned int found = 0;
+    bool first = true;
+    DocId last = 0;
+    while (!cursors.empty() && found < maxTracks)
+    {
+        PostingCursor cursor = cursors.top();
+        cursors.pop();
+        DocId id = cursor.id();
+        if (++cursor.pos_ < cursor.postings_->size())
+            cursors.push(cursor);
+
+        if (!first && id == last)
+            continue; /* more than one word of the track starts with the driver */
+        first = false;
+        last = id;
+
+        const Doc& doc = docs_[id];
+        bool all = true;
+        for (size_t i = 0; all && i < words.size(); i++)
+            all = (i == driver) || matches(doc, words[i]);
+        if (all)
+        {
+            Track track(doc.track());
+            result.addTrack(track);
+            found++;
+        }
+    }
+    return found > 0;
+}
+
+unsigned int LibrarySearchIndex::getTrackCount() const
+{
+    return liveDocs_;
+}
+
+unsigned int LibrarySearchIndex::getWordCount() const
+{
+    return terms_.size();
+}
+
+} /* namespace LibSpotify */
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBRARYSEARCHINDEX_H_
+#define LIBRARYSEARCHINDEX_H_
+
+#include "MediaContainers/Folder.h"
+#include "MediaContainers/Playlist.h"
+#include "MediaContainers/Track.h"
+#include "Platform/Threads/SharedPtr.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+
+namespace LibSpotify
+{
+
+/* Inverted index over the name, artists and album of every track in the root folder,
+ * so that searching the user's own library doesn't need a round trip to spotify.
+ * Words are case and diacritic folded ("Beyoncé" and "beyonce" are the same word) and
+ * every word of a query matches as a prefix, so results show up while typing.
+ * Tracks are not copied, the index holds on to the playlists' shared track lists and
+ * counts how many times each list and track is indexed, so adding the same list twice
+ * (as the root folder and its rebuilt copy share them) costs nothing.
+ * Only used from the libspotify thread, so no locking. */
+class LibrarySearchIndex
+{
+private:
+    typedef uint32_t DocId;
+    typedef std::vector<DocId> Postings; /* sorted */
+    typedef std::map<std::string, Postings> Terms;
+    typedef Platform::SharedPtr<const std::deque<Track> > TrackList;
+
+    class Doc
+    {
+    public:
+        TrackList list_; /* NULL once removed */
+        unsigned int pos_;
+        unsigned int refs_;
+        std::vector<Terms::iterator> terms_;
+
+        Doc(const TrackList& list, unsigned int pos, unsigned int refs) : list_(list), pos_(pos), refs_(refs) {}
+        const Track& track() const { return (*list_)[pos_]; }
+    };
+
+    class IndexedList
+    {
+    public:
+        TrackList list_;
+        unsigned int refs_;
+
+        IndexedList(const TrackList& list) : list_(list), refs_(1) {}
+    };
+
+    Terms terms_;
+    std::vector<Doc> docs_; /* by id, ids are handed out in increasing order */
+    std::map<std::string, DocId> docsByLink_;
+    std::map<const std::deque<Track>*, IndexedList> lists_;
+    unsigned int liveDocs_;
+
+    void insertDoc(const TrackList& list, unsigned int pos, unsigned int refs);
+    void addList(const TrackList& list);
+    void removeList(const TrackList& list);
+    void compact();
+    bool matches(const Doc& doc, const std::string& word) const;
+
+public:
+    LibrarySearchIndex();
+    ~LibrarySearchIndex();
+
+    void addPlaylist(const Playlist& playlist);
+    void removePlaylist(const Playlist& playlist);
+    void addFolder(const Folder& folder);
+    void removeFolder(const Folder& folder);
+    void clear();
+
+    /* tracks where every word of the query is the start of a word in the track's
+     * name, artists or album, in the order they were indexed. false if none */
+    bool search(const std::string& query, unsigned int maxTracks, Playlist& result) const;
+
+    unsigned int getTrackCount() const;
+    unsigned int getWordCount() const;
+
+    /* splits text into case and diacritic folded words */
+    static void tokenize(const std::string& text, std::vector<std::string>& words);
+};
+
+} /* namespace LibSpotify */
+#endif /* LIBRARYSEARCHINDEX_H_ */
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LibrarySnapshot.h"
+#include "MessageFactory/Message.h"
+#include "MessageFactory/MessageDecoder.h"
+#include "MessageFactory/TlvDefinitions.h"
+#include "Platform/Socket/Socket.h"
+#include "applog.h"
+#include <fstream>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace LibSpotify
+{
+
+/* like Folder::toTlv(), but with the tracks */
+static Tlv* folderTlv(const Folder& folder)
+{
+    TlvContainer* tlv = new TlvContainer(TLV_FOLDER);
+
+    tlv->addTlv(TLV_NAME, folder.getName());
+
+    for (FolderContainer::const_iterator f = folder.getFolders().begin(); f != folder.getFolders().end(); f++)
+    {
+        tlv->addTlv(folderTlv(*f));
+    }
+
+    for (PlaylistContainer::const_iterator p = folder.getPlaylists().begin(); p != folder.getPlaylists().end(); p++)
+    {
+        TlvContainer* playlist = static_cast<TlvContainer*>(p->toTlv());
+        for (std::deque<Track>::const_iterator t = p->getTracks().begin(); t != p->getTracks().end(); t++)
+        {
+            playlist->addTlv(t->toTlv());
+        }
+        tlv->addTlv(playlist);
+    }
+
+    return tlv;
+}
+
+LibrarySnapshot::LibrarySnapshot(const std::string& path) : Platform::Runnable(true, SIZE_SMALL, PRIO_LOW),
+                                                             path_(path),
+                                                             pendingVersion_(0)
+{
+    if(path_.empty())return;
+
+    for(size_t pos = path_.find('/', 1); pos != std::string::npos; pos = path_.find('/', pos + 1))
+        mkdir(path_.substr(0, pos).c_str(), 0755);
+
+    startThread();
+}
+
+LibrarySnapshot::~LibrarySnapshot() { }
+
+void LibrarySnapshot::destroy()
+{
+    if(path_.empty())return;
+
+    cancelThread();
+    mtx_.lock();
+    cond_.signal();
+    mtx_.unlock();
+    joinThread();
+    path_.clear();
+}
+
+void LibrarySnapshot::run()
+{
+    mtx_.lock();
+    for(;;)
+    {
+        if(pending_.get() == NULL)
+        {
+            if(isCancellationPending())break;
+            cond_.wait(mtx_);
+            continue;
+        }
+
+        Platform::SharedPtr<const Folder> root;
+        root.swap(pending_);
+        unsigned int version = pendingVersion_;
+        mtx_.unlock();
+
+        write(*root, version);
+        root.reset(); /* may be the last reference, let go of it outside the lock */
+
+        mtx_.lock();
+    }
+    mtx_.unlock();
+}
+
+std::string LibrarySnapshot::encode(const Folder& root, unsigned int version)
+{
+    Message msg(GET_PLAYLISTS_RSP);
+    msg.setId(version);
+    msg.addTlv(folderTlv(root));
+
+    MessageEncoder* encoder = msg.encode();
+    std::string data(encoder->getBuffer(), encoder->getLength());
+    delete encoder;
+    return data;
+}
+
+bool LibrarySnapshot::load(Folder& root, unsigned int& version)
+{
+    if(path_.empty())return false;
+
+    std::string data;
+    {
+        std::ifstream in(path_.c_str(), std::ios::in | std::ios::binary);
+        if(!in)return false;
+
+        in.seekg(0, std::ios::end);
+        data.resize(in.tellg());
+        in.seekg(0, std::ios::beg);
+        if(!data.empty())in.read(&data[0], data.size());
+        if(in.fail())return false;
+    }
+
+    /* the decoder trusts the message length, make sure it is the file length */
+    const header_t* header = reinterpret_cast<const header_t*>(data.data());
+    if(data.size() < sizeof(header_t) || Ntohl(header->len) != data.size() || Ntohl(header->type) != GET_PLAYLISTS_RSP)
+    {
+        log(LOG_WARN) << "Ignoring bad library snapshot " << path_;
+        return false;
+    }
+
+    MessageDecoder decoder;
+    Message* msg = decoder.decode(reinterpret_cast<const uint8_t*>(data.data()));
+    const TlvContainer* folder = msg ? static_cast<const TlvContainer*>(msg->getTlv(TLV_FOLDER)) : NULL;
+    if(!folder)
+    {
+        log(LOG_WARN) << "Ignoring bad library snapshot " << path_;
+        delete msg;
+        return false;
+    }
+
+    root = Folder(folder);
+    version = msg->getId();
+    mtx_.lock();
+    saved_ = data.substr(sizeof(header_t));
+    mtx_.unlock();
+    delete msg;
+
+    log(LOG_NOTICE) << "Library snapshot version " << version << ", " << data.size() << " bytes, from " << path_;
+    return true;
+}
+
+bool LibrarySnapshot::differs(const Folder& root)
+{
+    std::string data = encode(root, 0);
+    mtx_.lock();
+    bool differs = data.compare(sizeof(header_t), std::string::npos, saved_) != 0;
+    mtx_.unlock();
+    return differs;
+}
+
+void LibrarySnapshot::save(const Platform::SharedPtr<const Folder>& root, unsigned int version)
+{
+    if(path_.empty())return;
+
+    mtx_.lock();
+    pending_ = root;
+    pendingVersion_ = version;
+    cond_.signal();
+    mtx_.unlock();
+}
+
+/* written to a temporary first, so that a crash never leaves a truncated snapshot behind */
+void LibrarySnapshot::write(const Folder& root, unsigned int version)
+{
+    std::string data = encode(root, version);
+    std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size());
+        if(!out)
+        {
+            log(LOG_WARN) << "Could not write " << tmp;
+            out.close();
+            unlink(tmp.c_str());
+            return;
+        }
+    }
+    if(rename(tmp.c_str(), path_.c_str()) != 0)
+    {
+        log(LOG_WARN) << "Could not rename " << tmp;
+        unlink(tmp.c_str());
+        return;
+    }
+    mtx_.lock();
+    saved_ = data.substr(sizeof(header_t));
+    mtx_.unlock();
+    log(LOG_DEBUG) << "Saved library snapshot version " << version << ", " << data.size() << " bytes";
+}
+
+} /* namespace LibSpotify */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBRARYSNAPSHOT_H_
+#define LIBRARYSNAPSHOT_H_
+
+#include "MediaContainers/Folder.h"
+#include "Platform/Threads/Runnable.h"
+#include "Platform/Threads/Mutex.h"
+#include "Platform/Threads/Condition.h"
+#include "Platform/Threads/SharedPtr.h"
+#include <string>
+
+namespace LibSpotify
+{
+
+/* The root folder as it looked last time, so that a restarted server can answer
+ * GET_PLAYLISTS and GET_TRACKS before libspotify has logged in and loaded the
+ * playlist container. The file is a GET_PLAYLISTS response with the tracks of every
+ * playlist included and the root folder version as message id, i.e. the same
+ * tlv format that is sent to clients.
+ * Saving is done by a thread of its own, the version in the file is the one of the
+ * last save and so may be older than what was served before a crash. */
+class LibrarySnapshot : public Platform::Runnable
+{
+private:
+    std::string path_;
+    Platform::Mutex mtx_;
+    Platform::Condition cond_;
+    std::string saved_; /* tlvs last read or written, without the header */
+    Platform::SharedPtr<const Folder> pending_; /* waiting for the writer */
+    unsigned int pendingVersion_;
+
+    static std::string encode(const Folder& root, unsigned int version);
+    void write(const Folder& root, unsigned int version);
+
+public:
+    /* an empty path disables it */
+    LibrarySnapshot(const std::string& path);
+    ~LibrarySnapshot();
+
+    /* false if there is no usable snapshot */
+    bool load(Folder& root, unsigned int& version);
+    /* false if root is what was loaded or saved last */
+    bool differs(const Folder& root);
+    /* encoded and written by the writer thread, if it is still busy with an earlier
+     * save only the latest root is written */
+    void save(const Platform::SharedPtr<const Folder>& root, unsigned int version);
+
+    void run();
+    /* writes what is pending before the writer goes */
+    void destroy();
+};
+
+} /* namespace LibSpotify */
+#endif /* LIBRARYSNAPSHOT_H_ */
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MetadataCache.h"
+#include "applog.h"
+
+namespace LibSpotify
+{
+
+/* rough heap footprint, good enough to keep the caches bounded */
+static size_t memoryUsage(const std::string& str)
+{
+    return str.capacity();
+}
+
+static size_t memoryUsage(const Artist& artist)
+{
+    return sizeof(Artist) + memoryUsage(artist.getName()) + memoryUsage(artist.getLink());
+}
+
+static size_t memoryUsage(const Track& track)
+{
+    size_t bytes = sizeof(Track) +
+                   memoryUsage(track.getName()) + memoryUsage(track.getLink()) +
+                   memoryUsage(track.getAlbum()) + memoryUsage(track.getAlbumLink());
+
+    for(std::vector<Artist>::const_iterator it = track.getArtists().begin(); it != track.getArtists().end(); it++)
+        bytes += memoryUsage(*it);
+
+    return bytes;
+}
+
+static size_t memoryUsage(const Playlist& playlist)
+{
+    size_t bytes = sizeof(Playlist) + memoryUsage(playlist.getName()) + memoryUsage(playlist.getLink());
+
+    for(std::deque<Track>::const_iterator it = playlist.getTracks().begin(); it != playlist.getTracks().end(); it++)
+        bytes += memoryUsage(*it);
+
+    return bytes;
+}
+
+static size_t memoryUsage(const Album& album)
+{
+    return memoryUsage(static_cast<const Playlist&>(album)) + (sizeof(Album) - sizeof(Playlist)) +
+           memoryUsage(album.getReview()) + memoryUsage(album.getArtist());
+}
+
+/************************
+ * MetadataCache::Kind
+ ************************/
+template <class V>
+MetadataCache::Kind<V>::Kind(const std::string& name, size_t maxBytes) :
+                                         lru_(maxBytes),
+                                         hits_(Metrics::Registry::instance().getCounter("cache." + name + ".hits")),
+                                         misses_(Metrics::Registry::instance().getCounter("cache." + name + ".misses")),
+                                         evictions_(Metrics::Registry::instance().getCounter("cache." + name + ".evictions")),
+                                         bytes_(Metrics::Registry::instance().getGauge("cache." + name + ".bytes"))
+{ }
+
+template <class V>
+const V* MetadataCache::Kind<V>::find(const std::string& link)
+{
+    const V* value = lru_.find(link);
+    if(value)
+        hits_.increment();
+    else
+        misses_.increment();
+    return value;
+}
+
+template <class V>
+void MetadataCache::Kind<V>::insert(const std::string& link, const V& value, size_t bytes)
+{
+    if(link.empty())
+        return;
+    evictions_.add(lru_.insert(link, value, bytes));
+    bytes_.set(lru_.cost());
+}
+
+template <class V>
+bool MetadataCache::Kind<V>::erase(const std::string& link)
+{
+    bool erased = lru_.erase(link);
+    bytes_.set(lru_.cost());
+    return erased;
+}
+
+template <class V>
+void MetadataCache::Kind<V>::clear()
+{
+    lru_.clear();
+    bytes_.set(0);
+}
+
+/************************
+ * MetadataCache
+ ************************/
+MetadataCache::MetadataCache(size_t maxBytesPerKind) : playlists_("playlist", maxBytesPerKind),
+                                                       albums_("album", maxBytesPerKind),
+                                                       tracks_("track", maxBytesPerKind),
+                                                       invalidations_(Metrics::Registry::instance().getCounter("cache.invalidations"))
+{ }
+
+MetadataCache::~MetadataCache() { }
+
+const Playlist* MetadataCache::getPlaylist(const std::string& link) { return playlists_.find(link); }
+const Album* MetadataCache::getAlbum(const std::string& link)       { return albums_.find(link); }
+const Track* MetadataCache::getTrack(const std::string& link)       { return tracks_.find(link); }
+bool MetadataCache::hasAlbum(const std::string& link)               { return albums_.lru_.find(link) != NULL; }
+
+void MetadataCache::putPlaylist(const Playlist& playlist) { playlists_.insert(playlist.getLink(), playlist, memoryUsage(playlist)); }
+void MetadataCache::putAlbum(const Album& album)          { albums_.insert(album.getLink(), album, memoryUsage(album)); }
+void MetadataCache::putTrack(const Track& track)          { tracks_.insert(track.getLink(), track, memoryUsage(track)); }
+
+void MetadataCache::invalidate(const std::string& link)
+{
+    if(playlists_.erase(link) | albums_.erase(link) | tracks_.erase(link))
+    {
+        log(LOG_DEBUG) << "Invalidated " << link;
+        invalidations_.increment();
+    }
+}
+
+void MetadataCache::clear()
+{
+    playlists_.clear();
+    albums_.clear();
+    tracks_.clear();
+}
+
+} /* namespace LibSpotify */
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef METADATACACHE_H_
+#define METADATACACHE_H_
+
+#include "MediaContainers/Track.h"
+#include "MediaContainers/Playlist.h"
+#include "MediaContainers/Album.h"
+#include "Metrics/Metrics.h"
+#include "LruCache.h"
+#include <string>
+
+namespace LibSpotify
+{
+
+/* Converted playlists, albums and tracks keyed by link, so that repeated browsing
+ * doesn't have to go through libspotify and rebuild every Track.
+ * Each kind has its own LRU, bounded by the estimated memory of what it holds.
+ * Only used from the libspotify thread, so no locking. */
+class MetadataCache
+{
+private:
+    template <class V>
+    class Kind
+    {
+    public:
+        Util::LruCache<std::string, V> lru_;
+        Metrics::Counter& hits_;
+        Metrics::Counter& misses_;
+        Metrics::Counter& evictions_;
+        Metrics::Gauge& bytes_;
+
+        Kind(const std::string& name, size_t maxBytes);
+        const V* find(const std::string& link);
+        void insert(const std::string& link, const V& value, size_t bytes);
+        bool erase(const std::string& link);
+        void clear();
+    };
+
+    Kind<Playlist> playlists_;
+    Kind<Album> albums_;
+    Kind<Track> tracks_;
+    Metrics::Counter& invalidations_;
+
+public:
+    MetadataCache(size_t maxBytesPerKind);
+    ~MetadataCache();
+
+    /* NULL on miss */
+    const Playlist* getPlaylist(const std::string& link);
+    const Album* getAlbum(const std::string& link);
+    const Track* getTrack(const std::string& link);
+    /* like getAlbum() but not counted as a hit or miss, for looking ahead */
+    bool hasAlbum(const std::string& link);
+
+    void putPlaylist(const Playlist& playlist);
+    void putAlbum(const Album& album);
+    void putTrack(const Track& track);
+
+    /* drops whatever is cached for link, e.g. when libspotify says the playlist changed */
+    void invalidate(const std::string& link);
+    void clear();
+};
+
+} /* namespace LibSpotify */
+#endif /* METADATACACHE_H_ */
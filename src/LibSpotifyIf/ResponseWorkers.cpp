@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ResponseWorkers.h"
+#include "Platform/Utils/Utils.h"
+#include "applog.h"
+#include <stdint.h>
+
+namespace LibSpotify
+{
+
+ResponseJob::ResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId) : subscriber_(subscriber),
+                                                                                                         reqId_(reqId),
+                                                                                                         postTime_(getMonotonicTime_us())
+{
+}
+
+TracksResponseJob::TracksResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const Playlist& playlist) :
+    ResponseJob(subscriber, reqId), playlist_(playlist)
+{
+}
+
+void TracksResponseJob::respond()
+{
+    subscriber_->getTracksResponse(reqId_, playlist_.getTracks());
+}
+
+SearchResponseJob::SearchResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const Playlist& result, const std::string& didYouMean) :
+    ResponseJob(subscriber, reqId), result_(result), didYouMean_(didYouMean)
+{
+}
+
+void SearchResponseJob::respond()
+{
+    subscriber_->genericSearchCallback(reqId_, result_.getTracks(), didYouMean_);
+}
+
+SearchPartResponseJob::SearchPartResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const std::deque<Track>& tracks) :
+    ResponseJob(subscriber, reqId), tracks_(tracks)
+{
+}
+
+void SearchPartResponseJob::respond()
+{
+    subscriber_->genericSearchPartCallback(reqId_, tracks_);
+}
+
+SuggestResponseJob::SuggestResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const std::vector<Suggestion>& suggestions) :
+    ResponseJob(subscriber, reqId), suggestions_(suggestions)
+{
+}
+
+void SuggestResponseJob::respond()
+{
+    subscriber_->searchSuggestResponse(reqId_, suggestions_);
+}
+
+LibrarySubscribeResponseJob::LibrarySubscribeResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, unsigned int epoch, unsigned int version,
+                                                         const std::vector<LibraryChange>& changes, const Platform::SharedPtr<const Folder>& resync) :
+    ResponseJob(subscriber, reqId), epoch_(epoch), version_(version), changes_(changes), resync_(resync)
+{
+}
+
+void LibrarySubscribeResponseJob::respond()
+{
+    subscriber_->librarySubscribeResponse(reqId_, epoch_, version_, changes_, resync_.get());
+}
+
+LibraryChangedIndJob::LibraryChangedIndJob(IMediaInterfaceCallbackSubscriber* subscriber, unsigned int from, unsigned int to,
+                                           const Platform::SharedPtr<const std::vector<LibraryChange> >& changes, const Platform::SharedPtr<const Folder>& resync) :
+    ResponseJob(subscriber, 0), from_(from), to_(to), changes_(changes), resync_(resync)
+{
+}
+
+void LibraryChangedIndJob::respond()
+{
+    static const std::vector<LibraryChange> noChanges;
+    subscriber_->libraryChangedInd(from_, to_, changes_.isNull() ? noChanges : *changes_, resync_.get());
+}
+
+AlbumResponseJob::AlbumResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const Album& album) :
+    ResponseJob(subscriber, reqId), album_(album)
+{
+}
+
+void AlbumResponseJob::respond()
+{
+    subscriber_->getAlbumResponse(reqId_, album_);
+}
+
+ImageResponseJob::ImageResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const Platform::SharedPtr<const std::string>& data) :
+    ResponseJob(subscriber, reqId), data_(data)
+{
+}
+
+void ImageResponseJob::respond()
+{
+    subscriber_->getImageResponse(reqId_, data_->data(), data_->size());
+}
+
+ImageFileResponseJob::ImageFileResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const std::string& path) :
+    ResponseJob(subscriber, reqId), path_(path)
+{
+}
+
+void ImageFileResponseJob::respond()
+{
+    subscriber_->getImageFileResponse(reqId_, path_);
+}
+
+FailedResponseJob::FailedResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, FailureCause_t cause) :
+    ResponseJob(subscriber, reqId), cause_(cause)
+{
+}
+
+void FailedResponseJob::respond()
+{
+    subscriber_->requestFailed(reqId_, cause_);
+}
+
+
+ResponseWorkers::Worker::Worker() : Platform::Runnable(true, SIZE_MEDIUM, PRIO_MID),
+                                    current_(NULL),
+                                    waitTime_(Metrics::Registry::instance().getHistogram("libspotify.responses.wait_us")),
+                                    execTime_(Metrics::Registry::instance().getHistogram("libspotify.responses.exec_us"))
+{
+    startThread();
+}
+
+ResponseWorkers::Worker::~Worker()
+{
+}
+
+void ResponseWorkers::Worker::destroy()
+{
+    cancelThread();
+    mtx_.lock();
+    workCond_.signal();
+    mtx_.unlock();
+    joinThread();
+
+    /* whoever these were for is about to go away as well */
+    while (!jobs_.empty())
+    {
+        delete jobs_.front();
+        jobs_.pop_front();
+    }
+}
+
+void ResponseWorkers::Worker::post(ResponseJob* job)
+{
+    mtx_.lock();
+    jobs_.push_back(job);
+    workCond_.signal();
+    mtx_.unlock();
+}
+
+void ResponseWorkers::Worker::forget(const IMediaInterfaceCallbackSubscriber* subscriber)
+{
+    mtx_.lock();
+    std::deque<ResponseJob*>::iterator it = jobs_.begin();
+    while (it != jobs_.end())
+    {
+        if ((*it)->subscriber_ == subscriber)
+        {
+            delete *it;
+            it = jobs_.erase(it);
+        }
+        else it++;
+    }
+    while (current_ == subscriber)
+        doneCond_.wait(mtx_);
+    mtx_.unlock();
+}
+
+void ResponseWorkers::Worker::run()
+{
+    mtx_.lock();
+    while (isCancellationPending() == false)
+    {
+        if (jobs_.empty())
+        {
+            workCond_.wait(mtx_);
+            continue;
+        }
+
+        ResponseJob* job = jobs_.front();
+        jobs_.pop_front();
+        current_ = job->subscriber_;
+        mtx_.unlock();
+
+        uint64_t startTime = getMonotonicTime_us();
+        waitTime_.record(startTime - job->postTime_);
+        job->respond();
+        execTime_.record(getMonotonicTime_us() - startTime);
+        delete job;
+
+        mtx_.lock();
+        current_ = NULL;
+        doneCond_.signal();
+    }
+    mtx_.unlock();
+}
+
+
+ResponseWorkers::ResponseWorkers(unsigned int numWorkers)
+{
+    for (unsigned int i = 0; i < numWorkers; i++)
+        workers_.push_back(new Worker());
+    log(LOG_DEBUG) << "Started " << numWorkers << " response workers";
+}
+
+ResponseWorkers::~ResponseWorkers()
+{
+    destroy();
+}
+
+void ResponseWorkers::destroy()
+{
+    for (std::vector<Worker*>::iterator it = workers_.begin(); it != workers_.end(); it++)
+    {
+        (*it)->destroy();
+        delete *it;
+    }
+    workers_.clear();
+}
+
+ResponseWorkers::Worker* ResponseWorkers::workerFor(const IMediaInterfaceCallbackSubscriber* subscriber) const
+{
+    /* objects are at least 16 byte aligned, the low bits say nothing */
+    return workers_[(reinterpret_cast<uintptr_t>(subscriber) >> 4) % workers_.size()];
+}
+
+void ResponseWorkers::post(ResponseJob* job)
+{
+    if (workers_.empty())
+    {
+        job->respond();
+        delete job;
+    }
+    else workerFor(job->subscriber_)->post(job);
+}
+
+void ResponseWorkers::forget(const IMediaInterfaceCallbackSubscriber* subscriber)
+{
+    if (!workers_.empty())
+        workerFor(subscriber)->forget(subscriber);
+}
+
+}
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RESPONSEWORKERS_H_
+#define RESPONSEWORKERS_H_
+
+#include "MediaInterface/MediaInterface.h"
+#include "MediaContainers/Playlist.h"
+#include "MediaContainers/Album.h"
+#include "Platform/Threads/Runnable.h"
+#include "Platform/Threads/Condition.h"
+#include "Platform/Threads/Mutex.h"
+#include "Platform/Threads/SharedPtr.h"
+#include "Metrics/Metrics.h"
+#include <deque>
+#include <vector>
+#include <string>
+
+namespace LibSpotify
+{
+
+/* A response whose data has already been pulled out of libspotify, so that
+ * handing it to the subscriber (which builds the tlvs and queues the message)
+ * doesn't need the libspotify thread. */
+class ResponseJob
+{
+public:
+    IMediaInterfaceCallbackSubscriber* subscriber_;
+    MediaInterfaceRequestId reqId_;
+    uint64_t postTime_;
+
+    ResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId);
+    virtual ~ResponseJob() {}
+    virtual void respond() = 0;
+};
+
+class TracksResponseJob : public ResponseJob
+{
+private:
+    Playlist playlist_;
+public:
+    TracksResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const Playlist& playlist);
+    void respond();
+};
+
+class SearchResponseJob : public ResponseJob
+{
+private:
+    Playlist result_;
+    std::string didYouMean_;
+public:
+    SearchResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const Playlist& result, const std::string& didYouMean);
+    void respond();
+};
+
+/* an early part of a search response, see genericSearchPartCallback() */
+class SearchPartResponseJob : public ResponseJob
+{
+private:
+    std::deque<Track> tracks_;
+public:
+    SearchPartResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const std::deque<Track>& tracks);
+    void respond();
+};
+
+class SuggestResponseJob : public ResponseJob
+{
+private:
+    std::vector<Suggestion> suggestions_;
+public:
+    SuggestResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const std::vector<Suggestion>& suggestions);
+    void respond();
+};
+
+class LibrarySubscribeResponseJob : public ResponseJob
+{
+private:
+    unsigned int epoch_;
+    unsigned int version_;
+    std::vector<LibraryChange> changes_;
+    Platform::SharedPtr<const Folder> resync_;
+public:
+    LibrarySubscribeResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, unsigned int epoch, unsigned int version,
+                                const std::vector<LibraryChange>& changes, const Platform::SharedPtr<const Folder>& resync);
+    void respond();
+};
+
+/* posted like a response so that it comes after the subscribe response, the changes are
+ * shared by all the subscribers */
+class LibraryChangedIndJob : public ResponseJob
+{
+private:
+    unsigned int from_;
+    unsigned int to_;
+    Platform::SharedPtr<const std::vector<LibraryChange> > changes_;
+    Platform::SharedPtr<const Folder> resync_;
+public:
+    LibraryChangedIndJob(IMediaInterfaceCallbackSubscriber* subscriber, unsigned int from, unsigned int to,
+                         const Platform::SharedPtr<const std::vector<LibraryChange> >& changes, const Platform::SharedPtr<const Folder>& resync);
+    void respond();
+};
+
+class AlbumResponseJob : public ResponseJob
+{
+private:
+    Album album_;
+public:
+    AlbumResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const Album& album);
+    void respond();
+};
+
+class ImageResponseJob : public ResponseJob
+{
+private:
+    Platform::SharedPtr<const std::string> data_;
+public:
+    ImageResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const Platform::SharedPtr<const std::string>& data);
+    void respond();
+};
+
+class ImageFileResponseJob : public ResponseJob
+{
+private:
+    std::string path_;
+public:
+    ImageFileResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, const std::string& path);
+    void respond();
+};
+
+class FailedResponseJob : public ResponseJob
+{
+private:
+    FailureCause_t cause_;
+public:
+    FailedResponseJob(IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId reqId, FailureCause_t cause);
+    void respond();
+};
+
+/* Runs response jobs off the libspotify thread.
+ * Every subscriber is always served by the same worker, so its responses keep
+ * the order they were posted in. With no workers jobs are run right away by the
+ * poster, as before. */
+class ResponseWorkers
+{
+private:
+    class Worker : public Platform::Runnable
+    {
+    private:
+        Platform::Mutex mtx_;
+        Platform::Condition workCond_;
+        Platform::Condition doneCond_;
+        std::deque<ResponseJob*> jobs_;
+        const IMediaInterfaceCallbackSubscriber* current_;
+        Metrics::Histogram& waitTime_;
+        Metrics::Histogram& execTime_;
+
+    public:
+        Worker();
+        virtual ~Worker();
+
+        void post(ResponseJob* job);
+        void forget(const IMediaInterfaceCallbackSubscriber* subscriber);
+
+        void run();
+        void destroy();
+    };
+
+    std::vector<Worker*> workers_;
+
+    Worker* workerFor(const IMediaInterfaceCallbackSubscriber* subscriber) const;
+
+public:
+    ResponseWorkers(unsigned int numWorkers);
+    ~ResponseWorkers();
+
+    /* takes ownership of job */
+    void post(ResponseJob* job);
+
+    /* drops queued jobs for subscriber and waits for one in progress,
+     * after this nothing will call subscriber any more */
+    void forget(const IMediaInterfaceCallbackSubscriber* subscriber);
+
+    void destroy();
+};
+
+}
+#endif /* RESPONSEWORKERS_H_ */
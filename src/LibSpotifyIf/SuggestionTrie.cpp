@@ -0,0 +1,499 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SuggestionTrie.h"
+#include "LibrarySearchIndex.h"
+#include <algorithm>
+#include <queue>
+#include <map>
+
+namespace LibSpotify
+{
+
+static const uint32_t noNode = 0xFFFFFFFF;
+/* names are found from the start of this many of their first words */
+static const size_t maxWordStarts = 4;
+/* nobody types more than this before picking, longer keys are cut */
+static const size_t maxKeyLength = 64;
+/* a play outweighs any number of times in the library */
+static const uint32_t playScore = 1024;
+
+/* the folded words of a name from word first on, joined by spaces */
+static std::string foldedKey(const std::vector<std::string>& words, size_t first)
+{
+    std::string key;
+    for (size_t i = first; i < words.size() && key.size() < maxKeyLength; i++)
+    {
+        if (i > first)
+            key += ' ';
+        key += words[i];
+    }
+    if (key.size() > maxKeyLength)
+        key.resize(maxKeyLength);
+    return key;
+}
+
+class SuggestionTrie::Key
+{
+public:
+    std::string key_;
+    uint32_t entry_;
+
+    Key(const std::string& key, uint32_t entry) : key_(key), entry_(entry) {}
+    bool operator<(const Key& rhs) const { return key_ < rhs.key_ || (key_ == rhs.key_ && entry_ < rhs.entry_); }
+};
+
+/* what goes into the trie, before the ones that don't fit are dropped */
+class SuggestionCandidate
+{
+public:
+    SuggestionType_t type_;
+    std::string name_;
+    std::string link_;
+    uint32_t score_;
+
+    SuggestionCandidate(SuggestionType_t type, const std::string& name, const std::string& link) : type_(type), name_(name), link_(link), score_(0) {}
+    bool operator<(const SuggestionCandidate& rhs) const { return score_ > rhs.score_; }
+};
+
+/* the same artist or album in many tracks is one candidate, counted once per track */
+class SuggestionCollector
+{
+public:
+    std::vector<SuggestionCandidate> candidates_;
+    std::map<std::string, size_t> byKey_;
+
+    static std::string key(SuggestionType_t type, const std::string& name, const std::string& link)
+    {
+        return std::string(1, static_cast<char>('0' + type)) + (link.empty() ? name : link);
+    }
+
+    void add(SuggestionType_t type, const std::string& name, const std::string& link)
+    {
+        if (name.empty())
+            return;
+        std::pair<std::map<std::string, size_t>::iterator, bool> added = byKey_.insert(std::make_pair(key(type, name, link), candidates_.size()));
+        if (added.second)
+            candidates_.push_back(SuggestionCandidate(type, name, link));
+        if (candidates_[added.first->second].score_ < playScore - 1)
+            candidates_[added.first->second].score_++;
+    }
+
+    void add(const Folder& folder)
+    {
+        for (PlaylistContainer::const_iterator pl = folder.getPlaylists().begin(); pl != folder.getPlaylists().end(); pl++)
+        {
+            add(SUGGESTION_PLAYLIST, pl->getName(), pl->getLink());
+            for (std::deque<Track>::const_iterator track = pl->getTracks().begin(); track != pl->getTracks().end(); track++)
+            {
+                add(SUGGESTION_TRACK, track->getName(), track->getLink());
+                add(SUGGESTION_ALBUM, track->getAlbum(), track->getAlbumLink());
+                for (std::vector<Artist>::const_iterator artist = track->getArtists().begin(); artist != track->getArtists().end(); artist++)
+                    add(SUGGESTION_ARTIST, artist->getName(), artist->getLink());
+            }
+        }
+        for (FolderContainer::const_iterator it = folder.getFolders().begin(); it != folder.getFolders().end(); it++)
+            add(*it);
+    }
+};
+
+SuggestionTrie::SuggestionTrie()
+{
+}
+
+SuggestionTrie::~SuggestionTrie()
+{
+}
+
+std::string SuggestionTrie::entryKey(const Entry& entry) const
+{
+    return SuggestionCollector::key(static_cast<SuggestionType_t>(entry.type_),
+                                    text_.substr(entry.text_, entry.nameLength_),
+                                    text_.substr(entry.text_ + entry.nameLength_, entry.linkLength_));
+}
+
+void SuggestionTrie::getPlays(Plays& plays) const
+{
+    for (std::vector<Entry>::const_iterator it = entries_.begin(); it != entries_.end(); it++)
+    {
+        if (it->score_ >= playScore)
+            plays[entryKey(*it)] = it->score_ & ~(playScore - 1);
+    }
+}
+
+void SuggestionTrie::build(const Folder& root, size_t maxBytes)
+{
+    Plays plays;
+    getPlays(plays);
+    build(root, maxBytes, plays);
+}
+
+void SuggestionTrie::build(const Folder& root, size_t maxBytes, const Plays& plays)
+{
+    SuggestionCollector collector;
+    collector.add(root);
+
+    for (Plays::const_iterator it = plays.begin(); it != plays.end(); it++)
+    {
+        std::map<std::string, size_t>::iterator known = collector.byKey_.find(it->first);
+        if (known != collector.byKey_.end())
+            collector.candidates_[known->second].score_ += it->second;
+    }
+    std::vector<SuggestionCandidate>& candidates = collector.candidates_;
+    std::stable_sort(candidates.begin(), candidates.end());
+
+    std::vector<Node>().swap(nodes_);
+    std::vector<Entry>().swap(entries_);
+    std::vector<uint32_t>().swap(nodeEntries_);
+    std::vector<uint32_t>().swap(entryNodes_);
+    std::string().swap(labels_);
+    std::string().swap(text_);
+
+    /* entries are numbered best first, so entries ending in the same node are already in order */
+    std::vector<Key> keys;
+    size_t bytes = 0;
+    for (std::vector<SuggestionCandidate>::const_iterator it = candidates.begin(); it != candidates.end(); it++)
+    {
+        std::vector<std::string> words;
+        LibrarySearchIndex::tokenize(it->name_, words);
+        if (words.empty())
+            continue;
+
+        size_t wordStarts = std::min(words.size(), maxWordStarts);
+        /* rough footprint, a node and a half per key */
+        bytes += sizeof(Entry) + it->name_.size() + it->link_.size() + wordStarts * (2 * sizeof(Node) + 2 * sizeof(uint32_t) + it->name_.size() / 2);
+        if (bytes > maxBytes)
+            break;
+
+        Entry entry;
+        entry.text_ = text_.size();
+        entry.score_ = it->score_;
+        entry.firstNode_ = 0;
+        entry.nameLength_ = std::min<size_t>(it->name_.size(), 0xFFFF);
+        entry.linkLength_ = std::min<size_t>(it->link_.size(), 0xFFFF);
+        entry.nodes_ = 0;
+        entry.type_ = it->type_;
+        text_.append(it->name_, 0, entry.nameLength_);
+        text_.append(it->link_, 0, entry.linkLength_);
+
+        for (size_t i = 0; i < wordStarts; i++)
+            keys.push_back(Key(foldedKey(words, i), entries_.size()));
+        entries_.push_back(entry);
+    }
+    std::sort(keys.begin(), keys.end());
+
+    Node top;
+    top.label_ = 0;
+    top.labelLength_ = 0;
+    top.parent_ = noNode;
+    nodes_.push_back(top);
+    buildNode(0, keys, 0, keys.size(), 0);
+
+    /* which nodes each entry is in, to find them again when it's played */
+    std::vector<std::pair<uint32_t, uint32_t> > entryNodes;
+    entryNodes.reserve(nodeEntries_.size());
+    for (uint32_t node = 0; node < nodes_.size(); node++)
+    {
+        for (uint32_t i = 0; i < nodes_[node].entries_; i++)
+            entryNodes.push_back(std::make_pair(nodeEntries_[nodes_[node].firstEntry_ + i], node));
+    }
+    std::sort(entryNodes.begin(), entryNodes.end());
+    entryNodes_.reserve(entryNodes.size());
+    for (size_t i = 0; i < entryNodes.size(); i++)
+    {
+        Entry& entry = entries_[entryNodes[i].first];
+        if (entry.nodes_ == 0)
+            entry.firstNode_ = entryNodes_.size();
+        entry.nodes_++;
+        entryNodes_.push_back(entryNodes[i].second);
+    }
+
+    std::vector<Node>(nodes_).swap(nodes_);
+    std::vector<Entry>(entries_).swap(entries_);
+    std::vector<uint32_t>(nodeEntries_).swap(nodeEntries_);
+    std::string(labels_).swap(labels_);
+    std::string(text_).swap(text_);
+}
+
+/* keys[first, last) all start with the labels from the root down to node, depth bytes in total */
+void SuggestionTrie::buildNode(uint32_t node, std::vector<Key>& keys, size_t first, size_t last, size_t depth)
+{
+    size_t pos = first;
+    nodes_[node].firstEntry_ = nodeEntries_.size();
+    for (; pos < last && keys[pos].key_.size() == depth; pos++)
+        nodeEntries_.push_back(keys[pos].entry_);
+    nodes_[node].entries_ = pos - first;
+    nodes_[node].maxScore_ = (pos > first) ? entries_[keys[first].entry_].score_ : 0;
+
+    /* one child per distinct next byte, labelled with what its keys have in common */
+    std::vector<std::pair<size_t, size_t> > groups;
+    while (pos < last)
+    {
+        size_t end = pos + 1;
+        while (end < last && keys[end].key_[depth] == keys[pos].key_[depth])
+            end++;
+        groups.push_back(std::make_pair(pos, end));
+        pos = end;
+    }
+
+    uint32_t firstChild = nodes_.size();
+    nodes_[node].firstChild_ = firstChild;
+    nodes_[node].children_ = groups.size();
+    nodes_.resize(nodes_.size() + groups.size());
+
+    std::vector<size_t> labelLengths(groups.size());
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        const std::string& low = keys[groups[g].first].key_;
+        const std::string& high = keys[groups[g].second - 1].key_;
+        size_t length = 1;
+        while (depth + length < low.size() && depth + length < high.size() && low[depth + length] == high[depth + length])
+            length++;
+
+        Node& child = nodes_[firstChild + g];
+        child.label_ = labels_.size();
+        child.labelLength_ = length;
+        child.parent_ = node;
+        labels_.append(low, depth, length);
+        labelLengths[g] = length;
+    }
+
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        buildNode(firstChild + g, keys, groups[g].first, groups[g].second, depth + labelLengths[g]);
+        nodes_[node].maxScore_ = std::max(nodes_[node].maxScore_, nodes_[firstChild + g].maxScore_);
+    }
+}
+
+/* the node where key ends. Unless exact, key may end inside the label of the node */
+uint32_t SuggestionTrie::findNode(const std::string& key, bool exact) const
+{
+    if (nodes_.empty())
+        return noNode;
+
+    uint32_t node = 0;
+    size_t pos = 0;
+    while (pos < key.size())
+    {
+        const Node& parent = nodes_[node];
+        uint32_t low = parent.firstChild_;
+        uint32_t high = parent.firstChild_ + parent.children_;
+        while (low < high)
+        {
+            uint32_t mid = (low + high) / 2;
+            if (static_cast<unsigned char>(labels_[nodes_[mid].label_]) < static_cast<unsigned char>(key[pos]))
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        if (low == parent.firstChild_ + parent.children_ || labels_[nodes_[low].label_] != key[pos])
+            return noNode;
+
+        const Node& child = nodes_[low];
+        size_t length = std::min<size_t>(child.labelLength_, key.size() - pos);
+        if (labels_.compare(child.label_, length, key, pos, length) != 0)
+            return noNode;
+        if (length < child.labelLength_ && exact)
+            return noNode;
+        pos += length;
+        node = low;
+    }
+    return node;
+}
+
+uint32_t SuggestionTrie::findEntry(SuggestionType_t type, const std::string& name, const std::string& link) const
+{
+    std::vector<std::string> words;
+    LibrarySearchIndex::tokenize(name, words);
+    if (words.empty())
+        return noNode;
+    uint32_t node = findNode(foldedKey(words, 0), true);
+    if (node == noNode)
+        return noNode;
+
+    for (uint32_t i = 0; i < nodes_[node].entries_; i++)
+    {
+        const Entry& entry = entries_[nodeEntries_[nodes_[node].firstEntry_ + i]];
+        if (entry.type_ == type &&
+            (link.empty() ? text_.compare(entry.text_, entry.nameLength_, name) : text_.compare(entry.text_ + entry.nameLength_, entry.linkLength_, link)) == 0)
+            return nodeEntries_[nodes_[node].firstEntry_ + i];
+    }
+    return noNode;
+}
+
+void SuggestionTrie::played(SuggestionType_t type, const std::string& name, const std::string& link)
+{
+    uint32_t id = findEntry(type, name, link);
+    if (id == noNode)
+        return; /* not in the library, or didn't fit */
+
+    if (entries_[id].score_ > 0xFFFFFFFF - playScore)
+        return;
+    raise(id, entries_[id].score_ + playScore);
+}
+
+void SuggestionTrie::takePlays(const SuggestionTrie& from)
+{
+    for (std::vector<Entry>::const_iterator it = from.entries_.begin(); it != from.entries_.end(); it++)
+    {
+        if (it->score_ < playScore)
+            continue;
+
+        uint32_t id = findEntry(static_cast<SuggestionType_t>(it->type_),
+                                from.text_.substr(it->text_, it->nameLength_),
+                                from.text_.substr(it->text_ + it->nameLength_, it->linkLength_));
+        if (id == noNode)
+            continue;
+
+        uint32_t plays = it->score_ & ~(playScore - 1);
+        uint32_t seen = entries_[id].score_ & ~(playScore - 1);
+        if (plays > seen && entries_[id].score_ <= 0xFFFFFFFF - (plays - seen))
+            raise(id, entries_[id].score_ + plays - seen);
+    }
+}
+
+void SuggestionTrie::swap(SuggestionTrie& other)
+{
+    nodes_.swap(other.nodes_);
+    entries_.swap(other.entries_);
+    nodeEntries_.swap(other.nodeEntries_);
+    entryNodes_.swap(other.entryNodes_);
+    labels_.swap(other.labels_);
+    text_.swap(other.text_);
+}
+
+/* a higher score for entry id, which then moves up in every node it is in */
+void SuggestionTrie::raise(uint32_t id, uint32_t score)
+{
+    Entry& entry = entries_[id];
+    entry.score_ = score;
+
+    for (uint32_t n = 0; n < entry.nodes_; n++)
+    {
+        /* move it forward among the entries of the node, then tell the nodes above */
+        uint32_t at = entryNodes_[entry.firstNode_ + n];
+        uint32_t* first = &nodeEntries_[nodes_[at].firstEntry_];
+        uint32_t* pos = std::find(first, first + nodes_[at].entries_, id);
+        for (; pos > first && entries_[*(pos - 1)].score_ < entry.score_; pos--)
+            std::swap(*pos, *(pos - 1));
+
+        for (; at != noNode && nodes_[at].maxScore_ < entry.score_; at = nodes_[at].parent_)
+            nodes_[at].maxScore_ = entry.score_;
+    }
+}
+
+void SuggestionTrie::played(const Track& track)
+{
+    played(SUGGESTION_TRACK, track.getName(), track.getLink());
+    played(SUGGESTION_ALBUM, track.getAlbum(), track.getAlbumLink());
+    for (std::vector<Artist>::const_iterator it = track.getArtists().begin(); it != track.getArtists().end(); it++)
+        played(SUGGESTION_ARTIST, it->getName(), it->getLink());
+}
+
+/* a node still to be looked into, or the next entry of a node, ordered best first */
+class SuggestionCursor
+{
+public:
+    uint32_t score_;
+    uint32_t node_;
+    uint32_t entry_; /* index among the node's entries, or noNode for the node itself */
+    uint32_t id_;    /* of that entry */
+
+    SuggestionCursor(uint32_t score, uint32_t node, uint32_t entry, uint32_t id) : score_(score), node_(node), entry_(entry), id_(id) {}
+    bool operator<(const SuggestionCursor& rhs) const
+    {
+        if (score_ != rhs.score_)
+            return score_ < rhs.score_;
+        if ((entry_ == noNode) != (rhs.entry_ == noNode))
+            return entry_ == noNode; /* entries before nodes of the same score */
+        if (id_ != rhs.id_)
+            return id_ > rhs.id_; /* then in the order they were found in the library */
+        return node_ > rhs.node_;
+    }
+};
+
+void SuggestionTrie::suggest(const std::string& prefix, unsigned int max, std::vector<Suggestion>& result) const
+{
+    std::vector<std::string> words;
+    LibrarySearchIndex::tokenize(prefix, words);
+    uint32_t start = findNode(foldedKey(words, 0), false);
+    if (start == noNode || max == 0)
+        return;
+
+    std::vector<uint32_t> found;
+    std::priority_queue<SuggestionCursor> cursors;
+    cursors.push(SuggestionCursor(nodes_[start].maxScore_, start, noNode, noNode));
+    while (!cursors.empty() && found.size() < max)
+    {
+        SuggestionCursor cursor = cursors.top();
+        cursors.pop();
+        const Node& node = nodes_[cursor.node_];
+
+        if (cursor.entry_ == noNode)
+        {
+            if (node.entries_ > 0)
+            {
+                uint32_t first = nodeEntries_[node.firstEntry_];
+                cursors.push(SuggestionCursor(entries_[first].score_, cursor.node_, 0, first));
+            }
+            for (uint32_t child = node.firstChild_; child < node.firstChild_ + node.children_; child++)
+                cursors.push(SuggestionCursor(nodes_[child].maxScore_, child, noNode, noNode));
+            continue;
+        }
+
+        uint32_t id = cursor.id_;
+        if (cursor.entry_ + 1 < node.entries_)
+        {
+            uint32_t next = nodeEntries_[node.firstEntry_ + cursor.entry_ + 1];
+            cursors.push(SuggestionCursor(entries_[next].score_, cursor.node_, cursor.entry_ + 1, next));
+        }
+
+        /* reached from more than one of its word starts */
+        if (std::find(found.begin(), found.end(), id) != found.end())
+            continue;
+        found.push_back(id);
+
+        const Entry& entry = entries_[id];
+        result.push_back(Suggestion(static_cast<SuggestionType_t>(entry.type_),
+                                    text_.substr(entry.text_, entry.nameLength_),
+                                    text_.substr(entry.text_ + entry.nameLength_, entry.linkLength_)));
+    }
+}
+
+unsigned int SuggestionTrie::getEntryCount() const
+{
+    return entries_.size();
+}
+
+size_t SuggestionTrie::getBytes() const
+{
+    return nodes_.capacity() * sizeof(Node) + entries_.capacity() * sizeof(Entry) +
+           (nodeEntries_.capacity() + entryNodes_.capacity()) * sizeof(uint32_t) +
+           labels_.capacity() + text_.capacity();
+}
+
+} /* namespace LibSpotify */
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SUGGESTIONTRIE_H_
+#define SUGGESTIONTRIE_H_
+
+#include "MediaContainers/Folder.h"
+#include "MediaContainers/Track.h"
+#include "MediaContainers/Suggestion.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+namespace LibSpotify
+{
+
+/* Type-ahead completions for the names of the tracks, artists, albums and playlists in
+ * the root folder. Names are folded like LibrarySearchIndex does and are found from the
+ * start of any of their first words, "supernova" finds "Champagne Supernova".
+ * It is a radix trie in flat arrays, all text in one buffer, and every node knows the
+ * best score below it so the top few completions are found without visiting the rest.
+ * Score is the number of plays, then the number of times it is in the library.
+ * Rebuilt when the root folder changes, plays are counted in place.
+ * Not thread safe, a trie is built by one thread and then handed over (see SuggestionTrieBuilder) */
+class SuggestionTrie
+{
+private:
+    class Node
+    {
+    public:
+        uint32_t label_;      /* in labels_ */
+        uint32_t firstChild_; /* children are consecutive and sorted on the first byte of their label */
+        uint32_t parent_;
+        uint32_t firstEntry_; /* in nodeEntries_, best score first */
+        uint32_t entries_;
+        uint32_t maxScore_;   /* of the entries in this node and below */
+        uint16_t children_;
+        uint8_t labelLength_;
+    };
+
+    class Entry
+    {
+    public:
+        uint32_t text_;       /* name followed by link, in text_ */
+        uint32_t score_;
+        uint32_t firstNode_;  /* in entryNodes_, the nodes that hold this entry */
+        uint16_t nameLength_;
+        uint16_t linkLength_;
+        uint8_t nodes_;
+        uint8_t type_;        /* SuggestionType_t */
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> nodeEntries_;
+    std::vector<uint32_t> entryNodes_;
+    std::string labels_;
+    std::string text_;
+
+    class Key;
+    void buildNode(uint32_t node, std::vector<Key>& keys, size_t first, size_t last, size_t depth);
+    uint32_t findNode(const std::string& key, bool exact) const;
+    uint32_t findEntry(SuggestionType_t type, const std::string& name, const std::string& link) const;
+    void raise(uint32_t id, uint32_t score);
+    void played(SuggestionType_t type, const std::string& name, const std::string& link);
+    std::string entryKey(const Entry& entry) const;
+
+public:
+    /* the score the plays of each name add up to, by entry key */
+    typedef std::map<std::string, uint32_t> Plays;
+
+    SuggestionTrie();
+    ~SuggestionTrie();
+
+    /* replaces the contents with what is in root, best scored first until maxBytes is used.
+     * Plays counted so far are kept for what is still there */
+    void build(const Folder& root, size_t maxBytes);
+    /* the same, with the plays of another trie as taken by getPlays() */
+    void build(const Folder& root, size_t maxBytes, const Plays& plays);
+    void getPlays(Plays& plays) const;
+    /* plays counted by from that this one hasn't seen, i.e. since it was built from getPlays() */
+    void takePlays(const SuggestionTrie& from);
+    void swap(SuggestionTrie& other);
+    /* counts a play of the track, its artists and its album */
+    void played(const Track& track);
+    /* up to max completions of prefix, best first. An empty prefix gives the best overall */
+    void suggest(const std::string& prefix, unsigned int max, std::vector<Suggestion>& result) const;
+
+    unsigned int getEntryCount() const;
+    size_t getBytes() const;
+};
+
+} /* namespace LibSpotify */
+#endif /* SUGGESTIONTRIE_H_ */
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "SuggestionTrieBuilder.h"
+#include "Platform/Utils/Utils.h"
+#include "applog.h"
+
+namespace LibSpotify
+{
+
+SuggestionTrieBuilder::SuggestionTrieBuilder(Listener& listener) : Platform::Runnable(true, SIZE_SMALL, PRIO_LOW),
+                                                                   listener_(listener),
+                                                                   pendingMaxBytes_(0),
+                                                                   built_(NULL)
+{
+    startThread();
+}
+
+SuggestionTrieBuilder::~SuggestionTrieBuilder()
+{
+    delete built_;
+}
+
+void SuggestionTrieBuilder::destroy()
+{
+    cancelThread();
+    mtx_.lock();
+    cond_.signal();
+    mtx_.unlock();
+    joinThread();
+}
+
+void SuggestionTrieBuilder::build(const Platform::SharedPtr<const Folder>& root, size_t maxBytes, const SuggestionTrie::Plays& plays)
+{
+    mtx_.lock();
+    pending_ = root;
+    pendingMaxBytes_ = maxBytes;
+    pendingPlays_ = plays;
+    cond_.signal();
+    mtx_.unlock();
+}
+
+SuggestionTrie* SuggestionTrieBuilder::takeBuilt()
+{
+    mtx_.lock();
+    SuggestionTrie* trie = built_;
+    built_ = NULL;
+    mtx_.unlock();
+    return trie;
+}
+
+void SuggestionTrieBuilder::run()
+{
+    mtx_.lock();
+    while (isCancellationPending() == false)
+    {
+        if (pending_.isNull())
+        {
+            cond_.wait(mtx_);
+            continue;
+        }
+
+        Platform::SharedPtr<const Folder> root;
+        root.swap(pending_);
+        size_t maxBytes = pendingMaxBytes_;
+        SuggestionTrie::Plays plays;
+        plays.swap(pendingPlays_);
+        mtx_.unlock();
+
+        uint64_t startTime = getMonotonicTime_us();
+        SuggestionTrie* trie = new SuggestionTrie;
+        trie->build(*root, maxBytes, plays);
+        root.reset();
+        log(LOG_DEBUG) << "Suggestion trie built with " << trie->getEntryCount() << " names, " << trie->getBytes() << " bytes, in "
+                       << (getMonotonicTime_us() - startTime) << "us";
+
+        mtx_.lock();
+        /* one that was never taken is out of date now */
+        delete built_;
+        built_ = trie;
+        mtx_.unlock();
+        listener_.suggestionTrieBuilt();
+        mtx_.lock();
+    }
+    mtx_.unlock();
+}
+
+} /* namespace LibSpotify */
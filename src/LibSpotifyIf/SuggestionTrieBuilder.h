@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SUGGESTIONTRIEBUILDER_H_
+#define SUGGESTIONTRIEBUILDER_H_
+
+#include "SuggestionTrie.h"
+#include "Platform/Threads/Runnable.h"
+#include "Platform/Threads/Mutex.h"
+#include "Platform/Threads/Condition.h"
+#include "Platform/Threads/SharedPtr.h"
+
+namespace LibSpotify
+{
+
+/* Builds suggestion tries on a thread of its own, a large library takes most of a second.
+ * The owner hands over a root folder snapshot and the plays counted so far, and is told
+ * when a trie is ready to be taken. If the root folder changes again while a build is
+ * running, only the latest one is built next. */
+class SuggestionTrieBuilder : public Platform::Runnable
+{
+public:
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+        /* called on the builder thread, takeBuilt() has something now */
+        virtual void suggestionTrieBuilt() = 0;
+    };
+
+private:
+    Listener& listener_;
+    Platform::Mutex mtx_;
+    Platform::Condition cond_;
+    Platform::SharedPtr<const Folder> pending_;
+    size_t pendingMaxBytes_;
+    SuggestionTrie::Plays pendingPlays_;
+    SuggestionTrie* built_;
+
+public:
+    SuggestionTrieBuilder(Listener& listener);
+    ~SuggestionTrieBuilder();
+
+    void build(const Platform::SharedPtr<const Folder>& root, size_t maxBytes, const SuggestionTrie::Plays& plays);
+    /* the latest trie built, NULL if there is none since last time. The caller owns it */
+    SuggestionTrie* takeBuilt();
+
+    void run();
+    void destroy();
+};
+
+} /* namespace LibSpotify */
+#endif /* SUGGESTIONTRIEBUILDER_H_ */
@@ -41,7 +41,7 @@ AudioEndpointRemotePeer::~AudioEndpointRemotePeer()
 
 void AudioEndpointRemotePeer::processMessage(const Message* msg)
 {
-    log(LOG_NOTICE) << *(msg);
+    log(LOG_DEBUG) << *(msg);
 
     switch(msg->getType())
     {
@@ -30,7 +30,9 @@
 #include "applog.h"
 
 RemoteMediaInterface::RemoteMediaInterface(Messenger& m) : messenger_(m),
-                                                           reqId(0)
+                                                           reqId(0),
+                                                           libraryEpoch_(0),
+                                                           libraryVersion_(0)
 {
     messenger_.addSubscriber(this);
 }
@@ -53,13 +55,26 @@ void RemoteMediaInterface::connectionState( bool up )
         messenger_.queueMessage( hello, reqId++ ); /* we should make sure this goes out first, ahead of any old pending messages from an old connection */
     }
 
-    callbackSubscriberMtx_.lock();
-    for( std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-            it != callbackSubscriberList_.end(); it++)
+    CallbackSubscribers subscribers = getCallbackSubscribers();
+    for( MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+            it != subscribers->end(); it++)
     {
         (*it)->connectionState( up );
     }
-    callbackSubscriberMtx_.unlock();
+}
+
+/* the changes, or the root folder if there is one to resync with */
+static void getLibraryChanges( const Message* msg, std::vector<LibraryChange>& changes, Folder*& resync )
+{
+    resync = NULL;
+    for ( TlvContainer::const_iterator it = msg->getTlvRoot()->begin();
+            it != msg->getTlvRoot()->end(); it++ )
+    {
+        if ( (*it)->getType() == TLV_LIBRARY_CHANGE )
+            changes.push_back( LibraryChange( (const TlvContainer*)(*it) ) );
+        else if ( (*it)->getType() == TLV_FOLDER && resync == NULL )
+            resync = new Folder( (const TlvContainer*)(*it) );
+    }
 }
 
 void RemoteMediaInterface::doRequest( Message* msg, unsigned int mediaReqId, IMediaInterfaceCallbackSubscriber* subscriber )
@@ -90,31 +105,49 @@ void RemoteMediaInterface::receivedMessage( Message* msg )
 
             const TlvContainer* trackTlv = (const TlvContainer*) msg->getTlv(TLV_TRACK);
 
-            callbackSubscriberMtx_.lock();
+            CallbackSubscribers subscribers = getCallbackSubscribers();
             if ( trackTlv != NULL )
             {
                 int progress = 0;
                 tlv = (const IntTlv*) msg->getTlv(TLV_PROGRESS);
                 if ( tlv ) progress = tlv->getVal();
 
-                for( std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-                     it != callbackSubscriberList_.end(); it++)
+                for( MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+                     it != subscribers->end(); it++)
                 {
                     (*it)->statusUpdateInd( playbackState, repeatState, shuffleState, Track( trackTlv ), progress );
                 }
             }
             else
             {
-                for( std::set<IMediaInterfaceCallbackSubscriber*>::iterator it = callbackSubscriberList_.begin();
-                     it != callbackSubscriberList_.end(); it++)
+                for( MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+                     it != subscribers->end(); it++)
                 {
                     (*it)->statusUpdateInd( playbackState, repeatState, shuffleState );
                 }
             }
-            callbackSubscriberMtx_.unlock();
         }
         break;
 
+        case LIBRARY_CHANGED_IND:
+        {
+            const IntTlv* version = (const IntTlv*) msg->getTlv(TLV_LIBRARY_VERSION);
+            unsigned int from = libraryVersion_;
+            if ( version ) libraryVersion_ = version->getVal();
+
+            std::vector<LibraryChange> changes;
+            Folder* resync;
+            getLibraryChanges( msg, changes, resync );
+
+            CallbackSubscribers subscribers = getCallbackSubscribers();
+            for( MediaInterfaceCallbackSubscriberSet::const_iterator it = subscribers->begin();
+                 it != subscribers->end(); it++)
+            {
+                (*it)->libraryChangedInd( from, libraryVersion_, changes, resync );
+            }
+            delete resync;
+        }
+        break;
 
         default:
             break;
@@ -128,8 +161,10 @@ void RemoteMediaInterface::receivedResponse( Message* rsp, Message* req )
     {
         log(LOG_DEBUG) << *rsp;
         PendingRequest mediaReq = it->second;
+        const IntTlv* more = (const IntTlv*) rsp->getTlv( TLV_MORE_TO_COME );
+        bool lastPart = ( more == NULL || more->getVal() == 0 );
 
-        callbackSubscriberMtx_.lock();
+        CallbackSubscribers subscribers = getCallbackSubscribers();
         /* todo verify subscriber still exists */
 
         switch( rsp->getType() )
@@ -218,15 +253,51 @@ void RemoteMediaInterface::receivedResponse( Message* rsp, Message* req )
                     }
                 }
 
-                mediaReq.subscriber->genericSearchCallback( mediaReq.mediaReqId, tracks, "" );
+                if ( lastPart )
+                    mediaReq.subscriber->genericSearchCallback( mediaReq.mediaReqId, tracks, "" );
+                else
+                    mediaReq.subscriber->genericSearchPartCallback( mediaReq.mediaReqId, tracks );
+            }
+            break;
+
+            case SEARCH_SUGGEST_RSP:
+            {
+                std::vector<Suggestion> suggestions;
+
+                for ( TlvContainer::const_iterator it = rsp->getTlvRoot()->begin();
+                        it != rsp->getTlvRoot()->end(); it++ )
+                {
+                    if ( (*it)->getType() == TLV_SUGGESTION )
+                    {
+                        suggestions.push_back( Suggestion( (const TlvContainer*)(*it) ) );
+                    }
+                }
+
+                mediaReq.subscriber->searchSuggestResponse( mediaReq.mediaReqId, suggestions );
+            }
+            break;
+
+            case LIBRARY_SUBSCRIBE_RSP:
+            {
+                const IntTlv* epoch = (const IntTlv*) rsp->getTlv(TLV_LIBRARY_EPOCH);
+                const IntTlv* version = (const IntTlv*) rsp->getTlv(TLV_LIBRARY_VERSION);
+                libraryEpoch_ = epoch ? epoch->getVal() : 0;
+                if ( version ) libraryVersion_ = version->getVal();
+
+                std::vector<LibraryChange> changes;
+                Folder* resync;
+                getLibraryChanges( rsp, changes, resync );
+
+                mediaReq.subscriber->librarySubscribeResponse( mediaReq.mediaReqId, libraryEpoch_, libraryVersion_, changes, resync );
+                delete resync;
             }
             break;
 
             default:
                 break;
         }
-        callbackSubscriberMtx_.unlock();
-        pendingReqsMap.erase( it );
+        if ( lastPart )
+            pendingReqsMap.erase( it );
     }
     else
     {
@@ -335,6 +406,22 @@ void RemoteMediaInterface::search( std::string query, IMediaInterfaceCallbackSub
     doRequest( msg, mediaReqId, subscriber );
 }
 
+void RemoteMediaInterface::suggest( std::string prefix, unsigned int maxSuggestions, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId mediaReqId )
+{
+    Message* msg = new Message( SEARCH_SUGGEST_REQ );
+    msg->addTlv( TLV_SEARCH_QUERY, prefix );
+    msg->addTlv( TLV_SEARCH_COUNT, maxSuggestions );
+    doRequest( msg, mediaReqId, subscriber );
+}
+
+void RemoteMediaInterface::subscribeLibrary( unsigned int epoch, unsigned int version, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId mediaReqId )
+{
+    Message* msg = new Message( LIBRARY_SUBSCRIBE_REQ );
+    msg->addTlv( TLV_LIBRARY_EPOCH, epoch );
+    msg->addTlv( TLV_LIBRARY_VERSION, version );
+    doRequest( msg, mediaReqId, subscriber );
+}
+
 void RemoteMediaInterface::addAudio()
 {
     Message* msg = new Message( ADD_AUDIO_ENDPOINT_REQ );
@@ -41,6 +41,10 @@ class RemoteMediaInterface : public IMessageSubscriber, public MediaInterface
 private:
     Messenger& messenger_;
     unsigned int reqId;
+    /* version of the root folder the last library response or indication brought,
+     * and the epoch of the server it came from */
+    unsigned int libraryEpoch_;
+    unsigned int libraryVersion_;
 
     class PendingRequest
     {
@@ -79,6 +83,8 @@ public:
     virtual void play( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId mediaReqId );
     virtual void getAlbum( std::string link, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId mediaReqId );
     virtual void search( std::string query, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId mediaReqId );
+    virtual void suggest( std::string prefix, unsigned int maxSuggestions, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId mediaReqId );
+    virtual void subscribeLibrary( unsigned int epoch, unsigned int version, IMediaInterfaceCallbackSubscriber* subscriber, MediaInterfaceRequestId mediaReqId );
     virtual void addAudio();
 
 };
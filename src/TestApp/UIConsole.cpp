@@ -27,6 +27,7 @@
 
 #include "UIConsole.h"
 #include "applog.h"
+#include "Tracing/Tracer.h"
 
 static void printFolder( const Folder& f, int indent );
 static void printTracks( const std::deque<Track>& tracks );
@@ -69,7 +70,8 @@ void UIConsole::run()
                      "'x' play\n"
                      "'c' pause\n"
                      "'v' next\n"
-                     "'e' toggle shuffle\n" << std::endl;
+                     "'e' toggle shuffle\n"
+                     "'j' dump request trace\n" << std::endl;
 
         c = getchar();
 
@@ -174,6 +176,12 @@ void UIConsole::run()
             break;
         }
 
+        case 'j':
+        {
+            Tracing::Tracer::instance().exportChromeTrace();
+            break;
+        }
+
         case 'q':
             cancelThread();
             continue;
@@ -27,66 +27,66 @@
 
 /*
  *
- *      Very simple wrapper for deque, basically pops the item from the other end when pushing.
+ *      Fixed size ring, pushing onto a full one drops the item at the other end.
+ *      Storage is allocated once up front.
  */
 
 #ifndef CIRCULARQUEUE_H_
 #define CIRCULARQUEUE_H_
 
-#include <deque>
+#include <vector>
 namespace Util
 {
 
 template <class T>
 class CircularQueue
 {
-    typedef typename std::deque<T> QueueType;
     typedef unsigned int SizeType;
-    typedef typename std::deque<T>::iterator iterator;
-    typedef typename std::deque<T>::const_iterator const_iterator;
 
 private:
-    SizeType maxNumberOfElements_;
-    QueueType queue_;
-public:
-    CircularQueue(SizeType maxNumberOfElements) : maxNumberOfElements_(maxNumberOfElements) {};
+    std::vector<T> ring_;
+    SizeType first_;
+    SizeType size_;
+
+    SizeType slot(SizeType n) const { return (first_ + n) % ring_.size(); }
 
-    iterator erase(iterator position) { return queue_.erase(position); }
-    iterator erase(iterator first, iterator last) { return queue_.erase(first, last); }
-    void clear() {queue_.clear(); }
+public:
+    CircularQueue(SizeType maxNumberOfElements) : ring_(maxNumberOfElements), first_(0), size_(0) {};
 
-    SizeType size() const { return queue_.size(); }
-    bool empty() const {return queue_.empty(); }
+    void clear() { while(!empty()) pop_back(); }
 
-    void pop_front() { queue_.pop_front(); }
-    void pop_back() { queue_.pop_back(); }
+    SizeType size() const { return size_; }
+    bool empty() const {return size_ == 0; }
 
-    T& back() { return queue_.back(); }
-    const T& back() const {return queue_.back(); }
+    /* popped slots are reset, so that they don't hold on to anything */
+    void pop_front() { ring_[first_] = T(); first_ = slot(1); size_--; }
+    void pop_back() { ring_[slot(size_ - 1)] = T(); size_--; }
 
-    T& front() { return queue_.front(); }
-    const T& front() const {return queue_.front(); }
+    T& back() { return ring_[slot(size_ - 1)]; }
+    const T& back() const {return ring_[slot(size_ - 1)]; }
 
-    iterator begin() { return queue_.begin(); }
-    const_iterator begin() const { return queue_.begin(); }
-    iterator end() { return queue_.end(); }
-    const_iterator end() const { return queue_.end(); }
+    T& front() { return ring_[first_]; }
+    const T& front() const {return ring_[first_]; }
 
-    iterator rbegin() { return queue_.rbegin(); }
-    const_iterator rbegin() const { return queue_.rbegin(); }
-    iterator rend() { return queue_.rend(); }
-    const_iterator rend() const { return queue_.rend(); }
+    /* 0 is the front */
+    T& operator[](SizeType n) { return ring_[slot(n)]; }
+    const T& operator[](SizeType n) const { return ring_[slot(n)]; }
 
     void push_front(const T& x)
     {
-        if(size() >= maxNumberOfElements_)queue_.pop_back();
-        queue_.push_front(x);
+        if(ring_.empty())return;
+        if(size() >= ring_.size())pop_back();
+        first_ = slot(ring_.size() - 1);
+        ring_[first_] = x;
+        size_++;
     }
 
     void push_back(const T& x)
     {
-        if(size() >= maxNumberOfElements_)queue_.pop_front();
-        queue_.push_back(x);
+        if(ring_.empty())return;
+        if(size() >= ring_.size())pop_front();
+        ring_[slot(size_)] = x;
+        size_++;
     }
 };
 }
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2012, Jesper Derehag
+ * All rights reserved.
+
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of the <organization> nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL JESPER DEREHAG BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *
+ *      Least recently used cache, bounded by the total cost of its entries rather than by count.
+ *      The cost of an entry is whatever the caller says it is when inserting, typically its memory footprint.
+ *      Not thread safe.
+ */
+
+#ifndef LRUCACHE_H_
+#define LRUCACHE_H_
+
+#include <list>
+#include <map>
+#include <stddef.h>
+
+namespace Util
+{
+
+template <class K, class V>
+class LruCache
+{
+    typedef unsigned int SizeType;
+
+    class Entry
+    {
+    public:
+        K key;
+        V value;
+        size_t cost;
+        Entry(const K& k, const V& v, size_t c) : key(k), value(v), cost(c) {}
+    };
+
+    typedef typename std::list<Entry> EntryList;
+    typedef typename std::map<K, typename EntryList::iterator> EntryMap;
+
+private:
+    size_t maxCost_;
+    size_t cost_;
+    EntryList entries_; /* most recently used first */
+    EntryMap index_;
+
+public:
+    LruCache(size_t maxCost) : maxCost_(maxCost), cost_(0) {};
+
+    /* returns NULL on miss, a hit becomes the most recently used entry.
+     * The pointer stays valid until the entry is erased or evicted */
+    const V* find(const K& key)
+    {
+        typename EntryMap::iterator it = index_.find(key);
+        if(it == index_.end())return NULL;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return &it->second->value;
+    }
+
+    /* replaces any existing entry for key, returns the number of entries evicted to make room.
+     * If evictedKeys is given the keys of the evicted entries are appended to it */
+    SizeType insert(const K& key, const V& value, size_t cost, std::list<K>* evictedKeys = NULL)
+    {
+        SizeType evicted = 0;
+        erase(key);
+        if(cost > maxCost_)return 0;
+
+        while(cost_ + cost > maxCost_)
+        {
+            cost_ -= entries_.back().cost;
+            if(evictedKeys)evictedKeys->push_back(entries_.back().key);
+            index_.erase(entries_.back().key);
+            entries_.pop_back();
+            evicted++;
+        }
+
+        entries_.push_front(Entry(key, value, cost));
+        index_[key] = entries_.begin();
+        cost_ += cost;
+        return evicted;
+    }
+
+    bool erase(const K& key)
+    {
+        typename EntryMap::iterator it = index_.find(key);
+        if(it == index_.end())return false;
+        cost_ -= it->second->cost;
+        entries_.erase(it->second);
+        index_.erase(it);
+        return true;
+    }
+
+    void clear() { entries_.clear(); index_.clear(); cost_ = 0; }
+
+    SizeType size() const { return index_.size(); }
+    bool empty() const { return index_.empty(); }
+    size_t cost() const { return cost_; }
+    size_t maxCost() const { return maxCost_; }
+};
+
+}
+
+#endif /* LRUCACHE_H_ */
@@ -65,6 +65,8 @@ ifeq ($(AUDIO_DRIVER),alsa)
 	AUDIO_OBJECTS += AudioEndpoint-Alsa.o
 else ifeq ($(AUDIO_DRIVER),stub)
 	AUDIO_OBJECTS += AudioEndpoint-Stub.o
+else ifeq ($(AUDIO_DRIVER),file)
+	AUDIO_OBJECTS += AudioEndpoint-File.o
 else
 	error = $(shell echo No audio driver supplied AUDIO_DRIVER=$(AUDIO_DRIVER))
 endif
@@ -35,6 +35,10 @@
 #include "ClientHandler/ClientHandler.h"
 #include "Platform/AudioEndpoints/AudioEndpointLocal.h"
 #include "ConfigHandling/ConfigHandler.h"
+#include "Metrics/MetricsReporter.h"
+#include "Tracing/Tracer.h"
+#include "Tracing/FlightRecorder.h"
+#include "Tracing/Watchdog.h"
 #include "Platform/Utils/Utils.h"
 #include "TestApp/UIConsole.h"
 
@@ -79,6 +83,10 @@ int main(int argc, char *argv[])
     ch.parseConfigFile();
 
     Logger::Logger logger(ch.getLoggerConfig());
+    Tracing::Tracer::instance().enable(ch.getLoggerConfig().getTraceBufferSize(), ch.getLoggerConfig().getTraceFile());
+    Tracing::FlightRecorder::instance().enable(ch.getLoggerConfig().getFlightRecorderSize(),
+                                               ch.getLoggerConfig().getFlightRecorderFile(),
+                                               ch.getLoggerConfig().getMutexWaitThreshold());
 
     Platform::AudioEndpointLocal audioEndpoint(ch.getAudioEndpointConfig());
     ConfigHandling::SpotifyConfig spConfig = ch.getSpotifyConfig();
@@ -110,12 +118,17 @@ int main(int argc, char *argv[])
 
 	ClientHandler clienthandler(ch.getNetworkConfig(), libspotifyif);
 
+	Metrics::MetricsReporter metricsReporter(ch.getLoggerConfig().getMetricsLogInterval());
+	Tracing::Watchdog watchdog(libspotifyif.getHeartbeat(), ch.getLoggerConfig().getStallThreshold());
+
 	UIConsole ui( libspotifyif );
 	ui.joinThread();
 
 	libspotifyif.logOut();
 
 	/* cleanup */
+	watchdog.destroy();
+	metricsReporter.destroy();
 	libspotifyif.destroy();
 	clienthandler.destroy();
 	audioEndpoint.destroy();